@@ -0,0 +1,177 @@
+#ifndef HEIGHT_GRID_H
+#define HEIGHT_GRID_H
+
+#include <glad/glad.h>
+
+#include "shader_m.h"
+
+#include <vector>
+#include <cstddef>
+
+// A height field on a fixed rows x cols grid drawn from two vertex streams: the x, z of every vertex (location 0, a
+// vec2) uploaded once, and its height (location 1, one float) which is all setHeights() sends. Vertex (i, k) sits at
+// (xs[i], height, zs[k]) and is number i * cols + k, the same order the demos always built their positions in. Points
+// need no indices; the line and triangle index buffers are built the first time they're drawn and never change.
+// height_grid.vs puts the three together for points and lines.
+//
+// The surface is one triangle strip per pair of rows, joined by primitive restart. Its shader (height_surface.vs) gets
+// the normal from the neighbouring heights, which it reads out of the same height buffer through a buffer texture, so
+// lighting costs no extra upload. xs and zs are assumed evenly spaced for that.
+class HeightGrid
+{
+public:
+    HeightGrid(const std::vector<float> &xs, const std::vector<float> &zs) : r((int)xs.size()), c((int)zs.size())
+    {
+        spacingX = r > 1 ? (xs[r - 1] - xs[0]) / (r - 1) : 1.0f;
+        spacingZ = c > 1 ? (zs[c - 1] - zs[0]) / (c - 1) : 1.0f;
+        std::vector<float> xz;
+        xz.reserve(vertexCount() * 2);
+        for (int i = 0; i < r; i++)
+            for (int k = 0; k < c; k++)
+            {
+                xz.push_back(xs[i]);
+                xz.push_back(zs[k]);
+            }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &xzVBO);
+        glGenBuffers(1, &heightVBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, xzVBO);
+        glBufferData(GL_ARRAY_BUFFER, xz.size() * sizeof(float), xz.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, heightVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        glGenTextures(1, &heightTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, heightVBO);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    int rows() const { return r; }
+    int cols() const { return c; }
+    size_t vertexCount() const { return (size_t)r * c; }
+
+    // rows * cols heights in vertex order. The old store is orphaned rather than overwritten so the upload doesn't
+    // wait for draws still reading it
+    void setHeights(const float *heights)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, heightVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexCount() * sizeof(float), heights);
+        uploaded += vertexCount() * sizeof(float);
+    }
+
+    void DrawPoints()
+    {
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)vertexCount());
+    }
+
+    // every vertex joined to its neighbour in the next row and the next column
+    void DrawLines()
+    {
+        if (!lineEBO)
+        {
+            std::vector<unsigned int> indices;
+            indices.reserve(((size_t)(r - 1) * c + (size_t)r * (c - 1)) * 2);
+            for (int i = 0; i + 1 < r; i++)
+                for (int k = 0; k < c; k++)
+                {
+                    indices.push_back(vertex(i, k));
+                    indices.push_back(vertex(i + 1, k));
+                }
+            for (int i = 0; i < r; i++)
+                for (int k = 0; k + 1 < c; k++)
+                {
+                    indices.push_back(vertex(i, k));
+                    indices.push_back(vertex(i, k + 1));
+                }
+            lineIndices = buildIndices(lineEBO, indices);
+        }
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lineEBO);
+        glDrawElements(GL_LINES, (GLsizei)lineIndices, GL_UNSIGNED_INT, 0);
+    }
+
+    // lit triangles with surfaceShader (height_surface.vs and 2.2.basic_lighting.fs); the caller sets the matrices and
+    // the lighting uniforms. Takes texture unit 0
+    void DrawSurface(Shader &surfaceShader)
+    {
+        if (!surfaceEBO)
+        {
+            std::vector<unsigned int> indices;
+            indices.reserve((size_t)(r - 1) * (2 * c + 1));
+            for (int i = 0; i + 1 < r; i++)
+            {
+                for (int k = 0; k < c; k++)
+                {
+                    indices.push_back(vertex(i, k));
+                    indices.push_back(vertex(i + 1, k));
+                }
+                indices.push_back(RESTART);
+            }
+            surfaceIndices = buildIndices(surfaceEBO, indices);
+        }
+        surfaceShader.use();
+        surfaceShader.setInt("heights", 0);
+        surfaceShader.setInt("columns", c);
+        surfaceShader.setInt("rows", r);
+        surfaceShader.setVec2("spacing", spacingX, spacingZ);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, heightTexture);
+
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(RESTART);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surfaceEBO);
+        glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)surfaceIndices, GL_UNSIGNED_INT, 0);
+        glDisable(GL_PRIMITIVE_RESTART);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // bytes sent through setHeights() so far
+    size_t bytesUploaded() const { return uploaded; }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &xzVBO);
+        glDeleteBuffers(1, &heightVBO);
+        if (lineEBO)
+            glDeleteBuffers(1, &lineEBO);
+        if (surfaceEBO)
+            glDeleteBuffers(1, &surfaceEBO);
+        glDeleteTextures(1, &heightTexture);
+    }
+
+private:
+    enum : unsigned int { RESTART = 0xFFFFFFFFu }; // primitive restart index between strips
+
+    int r, c;
+    float spacingX, spacingZ;
+    unsigned int VAO = 0, xzVBO = 0, heightVBO = 0;
+    unsigned int heightTexture = 0; // heightVBO seen as a samplerBuffer
+    unsigned int lineEBO = 0, surfaceEBO = 0;
+    size_t lineIndices = 0, surfaceIndices = 0;
+    size_t uploaded = 0;
+
+    unsigned int vertex(int i, int k) const { return (unsigned int)(i * c + k); }
+
+    // the element buffer is bound through the VAO so it stays attached to it
+    size_t buildIndices(unsigned int &EBO, const std::vector<unsigned int> &indices)
+    {
+        glBindVertexArray(VAO);
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        return indices.size();
+    }
+};
+#endif
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec2 aXZ;      // static, uploaded once
+layout (location = 1) in float aHeight; // the only thing streamed per frame
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main() {
+    gl_Position = projection * view * vec4(aXZ.x, aHeight, aXZ.y, 1.0);
+    gl_PointSize = 1.0; // size of point
+}
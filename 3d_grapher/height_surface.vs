@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) in vec2 aXZ;
+layout (location = 1) in float aHeight;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform samplerBuffer heights; // the same heights as aHeight, to look up the neighbours
+uniform int rows;
+uniform int columns;
+uniform vec2 spacing;          // x between rows, z between columns
+
+uniform mat4 view;
+uniform mat4 projection;
+
+float heightAt(int i, int k) {
+    return texelFetch(heights, i * columns + k).r;
+}
+
+void main()
+{
+    // indexed draws give the vertex number here, row-major like the grid
+    int i = gl_VertexID / columns;
+    int k = gl_VertexID % columns;
+
+    // central differences, one-sided on the edges
+    int i0 = max(i - 1, 0), i1 = min(i + 1, rows - 1);
+    int k0 = max(k - 1, 0), k1 = min(k + 1, columns - 1);
+    float dhdx = (heightAt(i1, k) - heightAt(i0, k)) / (float(i1 - i0) * spacing.x);
+    float dhdz = (heightAt(i, k1) - heightAt(i, k0)) / (float(k1 - k0) * spacing.y);
+
+    FragPos = vec3(aXZ.x, aHeight, aXZ.y);
+    Normal = vec3(-dhdx, 1.0, -dhdz);
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -7,6 +7,7 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "height_grid.h"
 
 #include <iostream>
 #include <vector>
@@ -31,6 +32,9 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// M switches between the point cloud and the lit surface
+static bool drawSurface = false;
+
 // Function to plot: z = f(x, y)
 float functionToPlot(float x, float y) {
     // Try different functions!
@@ -47,25 +51,26 @@ float functionToPlot(float x, float y) {
      return sin(sqrt(x*x + y*y));  // Circular ripples
 }
 
-// Generate particle positions for the 3D plot
-void generatePlotParticles(std::vector<float>& positions, 
-                          float xMin, float xMax, 
-                          float yMin, float yMax,
-                          int xSamples, int ySamples) {
-    positions.clear();
+// Sample the function on the plot grid: xs and ys get the sample coordinates, heights the value at every (xs[i], ys[j])
+// in HeightGrid's vertex order
+void generatePlotHeights(std::vector<float>& xs, std::vector<float>& ys, std::vector<float>& heights,
+                         float xMin, float xMax,
+                         float yMin, float yMax,
+                         int xSamples, int ySamples) {
+    xs.resize(xSamples);
+    ys.resize(ySamples);
+    heights.clear();
     
     float xStep = (xMax - xMin) / (xSamples - 1);
     float yStep = (yMax - yMin) / (ySamples - 1);
+    for (int i = 0; i < xSamples; ++i)
+        xs[i] = xMin + i * xStep;
+    for (int j = 0; j < ySamples; ++j)
+        ys[j] = yMin + j * yStep;
     
     for (int i = 0; i < xSamples; ++i) {
         for (int j = 0; j < ySamples; ++j) {
-            float x = xMin + i * xStep;
-            float y = yMin + j * yStep;
-            float z = functionToPlot(x, y);
-            
-            positions.push_back(x);
-            positions.push_back(z);  // z is the "height"
-            positions.push_back(y);
+            heights.push_back(functionToPlot(xs[i], ys[j]));  // z is the "height"
         }
     }
 }
@@ -110,29 +115,21 @@ int main()
     glEnable(GL_PROGRAM_POINT_SIZE);  // Allow setting point size in shader
 
     // build and compile shaders
-    Shader particleShader("particle.vs", "particle.fs");
+    Shader particleShader("height_grid.vs", "particle.fs");
+    Shader surfaceShader("height_surface.vs", "2.2.basic_lighting.fs");
 
-    // Generate the particle positions for our function
-    std::vector<float> particlePositions;
+    // Sample the function
+    std::vector<float> xs, ys, heights;
     
     // Domain: x from -10 to 10, y from -10 to 10
-    // Samples: 100x100 = 10,000 particles
-    generatePlotParticles(particlePositions, -10.0f, 10.0f, -10.0f, 10.0f, 300, 300);
+    // Samples: 300x300 = 90,000 particles
+    generatePlotHeights(xs, ys, heights, -10.0f, 10.0f, -10.0f, 10.0f, 300, 300);
     
-    std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
-
-    // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
-
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, particlePositions.size() * sizeof(float), 
-                 particlePositions.data(), GL_STATIC_DRAW);
+    std::cout << "Generated " << heights.size() << " particles" << std::endl;
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // x and z as a vec2, the height as a single float (see height_grid.h)
+    HeightGrid plot(xs, ys);
+    plot.setHeights(heights.data());
 
     // render loop
     while (!glfwWindowShouldClose(window))
@@ -160,8 +157,18 @@ int main()
         particleShader.setMat4("projection", projection);
         particleShader.setMat4("view", view);
 
-        glBindVertexArray(particleVAO);
-        glDrawArrays(GL_POINTS, 0, particlePositions.size() / 3);
+        if (drawSurface) {
+            surfaceShader.use();
+            surfaceShader.setMat4("projection", projection);
+            surfaceShader.setMat4("view", view);
+            surfaceShader.setVec3("lightPos", 0.0f, 30.0f, 0.0f);
+            surfaceShader.setVec3("viewPos", camera.Position);
+            surfaceShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+            surfaceShader.setVec3("objectColor", 1.0f, 1.0f, 0.0f);
+            plot.DrawSurface(surfaceShader);
+        } else {
+            plot.DrawPoints();
+        }
 
         // glfw: swap buffers and poll IO events
         glfwSwapBuffers(window);
@@ -169,8 +176,7 @@ int main()
     }
 
     // cleanup
-    glDeleteVertexArrays(1, &particleVAO);
-    glDeleteBuffers(1, &particleVBO);
+    plot.Delete();
 
     glfwTerminate();
     return 0;
@@ -181,6 +187,12 @@ void processInput(GLFWwindow *window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    static bool mWasDown = false;
+    bool mDown = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+    if (mDown && !mWasDown)
+        drawSurface = !drawSurface;
+    mWasDown = mDown;
+
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
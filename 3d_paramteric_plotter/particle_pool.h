@@ -0,0 +1,145 @@
+#ifndef PARTICLE_POOL_H
+#define PARTICLE_POOL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Fixed capacity particle storage. The live particles are always packed at the front ([0, size())), so spawning
+// is a push onto the end of that range and killing moves the last live particle into the hole. Both are O(1) and
+// nothing ever scans for a free slot. Killing reorders particles, which none of the trails care about.
+template<class T>
+class ParticlePool
+{
+public:
+    explicit ParticlePool(size_t capacity) : particles(capacity), count(0) {}
+
+    // a fresh slot at the end of the live range, or nullptr when the pool is full
+    T* spawn()
+    {
+        if (count == particles.size())
+            return nullptr;
+        return &particles[count++];
+    }
+
+    // spawns up to 'amount' particles in one go, calling init(particle, k) for k = 0, 1, ...
+    // returns how many fitted
+    template<class F>
+    size_t spawn(size_t amount, F&& init)
+    {
+        size_t spawned = std::min(amount, particles.size() - count);
+        for (size_t k = 0; k < spawned; k++)
+            init(particles[count + k], k);
+        count += spawned;
+        return spawned;
+    }
+
+    void kill(size_t index)
+    {
+        particles[index] = particles[--count];
+    }
+
+    // calls step(particle) on every live particle and kills the ones it returns false for
+    template<class F>
+    void update(F&& step)
+    {
+        size_t i = 0;
+        while (i < count)
+        {
+            if (step(particles[i]))
+                i++;
+            else
+                kill(i); // the particle moved into slot i hasn't been stepped yet, so don't advance
+        }
+    }
+
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return particles.size(); }
+    bool full() const { return count == particles.size(); }
+
+    T& operator[](size_t index) { return particles[index]; }
+    T* data() { return particles.data(); }
+    // live particles only
+    T* begin() { return particles.data(); }
+    T* end() { return particles.data() + count; }
+
+private:
+    std::vector<T> particles;
+    size_t count;
+};
+
+// Eight independent xorshift32 generators stepped side by side. The lane loop has no dependencies between lanes,
+// so the compiler turns it into a couple of SIMD shifts and xors, and filling a batch of random numbers costs
+// far less than calling rand() once per number.
+class ParticleRandom
+{
+public:
+    static const int LANES = 8;
+
+    explicit ParticleRandom(uint64_t seed = 1)
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            // splitmix64 to spread one seed over the lanes, xorshift needs a non-zero state
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            state[l] = static_cast<uint32_t>(z ^ (z >> 31)) | 1u;
+        }
+        used = LANES;
+    }
+
+    // fills out[0 .. n) with uniform floats in [0, 1)
+    void uniform(float* out, size_t n)
+    {
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            step();
+            for (int l = 0; l < LANES; l++)
+                out[i + l] = (state[l] >> 8) * (1.0f / 16777216.0f);
+            used = LANES; // this block is spent, next() must not hand it out again
+        }
+        for (; i < n; i++)
+            out[i] = next();
+    }
+
+    // uniform floats in [lo, hi)
+    void uniform(float* out, size_t n, float lo, float hi)
+    {
+        uniform(out, n);
+        for (size_t i = 0; i < n; i++)
+            out[i] = lo + (hi - lo) * out[i];
+    }
+
+    // a single number, taken from the current block
+    float next()
+    {
+        if (used == LANES)
+        {
+            step();
+            used = 0;
+        }
+        return (state[used++] >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    alignas(32) uint32_t state[LANES];
+    int used;
+
+    void step()
+    {
+        for (int l = 0; l < LANES; l++)
+        {
+            uint32_t x = state[l];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state[l] = x;
+        }
+    }
+};
+#endif
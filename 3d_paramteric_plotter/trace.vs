@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in float aLife;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pointSize;
+
+out float Life;
+
+void main()
+{
+	Life = aLife;
+	gl_Position = projection * view * vec4(aPos, 1.0);
+	// only used when GL_PROGRAM_POINT_SIZE is on, glPointSize covers the rest
+	gl_PointSize = pointSize;
+}
@@ -0,0 +1,130 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <iostream>
+
+// every operator new in the program, only counted when one .cpp defines FRAME_ARENA_COUNT_HEAP before including
+// this header (the same way STB_IMAGE_IMPLEMENTATION works). Plain malloc calls, e.g. inside GLFW or the driver,
+// are not seen.
+inline std::atomic<size_t>& heapAllocationCounter()
+{
+    static std::atomic<size_t> allocations(0);
+    return allocations;
+}
+
+inline size_t heapAllocations() { return heapAllocationCounter().load(std::memory_order_relaxed); }
+
+#ifdef FRAME_ARENA_COUNT_HEAP
+void* operator new(std::size_t size)
+{
+    heapAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+// Linear allocator for things that only live for one frame. One block is allocated up front, allocate() bumps an
+// offset into it and beginFrame() rewinds the offset, so nothing is ever freed one by one. If a frame needs more than
+// the block it falls back to the heap (and shows up in the allocation count); size the arena from highWater().
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t capacity) : block(static_cast<unsigned char*>(std::malloc(capacity))), cap(capacity) {}
+
+    ~FrameArena()
+    {
+        releaseOverflow();
+        std::free(block);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t))
+    {
+        size_t start = (offset + align - 1) & ~(align - 1);
+        if (start + bytes <= cap)
+        {
+            offset = start + bytes;
+            if (offset > high)
+                high = offset;
+            return block + start;
+        }
+        if (overflow.empty())
+            std::cout << "ERROR::FRAME_ARENA:: out of space (" << cap << " bytes), falling back to the heap" << std::endl;
+        void* p = ::operator new(bytes + align);
+        overflow.push_back(p);
+        return reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(p) + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    template<class T>
+    T* allocate(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T))); }
+
+    // call at the top of the frame: drops everything from the last one and counts its heap allocations
+    void beginFrame()
+    {
+        size_t now = heapAllocations();
+        lastFrameHeap = now - frameStartHeap;
+        frameStartHeap = now;
+        releaseOverflow();
+        offset = 0;
+    }
+
+    // operator new calls made between the last two beginFrame()s, 0 unless FRAME_ARENA_COUNT_HEAP is defined
+    size_t heapAllocationsLastFrame() const { return lastFrameHeap; }
+    size_t used() const { return offset; }
+    size_t highWater() const { return high; }
+    size_t capacity() const { return cap; }
+
+private:
+    unsigned char* block;
+    size_t cap;
+    size_t offset = 0;
+    size_t high = 0;
+    size_t frameStartHeap = 0;
+    size_t lastFrameHeap = 0;
+    std::vector<void*> overflow;
+
+    void releaseOverflow()
+    {
+        for (void* p : overflow)
+            ::operator delete(p);
+        overflow.clear();
+    }
+};
+
+// lets STL containers take their storage from a FrameArena. deallocate is a no-op, the memory comes back at the
+// next beginFrame(), so a container using it must not outlive the frame
+template<class T>
+struct ArenaAllocator
+{
+    typedef T value_type;
+
+    FrameArena* arena;
+
+    explicit ArenaAllocator(FrameArena &arena) : arena(&arena) {}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return arena->allocate<T>(n); }
+    void deallocate(T*, size_t) {}
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template<class U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+// a vector that lives in the frame arena
+template<class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+#endif
@@ -10,8 +10,12 @@
 #include "shader_m.h"
 #include "camera.h"
 #include "model.h"
+#define FRAME_ARENA_COUNT_HEAP
+#include "frame_arena.h"
 
 #include <iostream>
+#include <algorithm>
+#include <utility>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
@@ -226,6 +230,10 @@ int main()
     shader.use();
     shader.setInt("texture1", 0);
 
+    // per-frame temporaries come from here, reset at the top of every frame
+    FrameArena frameArena(64 * 1024);
+    unsigned int frameCount = 0;
+
 
 
 
@@ -244,13 +252,22 @@ int main()
         // -----
         processInput(window);
 
-        // sort the transparent windows before rendering
-        std::map<float, glm::vec3> sorted;
+        frameArena.beginFrame();
+        if (++frameCount % 600 == 0)
+            std::cout << "heap allocations last frame: " << frameArena.heapAllocationsLastFrame()
+                      << ", frame arena high water: " << frameArena.highWater() << " bytes" << std::endl;
+
+        // sort the transparent windows far to near before rendering. a vector rather than a map keyed on distance,
+        // so two windows at the same distance don't overwrite each other
+        typedef std::pair<float, glm::vec3> SortedWindow;
+        FrameVector<SortedWindow> sorted{ArenaAllocator<SortedWindow>(frameArena)};
+        sorted.reserve(windows.size());
         for (unsigned int i=0; i<windows.size(); i++)
         {
             float distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
+            sorted.push_back(SortedWindow(distance, windows[i]));
         }
+        std::sort(sorted.begin(), sorted.end(), [](const SortedWindow &a, const SortedWindow &b) { return a.first > b.first; });
 
         // render
         // ------
@@ -289,10 +306,10 @@ int main()
         //windows
         glBindVertexArray(transparentVAO);
         glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+        for (const SortedWindow &pane : sorted)
         {
             model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
+            model = glm::translate(model, pane.second);
             shader.setMat4("model", model);
             glDrawArrays(GL_TRIANGLES, 0, 6);
         }
@@ -0,0 +1,206 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "shader_m.h"
+#include "thread_pool.h"
+#include "pendulum_grid.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void processInput(GLFWwindow *window);
+
+// settings
+const unsigned int SCR_WIDTH = 1024;
+const unsigned int SCR_HEIGHT = 1024;
+
+// map
+int mapSize = 1024;              // cells along each side
+float simSeconds = 20.0f;        // how long every pendulum gets to flip
+const float DT = 0.01f;          // RK4 step
+const float SECONDS_PER_FRAME = 0.25f; // sim time added to the whole grid between texture uploads
+const char* outPath = nullptr;   // headless: write the finished map here as a .ppm
+
+// width * height rgb rows bottom first, the way writeImage leaves them, flipped to top first for the file
+bool writePPM(const char* path, const std::vector<unsigned char> &rgb, int width, int height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::CHAOS_MAP::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (int row = height - 1; row >= 0; row--)
+        file.write(reinterpret_cast<const char*>(&rgb[(size_t)row * width * 3]), (std::streamsize)width * 3);
+    return true;
+}
+
+// usage: chaos_map [size] [--seconds T] [--out map.ppm]
+// with --out it runs without a window, writes the image and exits; otherwise the map fills in on screen as it runs
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            simSeconds = (float)std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else
+            mapSize = std::max(8, std::atoi(argv[i]));
+    }
+
+    ThreadPool pool;
+    PendulumGrid grid(mapSize, mapSize);
+    std::vector<unsigned char> image((size_t)mapSize * mapSize * 3);
+    std::cout << "Flip map " << mapSize << "x" << mapSize << ", " << simSeconds << "s of sim time, "
+              << pool.size() << " threads" << std::endl;
+
+    long long pendulumSteps = 0;
+    double computeSeconds = 0.0;
+    auto advance = [&](float duration) {
+        auto start = std::chrono::steady_clock::now();
+        pendulumSteps += grid.advance(duration, DT, &pool);
+        computeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto report = [&]() {
+        std::cout << "t = " << grid.time() << "s: " << pendulumSteps << " pendulum steps in " << computeSeconds
+                  << "s, " << pendulumSteps / std::max(computeSeconds, 1e-9) / 1e6 << "M steps/s" << std::endl;
+    };
+
+    if (outPath)
+    {
+        while (grid.time() < simSeconds - DT / 2)
+            advance(std::min(SECONDS_PER_FRAME * 4.0f, simSeconds - grid.time()));
+        report();
+        grid.writeImage(image.data(), simSeconds);
+        return writePPM(outPath, image, mapSize, mapSize) ? 0 : -1;
+    }
+
+    // glfw: initialize and configure
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // glfw window creation
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Double Pendulum Flip Map", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    // glad: load all OpenGL function pointers
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Shader mapShader("chaos_map.vs", "chaos_map.fs");
+
+    // one quad over the whole window
+    float quad[] = {
+        // positions   // texture coords
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f,
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f,
+        -1.0f,  1.0f,  0.0f, 1.0f
+    };
+    unsigned int quadVAO, quadVBO;
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // the map texture, allocated once and overwritten in place every frame the grid moves
+    unsigned int mapTexture;
+    glGenTextures(1, &mapTexture);
+    glBindTexture(GL_TEXTURE_2D, mapTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of 3 * mapSize bytes aren't always 4 byte aligned
+    grid.writeImage(image.data(), simSeconds);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, mapSize, mapSize, 0, GL_RGB, GL_UNSIGNED_BYTE, image.data());
+
+    mapShader.use();
+    mapShader.setInt("flipMap", 0);
+
+    bool finished = false;
+    while (!glfwWindowShouldClose(window))
+    {
+        processInput(window);
+
+        // R starts the map over, once per press
+        static bool rWasDown = false;
+        bool rDown = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+        if (rDown && !rWasDown && grid.time() > 0.0f)
+        {
+            grid.reset();
+            pendulumSteps = 0;
+            computeSeconds = 0.0;
+            finished = false;
+        }
+        rWasDown = rDown;
+
+        if (grid.time() < simSeconds - DT / 2)
+        {
+            advance(std::min(SECONDS_PER_FRAME, simSeconds - grid.time()));
+            grid.writeImage(image.data(), simSeconds);
+            glBindTexture(GL_TEXTURE_2D, mapTexture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mapSize, mapSize, GL_RGB, GL_UNSIGNED_BYTE, image.data());
+        }
+        else if (!finished)
+        {
+            report();
+            finished = true;
+        }
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        mapShader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mapTexture);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteTextures(1, &mapTexture);
+    glfwTerminate();
+    return 0;
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
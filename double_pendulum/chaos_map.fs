@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D flipMap;
+
+void main()
+{
+	FragColor = texture(flipMap, TexCoord);
+}
@@ -7,10 +7,16 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "trace_renderer.h"
+#include "ode.h"
+#include "sim_runner.h"
+#include "sim_record.h"
 
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstring>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -41,6 +47,22 @@ bool tKeyPressed = false;
 float theta1, theta1_dot;
 float theta2, theta2_dot;
 
+// what the sim thread owns. The solver takes whatever steps its error control allows and 'state' (theta1, theta2,
+// theta1_dot, theta2_dot) is read off its dense output at every fixed sim tick
+struct PendulumModel {
+    DormandPrince<glm::dvec4, double> solver;
+    double simTime;
+    glm::dvec4 state;
+};
+const double SIM_STEP = 1.0 / 500.0;
+
+// --play: a pendulum_cli recording drives the angles instead of the sim. Left/right arrows scrub, space pauses and
+// R goes back to the start
+SimRecordReader recording;
+bool playing = false;
+bool playPaused = false;
+double playTime = 0.0;
+
 // System parameters
 float m1 = 1.0f, m2 = 1.0f;  // masses
 float L1 = 1.5f, L2 = 1.5f;  // lengths
@@ -60,8 +82,8 @@ struct TraceParticle {
 };
 
 const int MAX_TRACE_PARTICLES = 500;
-std::vector<TraceParticle> traceParticles1(MAX_TRACE_PARTICLES); // Red trail for first pendulum
-std::vector<TraceParticle> traceParticles2(MAX_TRACE_PARTICLES); // Blue trail for second pendulum
+ParticlePool<TraceParticle> traceParticles1(MAX_TRACE_PARTICLES); // Red trail for first pendulum
+ParticlePool<TraceParticle> traceParticles2(MAX_TRACE_PARTICLES); // Blue trail for second pendulum
 float traceLifeTime = 2.0f;
 int traceSpawnRate = 60; // particles per second
 static float timeSinceLastSpawn = 0.0f;
@@ -125,60 +147,94 @@ void generateRopeLine(glm::vec3 start, glm::vec3 end, std::vector<float>& lineVe
     lineVertices.push_back(end.z);
 }
 
-void updatePhysics(float deltaTime) {
-    // Cap deltaTime to prevent huge timesteps when framerate drops
-    deltaTime = std::min(deltaTime, 0.016f);
-    
-    // Use small fixed timesteps for numerical stability
-    const float dt = 0.001f;
-    int substeps = std::max(1, (int)(deltaTime / dt));
-    float actual_dt = deltaTime / substeps;
-    
-    for (int step = 0; step < substeps; step++) {
-        // Lagrangian-derived double pendulum equations
-        float delta = theta2 - theta1;
-        float cos_delta = cos(delta);
-        float sin_delta = sin(delta);
-        
-        // Denominators from Lagrangian derivation
-        float den1 = (m1 + m2) * L1 - m2 * L1 * cos_delta * cos_delta;
-        float den2 = (L2 / L1) * den1;
-        
-        // Check for singularities (very rare but possible)
-        if (abs(den1) < 1e-12f) {
-            continue; // Skip this timestep
-        }
-        
-        // First pendulum angular acceleration (from Lagrangian)
-        float num1 = -m2 * L1 * theta1_dot * theta1_dot * sin_delta * cos_delta;
-        num1 += m2 * g * sin(theta2) * cos_delta;
-        num1 += m2 * L2 * theta2_dot * theta2_dot * sin_delta;
-        num1 -= (m1 + m2) * g * sin(theta1);
-        
-        // Second pendulum angular acceleration (from Lagrangian)
-        float num2 = -m2 * L2 * theta2_dot * theta2_dot * sin_delta * cos_delta;
-        num2 += (m1 + m2) * g * sin(theta1) * cos_delta;
-        num2 += (m1 + m2) * L1 * theta1_dot * theta1_dot * sin_delta;
-        num2 -= (m1 + m2) * g * sin(theta2);
-        
-        float theta1_ddot = num1 / den1;
-        float theta2_ddot = num2 / den2;
-        
-        // Pure Euler integration - no damping, no artificial limits
-        theta1_dot += theta1_ddot * actual_dt;
-        theta2_dot += theta2_ddot * actual_dt;
-        theta1 += theta1_dot * actual_dt;
-        theta2 += theta2_dot * actual_dt;
-    }
-    
+// Lagrangian-derived double pendulum equations
+glm::dvec4 pendulumDerivatives(const glm::dvec4& state) {
+    double t1 = state.x, t2 = state.y, w1 = state.z, w2 = state.w;
+    double delta = t2 - t1;
+    double cos_delta = cos(delta);
+    double sin_delta = sin(delta);
+
+    // Denominators from Lagrangian derivation, never zero while m1 > 0
+    double den1 = (m1 + m2) * L1 - m2 * L1 * cos_delta * cos_delta;
+    double den2 = (L2 / L1) * den1;
+
+    // First pendulum angular acceleration (from Lagrangian)
+    double num1 = -m2 * L1 * w1 * w1 * sin_delta * cos_delta;
+    num1 += m2 * g * sin(t2) * cos_delta;
+    num1 += m2 * L2 * w2 * w2 * sin_delta;
+    num1 -= (m1 + m2) * g * sin(t1);
+
+    // Second pendulum angular acceleration (from Lagrangian)
+    double num2 = -m2 * L2 * w2 * w2 * sin_delta * cos_delta;
+    num2 += (m1 + m2) * g * sin(t1) * cos_delta;
+    num2 += (m1 + m2) * L1 * w1 * w1 * sin_delta;
+    num2 -= (m1 + m2) * g * sin(t2);
+
+    return glm::dvec4(w1, w2, num1 / den1, num2 / den2);
+}
+
+SimRunner<PendulumModel> sim(PendulumModel{ DormandPrince<glm::dvec4, double>(glm::dvec4(0.0), 1e-8, 1e-8), 0.0,
+                                           glm::dvec4(0.0) },
+                             SIM_STEP, [](PendulumModel& model) {
+    model.simTime += SIM_STEP;
+    model.solver.advanceTo(pendulumDerivatives, model.simTime);
+    model.state = model.solver.sample(model.simTime);
+});
+
+// restarts the sim from the current globals, after anything sets them directly
+void resetPendulumSolver() {
+    glm::dvec4 start(theta1, theta2, theta1_dot, theta2_dot);
+    sim.post([start](PendulumModel& model) {
+        model.solver.reset(start, model.simTime);
+        model.state = start;
+    });
+}
+
+// the angles one sim step behind, blended between the last two the sim thread published
+void updatePhysics() {
+    const SimSnapshot<PendulumModel>& snapshot = sim.latest();
+    glm::dvec4 state = glm::mix(snapshot.previous.state, snapshot.current.state, sim.alpha());
+    theta1 = (float)state.x;
+    theta2 = (float)state.y;
+    theta1_dot = (float)state.z;
+    theta2_dot = (float)state.w;
+
     // Update positions
     pos1 = anchorPoint + glm::vec3(L1 * sin(theta1), -L1 * cos(theta1), 0.0f);
     pos2 = pos1 + glm::vec3(L2 * sin(theta2), -L2 * cos(theta2), 0.0f);
 }
 
-int main()
+// the angles at playTime, blended between the two recorded frames either side
+void updateFromRecording() {
+    if (!playPaused)
+        playTime += deltaTime;
+    playTime = std::min(std::max(playTime, 0.0), recording.duration());
+    double position = playTime / recording.header().frameDt;
+    uint64_t frame = std::min((uint64_t)position, recording.frameCount() - 1);
+    const float* a = recording.frame(frame);
+    const float* b = recording.frame(std::min(frame + 1, recording.frameCount() - 1));
+    float blend = (float)(position - frame);
+    theta1 = glm::mix(a[0], b[0], blend);
+    theta2 = glm::mix(a[1], b[1], blend);
+    theta1_dot = glm::mix(a[2], b[2], blend);
+    theta2_dot = glm::mix(a[3], b[3], blend);
+
+    pos1 = anchorPoint + glm::vec3(L1 * sin(theta1), -L1 * cos(theta1), 0.0f);
+    pos2 = pos1 + glm::vec3(L2 * sin(theta2), -L2 * cos(theta2), 0.0f);
+}
+
+int main(int argc, char** argv)
 {
     std::cout << "Starting Double Pendulum..." << std::endl;
+    if (argc == 3 && std::strcmp(argv[1], "--play") == 0)
+    {
+        if (!recording.open(argv[2]) || recording.frameFloats() != 4 || recording.frameCount() == 0)
+        {
+            std::cout << "ERROR::PLAYBACK::NOT_A_DOUBLE_PENDULUM_RECORDING " << argv[2] << std::endl;
+            return -1;
+        }
+        playing = true;
+    }
     
     // GLFW initialization
     glfwInit();
@@ -208,6 +264,7 @@ int main()
     // Shaders
     Shader lightingShader("2.2.basic_lighting.vs", "2.2.basic_lighting.fs");
     Shader lightCubeShader("2.2.light_cube.vs", "2.2.light_cube.fs");
+    Shader traceShader("trace.vs", "trace.fs");
 
     // Generate sphere geometry
     std::vector<float> sphereVertices;
@@ -246,23 +303,18 @@ int main()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Setup particle trail VAO
-    unsigned int traceVAO, traceVBO;
-    glGenVertexArrays(1, &traceVAO);
-    glGenBuffers(1, &traceVBO);
-
-    glBindVertexArray(traceVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_TRACE_PARTICLES * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // Setup particle trails, one renderer (and buffer) per trail
+    TraceRenderer<TraceParticle> traceRenderer1(MAX_TRACE_PARTICLES);
+    TraceRenderer<TraceParticle> traceRenderer2(MAX_TRACE_PARTICLES);
 
     // Initialize double pendulum
     theta1 = M_PI/3.0f;    // 60 degrees from vertical
     theta2 = M_PI/2.0f;    // 90 degrees from vertical
     theta1_dot = 0.0f;
     theta2_dot = 0.0f;
+    resetPendulumSolver();
+    if (!playing)
+        sim.start();
 
     // Calculate initial positions
     pos1 = anchorPoint + glm::vec3(L1 * sin(theta1), -L1 * cos(theta1), 0);
@@ -283,49 +335,49 @@ int main()
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Update physics
-        updatePhysics(deltaTime);
+        // Physics runs on the sim thread, this just picks up where it's got to
+        if (playing)
+            updateFromRecording();
+        else
+        {
+            updatePhysics();
+            sim.recordFrame(deltaTime);
+        }
 
         // Update particle trails
         timeSinceLastSpawn += deltaTime;
         if (timeSinceLastSpawn >= 1.0f / traceSpawnRate) {
             // Spawn red particle for first pendulum
-            for (auto& particle : traceParticles1) {
-                if (particle.life <= 0.0f) {
-                    particle.position = pos1;
-                    particle.life = 1.0f;
-                    particle.color = glm::vec3(1.0f, 0.0f, 0.0f); // Red
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles1.spawn()) {
+                particle->position = pos1;
+                particle->life = 1.0f;
+                particle->color = glm::vec3(1.0f, 0.0f, 0.0f); // Red
             }
             // Spawn blue particle for second pendulum  
-            for (auto& particle : traceParticles2) {
-                if (particle.life <= 0.0f) {
-                    particle.position = pos2;
-                    particle.life = 1.0f;
-                    particle.color = glm::vec3(0.0f, 0.0f, 1.0f); // Blue
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles2.spawn()) {
+                particle->position = pos2;
+                particle->life = 1.0f;
+                particle->color = glm::vec3(0.0f, 0.0f, 1.0f); // Blue
             }
             timeSinceLastSpawn = 0.0f;
         }
 
         // Update particle lifetimes
-        for (auto& particle : traceParticles1) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime / traceLifeTime;
-            }
-        }
-        for (auto& particle : traceParticles2) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime / traceLifeTime;
-            }
-        }
+        traceParticles1.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime / traceLifeTime;
+            return particle.life > 0.0f;
+        });
+        traceParticles2.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime / traceLifeTime;
+            return particle.life > 0.0f;
+        });
 
         // Debug output every 2 seconds
         if (frame_counter++ % 120 == 0) {
             std::cout << "Angles: theta1=" << theta1*180.0f/M_PI << "° theta2=" << theta2*180.0f/M_PI << "°" << std::endl;
             std::cout << "Pos1: (" << pos1.x << ", " << pos1.y << ") Pos2: (" << pos2.x << ", " << pos2.y << ")" << std::endl;
+            if (frame_counter % 1200 == 1 && !playing)
+                sim.report();
         }
 
         // Setup matrices
@@ -378,41 +430,12 @@ int main()
                      ropeVertices.data(), GL_DYNAMIC_DRAW);
         glDrawArrays(GL_LINES, 0, 2);
 
-        // Render particle trails
-        lightCubeShader.use();
-        lightCubeShader.setMat4("projection", projection);
-        lightCubeShader.setMat4("view", view);
-        lightCubeShader.setMat4("model", glm::mat4(1.0f));
-
-        // Render red trail particles for first pendulum
-        for (auto& particle : traceParticles1) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // Fade out as life decreases
-                lightCubeShader.setVec3("color", intensity, 0.0f, 0.0f); // Red with fading
-
-                glBindVertexArray(traceVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(4.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-            }
-        }
-
-        // Render blue trail particles for second pendulum
-        for (auto& particle : traceParticles2) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // Fade out as life decreases
-                lightCubeShader.setVec3("color", 0.0f, 0.0f, intensity); // Blue with fading
-
-                glBindVertexArray(traceVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(4.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-            }
-        }
+        // Render particle trails, each one a single draw
+        traceShader.use();
+        traceShader.setMat4("projection", projection);
+        traceShader.setMat4("view", view);
+        traceRenderer1.Draw(traceShader, traceParticles1, glm::vec3(1.0f, 0.0f, 0.0f), 4.0f); // red
+        traceRenderer2.Draw(traceShader, traceParticles2, glm::vec3(0.0f, 0.0f, 1.0f), 4.0f); // blue
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -420,11 +443,17 @@ int main()
 
     glDeleteVertexArrays(1, &sphereVAO);
     glDeleteVertexArrays(1, &ropeVAO);
-    glDeleteVertexArrays(1, &traceVAO);
     glDeleteBuffers(1, &sphereVBO);
     glDeleteBuffers(1, &sphereEBO);
     glDeleteBuffers(1, &ropeVBO);
-    glDeleteBuffers(1, &traceVBO);
+    traceRenderer1.Delete();
+    traceRenderer2.Delete();
+    if (!playing)
+    {
+        sim.stop();
+        sim.report();
+    }
+    recording.close();
 
     glfwTerminate();
     return 0;
@@ -468,14 +497,12 @@ void processInput(GLFWwindow *window)
         theta2 = M_PI/2.0f;    // 90 degrees
         theta1_dot = 0.0f;
         theta2_dot = 0.0f;
+        resetPendulumSolver();
+        playTime = 0.0;
         
         // Clear particle trails
-        for (auto& particle : traceParticles1) {
-            particle.life = 0.0f;
-        }
-        for (auto& particle : traceParticles2) {
-            particle.life = 0.0f;
-        }
+        traceParticles1.clear();
+        traceParticles2.clear();
         
         std::cout << "Reset pendulum!" << std::endl;
         rKeyPressed = true;
@@ -484,6 +511,20 @@ void processInput(GLFWwindow *window)
     {
         rKeyPressed = false;
     }
+
+    if (playing)
+    {
+        // scrubbing covers 10 seconds of sim time per second held
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+            playTime -= 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+            playTime += 10.0 * deltaTime;
+        static bool spaceWasDown = false;
+        bool spaceDown = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        if (spaceDown && !spaceWasDown)
+            playPaused = !playPaused;
+        spaceWasDown = spaceDown;
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
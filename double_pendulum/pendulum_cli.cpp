@@ -0,0 +1,90 @@
+// The double pendulum without a window: integrates for a given stretch of sim time as fast as the CPU goes and
+// streams (theta1, theta2, theta1_dot, theta2_dot) every --frame-dt to a sim_record.h file that main --play can
+// scrub through.
+//
+//   g++ -O2 -std=c++17 -I.. pendulum_cli.cpp -o pendulum_cli
+//   ./pendulum_cli --out pendulum.rec --seconds 3600
+//
+// Same equations and DormandPrince tolerance as main.cpp. Model parameters in the header: m1, m2, L1, L2, g,
+// theta1 and theta2 at the start, tolerance.
+
+#include <glm/glm.hpp>
+
+#include "ode.h"
+#include "pendulum_grid.h"
+#include "sim_record.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* outPath = nullptr;
+    double seconds = 60.0;
+    double frameDt = 1.0 / 500.0;
+    double tolerance = 1e-8;
+    PendulumParams params;
+    params.L1 = params.L2 = 1.5f;
+    double theta1 = M_PI / 3.0, theta2 = M_PI / 2.0;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--frame-dt") == 0 && hasValue)
+            frameDt = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--tol") == 0 && hasValue)
+            tolerance = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--theta1") == 0 && hasValue)
+            theta1 = std::atof(argv[++i]) * M_PI / 180.0;
+        else if (std::strcmp(argv[i], "--theta2") == 0 && hasValue)
+            theta2 = std::atof(argv[++i]) * M_PI / 180.0;
+        else
+        {
+            std::cerr << "usage: pendulum_cli --out file|- [--seconds T] [--frame-dt dt] [--tol tol]"
+                      << " [--theta1 degrees] [--theta2 degrees]" << std::endl;
+            return -1;
+        }
+    }
+    if (!outPath)
+    {
+        std::cerr << "ERROR::PENDULUM_CLI:: --out is required" << std::endl;
+        return -1;
+    }
+
+    uint64_t frames = (uint64_t)std::llround(seconds / frameDt) + 1;
+    SimRecordWriter writer;
+    if (!writer.open(outPath, "double_pendulum", 4, frameDt,
+                     { params.m1, params.m2, params.L1, params.L2, params.g, theta1, theta2, tolerance }))
+        return -1;
+
+    const PendulumConstants<double> k(params);
+    auto derivatives = [&](const glm::dvec4& s) {
+        double a1, a2;
+        pendulumAccelerations(s.x, s.y, s.z, s.w, k, a1, a2);
+        return glm::dvec4(s.z, s.w, a1, a2);
+    };
+    DormandPrince<glm::dvec4, double> solver(glm::dvec4(theta1, theta2, 0.0, 0.0), tolerance, tolerance);
+
+    auto start = std::chrono::steady_clock::now();
+    double next = 0.0;
+    bool ok = true;
+    odeSampleEvery(solver, derivatives, next, frameDt, (frames - 0.5) * frameDt, [&](double, const glm::dvec4& s) {
+        float frame[4] = { (float)s.x, (float)s.y, (float)s.z, (float)s.w };
+        ok = ok && writer.write(frame);
+    }, (int)std::min<uint64_t>(frames, 0x7FFFFFFF));
+    writer.close();
+    if (!ok)
+        return -1;
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << writer.frameCount() << " frames, " << seconds << "s of sim time in " << wall << "s ("
+              << seconds / wall << "x real time), " << solver.stats.evaluations << " evaluations, "
+              << writer.bytesWritten() / 1e6 << " MB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,345 @@
+#ifndef PENDULUM_GRID_H
+#define PENDULUM_GRID_H
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PENDULUM_GRID_AVX2 1
+#endif
+
+struct PendulumParams {
+    float m1 = 1.0f, m2 = 1.0f;
+    float L1 = 1.0f, L2 = 1.0f;
+    float g = 9.81f;
+};
+
+// the products of PendulumParams the equations of motion use, as T so the same kernel runs on float, double and Lanes8
+template<class T>
+struct PendulumConstants {
+    T massL1, m2L1, m2g, m2L2, massG, lengthRatio;
+    explicit PendulumConstants(const PendulumParams &p)
+        : massL1((p.m1 + p.m2) * p.L1), m2L1(p.m2 * p.L1), m2g(p.m2 * p.g), m2L2(p.m2 * p.L2),
+          massG((p.m1 + p.m2) * p.g), lengthRatio(p.L2 / p.L1) {}
+};
+
+inline void pendulumSinCos(float x, float &s, float &c)
+{
+    s = std::sin(x);
+    c = std::cos(x);
+}
+
+inline void pendulumSinCos(double x, double &s, double &c)
+{
+    s = std::sin(x);
+    c = std::cos(x);
+}
+
+// the same Lagrangian equations as updatePhysics in main.cpp, with sin/cos of the angle difference built from the
+// two angles' own so each evaluation costs two sincos instead of four
+template<class T>
+inline void pendulumAccelerations(const T &t1, const T &t2, const T &w1, const T &w2, const PendulumConstants<T> &k,
+                                  T &a1, T &a2)
+{
+    T s1, c1, s2, c2;
+    pendulumSinCos(t1, s1, c1);
+    pendulumSinCos(t2, s2, c2);
+    T sd = s2 * c1 - c2 * s1, cd = c2 * c1 + s2 * s1;
+    T w1sq = w1 * w1, w2sq = w2 * w2;
+    T den1 = k.massL1 - k.m2L1 * cd * cd;
+    T num1 = k.m2g * s2 * cd + k.m2L2 * w2sq * sd - k.m2L1 * w1sq * sd * cd - k.massG * s1;
+    T num2 = k.massG * s1 * cd + k.massL1 * w1sq * sd - k.m2L2 * w2sq * sd * cd - k.massG * s2;
+    a1 = num1 / den1;
+    a2 = num2 / (k.lengthRatio * den1);
+}
+
+template<class T>
+inline void pendulumRk4(T &t1, T &t2, T &w1, T &w2, const PendulumConstants<T> &k, const T &h)
+{
+    const T halfH = h * T(0.5f);
+    T a1, a2, b1, b2, c1, c2, d1, d2;
+    pendulumAccelerations(t1, t2, w1, w2, k, a1, a2);
+    T t1b = t1 + halfH * w1, t2b = t2 + halfH * w2, w1b = w1 + halfH * a1, w2b = w2 + halfH * a2;
+    pendulumAccelerations(t1b, t2b, w1b, w2b, k, b1, b2);
+    T t1c = t1 + halfH * w1b, t2c = t2 + halfH * w2b, w1c = w1 + halfH * b1, w2c = w2 + halfH * b2;
+    pendulumAccelerations(t1c, t2c, w1c, w2c, k, c1, c2);
+    T t1d = t1 + h * w1c, t2d = t2 + h * w2c, w1d = w1 + h * c1, w2d = w2 + h * c2;
+    pendulumAccelerations(t1d, t2d, w1d, w2d, k, d1, d2);
+    const T sixthH = h * T(1.0f / 6.0f), two = T(2.0f);
+    t1 = t1 + sixthH * (w1 + two * (w1b + w1c) + w1d);
+    t2 = t2 + sixthH * (w2 + two * (w2b + w2c) + w2d);
+    w1 = w1 + sixthH * (a1 + two * (b1 + c1) + d1);
+    w2 = w2 + sixthH * (a2 + two * (b2 + c2) + d2);
+}
+
+#ifdef PENDULUM_GRID_AVX2
+// eight floats in an AVX register with the operators pendulumRk4 needs
+struct Lanes8 {
+    __m256 v;
+    Lanes8() {}
+    Lanes8(__m256 v) : v(v) {}
+    explicit Lanes8(float f) : v(_mm256_set1_ps(f)) {}
+};
+inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return _mm256_add_ps(a.v, b.v); }
+inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return _mm256_sub_ps(a.v, b.v); }
+inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return _mm256_mul_ps(a.v, b.v); }
+inline Lanes8 operator/(Lanes8 a, Lanes8 b) { return _mm256_div_ps(a.v, b.v); }
+
+// reduces to [-pi/4, pi/4] around the nearest multiple of pi/2 and evaluates the cephes polynomials there, good to
+// a couple of ulp for the angles a pendulum gets to
+inline void pendulumSinCos(Lanes8 x, Lanes8 &s, Lanes8 &c)
+{
+    __m256 q = _mm256_round_ps(_mm256_mul_ps(x.v, _mm256_set1_ps(0.636619772f)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    // pi/2 split in three so q * part stays exact
+    __m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(1.5703125f), x.v);
+    r = _mm256_fnmadd_ps(q, _mm256_set1_ps(4.837512969970703125e-4f), r);
+    r = _mm256_fnmadd_ps(q, _mm256_set1_ps(7.54978995489188216e-8f), r);
+    __m256 r2 = _mm256_mul_ps(r, r);
+
+    __m256 ps = _mm256_fmadd_ps(_mm256_set1_ps(-1.9515295891e-4f), r2, _mm256_set1_ps(8.3321608736e-3f));
+    ps = _mm256_fmadd_ps(ps, r2, _mm256_set1_ps(-1.6666654611e-1f));
+    ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, r2), r, r);
+    __m256 pc = _mm256_fmadd_ps(_mm256_set1_ps(2.443315711809948e-5f), r2, _mm256_set1_ps(-1.388731625493765e-3f));
+    pc = _mm256_fmadd_ps(pc, r2, _mm256_set1_ps(4.166664568298827e-2f));
+    pc = _mm256_fmadd_ps(_mm256_mul_ps(pc, r2), r2, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+    // quadrant 1 and 3 swap sin and cos, quadrant 2 and 3 negate sin, 1 and 2 negate cos
+    __m256i quadrant = _mm256_cvtps_epi32(q);
+    __m256 swap = _mm256_castsi256_ps(_mm256_slli_epi32(quadrant, 31));
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(quadrant, 1), 31));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_srli_epi32(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), 1), 31));
+    s = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), sinSign);
+    c = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), cosSign);
+}
+#endif
+
+// A width x height grid of double pendulums, all released from rest, theta1 running across x and theta2 up y over
+// [-range, range]. State is structure of arrays padded to a multiple of 8 so eight neighbouring cells step together
+// in one AVX register; advance() hands rows of cells to the thread pool and every block of eight stays in registers
+// for the whole call.
+//
+// Per cell it records firstFlip, the sim time at which either arm first went over the top (|theta| > pi), and flips,
+// how many times the lower arm has gone over since the start. Cells that don't have the energy to flip either arm are
+// known before they start; a block of eight of those is never stepped at all, and with stopWhenFlipped a block
+// stops once all eight have flipped. Both are why the classic flip-time picture is cheap: most of it is either
+// settled early or never moves.
+class PendulumGrid
+{
+public:
+    static const size_t GRAIN = 1024; // cells per thread pool job, a multiple of 8
+
+    float *theta1, *theta2, *omega1, *omega2;
+    float *firstFlip;   // sim time of the first flip, -1 while it hasn't happened
+    float *flips;       // lower arm flips so far, a float so it lives in a register next to the rest
+    float *wrap;        // which turn of the lower arm round(theta2 / 2pi) was last seen on
+
+    PendulumGrid(int width, int height, const PendulumParams &params = PendulumParams(), float range = 3.14159265f)
+        : params(params), w(width), h(height), range(range), count((size_t)width * height),
+          padded(((size_t)width * height + 7) & ~size_t(7))
+    {
+        float** arrays[7] = { &theta1, &theta2, &omega1, &omega2, &firstFlip, &flips, &wrap };
+        for (float** array : arrays)
+            *array = static_cast<float*>(std::aligned_alloc(32, std::max<size_t>(padded, 8) * sizeof(float)));
+        mayFlip = new unsigned char[padded / 8];
+        reset();
+    }
+
+    ~PendulumGrid()
+    {
+        float* arrays[7] = { theta1, theta2, omega1, omega2, firstFlip, flips, wrap };
+        for (float* array : arrays)
+            std::free(array);
+        delete[] mayFlip;
+    }
+
+    PendulumGrid(const PendulumGrid&) = delete;
+    PendulumGrid& operator=(const PendulumGrid&) = delete;
+
+    // back to the starting angles at t = 0
+    void reset()
+    {
+        for (size_t i = 0; i < padded; i++)
+        {
+            float a = 0.0f, b = 0.0f;
+            if (i < count)
+            {
+                a = -range + 2.0f * range * ((i % w) + 0.5f) / w;
+                b = -range + 2.0f * range * ((i / w) + 0.5f) / h;
+            }
+            theta1[i] = a;
+            theta2[i] = b;
+            omega1[i] = omega2[i] = 0.0f;
+            firstFlip[i] = -1.0f;
+            flips[i] = wrap[i] = 0.0f;
+        }
+
+        // released from rest the energy is all potential, and going over the top needs at least as much as the
+        // cheapest pose with one arm straight up
+        float M = params.m1 + params.m2;
+        float upper = M * params.g * params.L1 - params.m2 * params.g * params.L2;
+        float lower = -M * params.g * params.L1 + params.m2 * params.g * params.L2;
+        float barrier = std::min(upper, lower);
+        for (size_t block = 0; block < padded / 8; block++)
+        {
+            mayFlip[block] = 0;
+            for (size_t i = block * 8; i < block * 8 + 8 && i < count; i++)
+            {
+                float energy = -M * params.g * params.L1 * std::cos(theta1[i]) - params.m2 * params.g * params.L2 * std::cos(theta2[i]);
+                if (energy >= barrier)
+                    mayFlip[block] = 1;
+            }
+        }
+        steps = 0;
+    }
+
+    // steps every cell on by 'duration' in RK4 steps of dt and returns how many pendulum steps that took (skipped
+    // cells don't count). simd = false forces the scalar kernel, for comparing the two
+    long long advance(float duration, float dt, ThreadPool *pool = nullptr, bool simd = true, bool stopWhenFlipped = true)
+    {
+        int n = std::max(1, (int)std::lround(duration / dt));
+        std::atomic<long long> done(0);
+        auto body = [&](size_t begin, size_t end) { done += stepRange(n, dt, begin, end, simd, stopWhenFlipped); };
+        if (pool && padded > GRAIN)
+            pool->parallelFor(padded, GRAIN, body);
+        else
+            body(0, padded);
+        steps += n;
+        lastDt = dt;
+        return done.load();
+    }
+
+    float time() const { return steps * lastDt; }
+    int width() const { return w; }
+    int height() const { return h; }
+    size_t size() const { return count; }
+
+    // flip time as colour, width * height * 3 bytes with row 0 at the bottom (theta2 = -range), ready for
+    // glTexSubImage2D. Fast flips are bright and warm, slow ones dim and blue, never (yet) is black
+    void writeImage(unsigned char *rgb, float longest) const
+    {
+        float scale = 1.0f / std::log(1.0f + longest);
+        for (size_t i = 0; i < count; i++)
+        {
+            float r = 0.0f, g = 0.0f, b = 0.0f;
+            if (firstFlip[i] >= 0.0f)
+            {
+                float u = std::min(1.0f, std::log(1.0f + firstFlip[i]) * scale);
+                float brightness = 1.0f - 0.75f * u;
+                r = brightness * (1.0f - 0.7f * u);
+                g = brightness * (0.85f - 0.6f * u);
+                b = brightness * (0.3f + 0.7f * u);
+            }
+            rgb[i * 3 + 0] = (unsigned char)(r * 255.0f + 0.5f);
+            rgb[i * 3 + 1] = (unsigned char)(g * 255.0f + 0.5f);
+            rgb[i * 3 + 2] = (unsigned char)(b * 255.0f + 0.5f);
+        }
+    }
+
+private:
+    PendulumParams params;
+    int w, h;
+    float range;
+    size_t count;
+    size_t padded;
+    unsigned char *mayFlip; // per block of eight, 0 when no cell in it can ever flip
+    long long steps = 0;
+    float lastDt = 0.0f;
+
+    long long stepRange(int n, float dt, size_t begin, size_t end, bool simd, bool stopWhenFlipped)
+    {
+        long long done = 0;
+        size_t i = begin;
+#ifdef PENDULUM_GRID_AVX2
+        if (simd)
+            for (; i + 8 <= end; i += 8)
+                done += stepEight(n, dt, i, stopWhenFlipped);
+#else
+        (void)simd;
+#endif
+        for (; i < end; i++)
+            done += stepOne(n, dt, i, stopWhenFlipped);
+        return done;
+    }
+
+    long long stepOne(int n, float dt, size_t i, bool stopWhenFlipped)
+    {
+        if (!mayFlip[i / 8] || (stopWhenFlipped && firstFlip[i] >= 0.0f))
+            return 0;
+        const PendulumConstants<float> k(params);
+        const float pi = 3.14159265f, twoPi = 6.28318531f;
+        float t1 = theta1[i], t2 = theta2[i], w1 = omega1[i], w2 = omega2[i];
+        float first = firstFlip[i], turns = flips[i], last = wrap[i];
+        int s = 0;
+        for (; s < n; s++)
+        {
+            pendulumRk4(t1, t2, w1, w2, k, dt);
+            if (first < 0.0f && (std::abs(t1) > pi || std::abs(t2) > pi))
+                first = (steps + s + 1) * dt;
+            float now = std::nearbyint(t2 / twoPi);
+            turns += std::abs(now - last);
+            last = now;
+            if (stopWhenFlipped && first >= 0.0f)
+            {
+                s++;
+                break;
+            }
+        }
+        theta1[i] = t1; theta2[i] = t2; omega1[i] = w1; omega2[i] = w2;
+        firstFlip[i] = first; flips[i] = turns; wrap[i] = last;
+        return s;
+    }
+
+#ifdef PENDULUM_GRID_AVX2
+    // stepOne for cells i .. i + 7, i a multiple of 8
+    long long stepEight(int n, float dt, size_t i, bool stopWhenFlipped)
+    {
+        if (!mayFlip[i / 8])
+            return 0;
+        Lanes8 first = _mm256_load_ps(firstFlip + i);
+        __m256 zero = _mm256_setzero_ps();
+        if (stopWhenFlipped && _mm256_movemask_ps(_mm256_cmp_ps(first.v, zero, _CMP_GE_OQ)) == 0xFF)
+            return 0;
+
+        const PendulumConstants<Lanes8> k(params);
+        Lanes8 h(dt);
+        Lanes8 t1 = _mm256_load_ps(theta1 + i), t2 = _mm256_load_ps(theta2 + i);
+        Lanes8 w1 = _mm256_load_ps(omega1 + i), w2 = _mm256_load_ps(omega2 + i);
+        __m256 turns = _mm256_load_ps(flips + i), last = _mm256_load_ps(wrap + i);
+        const __m256 pi = _mm256_set1_ps(3.14159265f), invTwoPi = _mm256_set1_ps(0.159154943f);
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+        int s = 0;
+        for (; s < n; s++)
+        {
+            pendulumRk4(t1, t2, w1, w2, k, h);
+            __m256 over = _mm256_or_ps(_mm256_cmp_ps(_mm256_and_ps(t1.v, absMask), pi, _CMP_GT_OQ),
+                                       _mm256_cmp_ps(_mm256_and_ps(t2.v, absMask), pi, _CMP_GT_OQ));
+            __m256 fresh = _mm256_and_ps(over, _mm256_cmp_ps(first.v, zero, _CMP_LT_OQ));
+            first = _mm256_blendv_ps(first.v, _mm256_set1_ps((steps + s + 1) * dt), fresh);
+            __m256 now = _mm256_round_ps(_mm256_mul_ps(t2.v, invTwoPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            turns = _mm256_add_ps(turns, _mm256_and_ps(_mm256_sub_ps(now, last), absMask));
+            last = now;
+            if (stopWhenFlipped && _mm256_movemask_ps(_mm256_cmp_ps(first.v, zero, _CMP_GE_OQ)) == 0xFF)
+            {
+                s++;
+                break;
+            }
+        }
+        _mm256_store_ps(theta1 + i, t1.v); _mm256_store_ps(theta2 + i, t2.v);
+        _mm256_store_ps(omega1 + i, w1.v); _mm256_store_ps(omega2 + i, w2.v);
+        _mm256_store_ps(firstFlip + i, first.v);
+        _mm256_store_ps(flips + i, turns);
+        _mm256_store_ps(wrap + i, last);
+        return 8LL * s;
+    }
+#endif
+};
+#endif
@@ -2,10 +2,19 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
+in float Fade;
 
 uniform sampler2D texture_diffuse1;
 
+// same pattern as impostor.fs, with the opposite test
+const float bayer[16] = float[](0.0f, 8.0f, 2.0f, 10.0f, 12.0f, 4.0f, 14.0f, 6.0f,
+                                3.0f, 11.0f, 1.0f, 9.0f, 15.0f, 7.0f, 13.0f, 5.0f);
+
 void main()
 {
+    ivec2 p = ivec2(gl_FragCoord.xy) % 4;
+    if ((bayer[p.y * 4 + p.x] + 0.5f) / 16.0f < 1.0f - Fade)
+        discard;
+
     FragColor = texture(texture_diffuse1, TexCoords);
-}
\ No newline at end of file
+}
@@ -1,15 +1,23 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in mat4 aInstanceMatrix;
+layout (location = 7) in mat4 aInstanceMatrix; // after the mesh attributes, see FIRST_INSTANCE_LOCATION
 
 out vec2 TexCoords;
+out float Fade;
 
 uniform mat4 projection;
 uniform mat4 view;
+uniform vec3 viewPos;
+uniform float lodDistance;
+uniform float fadeWidth;
+uniform vec3 center;    // of the rock's bounds, so the fade matches impostor.vs
 
 void main()
 {
     TexCoords = aTexCoords;
+    // 1 up close, 0 once the impostor has fully taken over
+    float dist = length(viewPos - vec3(aInstanceMatrix * vec4(center, 1.0f)));
+    Fade = 1.0f - clamp((dist - lodDistance) / fadeWidth, 0.0f, 1.0f);
     gl_Position = projection * view * aInstanceMatrix * vec4(aPos, 1.0f); 
-}
\ No newline at end of file
+}
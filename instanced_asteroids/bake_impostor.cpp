@@ -0,0 +1,131 @@
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <glm/glm.hpp>
+
+#include "shader_m.h"
+#include "model.h"
+#include "impostor.h"
+#include "rock_generator.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+// offline impostor baker: bake_impostor [seed] [variants] [subdivisions] [frames] [frameSize]
+// bakes the atlases of a procedural rock library into the same RockImpostorPath files the demo loads, so a belt can be
+// baked ahead of time instead of on its first run. The defaults are the demo's.
+// runs headless: the context comes from EGL, not a window, so no X11 or Wayland display is needed
+// (link it with -lEGL, it doesn't use GLFW)
+
+// a GL 3.3 core context without a window. EGL's surfaceless platform where the driver has it (Mesa), otherwise the
+// default display with a 1x1 pbuffer; either way everything is drawn into the atlas framebuffer
+struct HeadlessContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+
+    bool create()
+    {
+        const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        bool surfaceless = getPlatformDisplay && extensions && strstr(extensions, "EGL_MESA_platform_surfaceless");
+        display = surfaceless ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL)
+                              : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+            return false;
+        if (!eglBindAPI(EGL_OPENGL_API))
+            return false;
+
+        EGLint configAttributes[] = { EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+                                      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint configs = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0)
+            return false;
+        EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                       EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT)
+            return false;
+        if (!surfaceless)
+        {
+            EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+            if (surface == EGL_NO_SURFACE)
+                return false;
+        }
+        return eglMakeCurrent(display, surface, surface, context);
+    }
+
+    void Delete()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    uint64_t seed = argc > 1 ? std::strtoull(argv[1], NULL, 10) : 1337;
+    unsigned int variants = argc > 2 ? (unsigned int)std::max(1, std::atoi(argv[2])) : 8;
+    int subdivisions = argc > 3 ? std::max(0, std::atoi(argv[3])) : 3;
+    int frames = argc > 4 ? std::max(1, std::atoi(argv[4])) : 16;
+    int frameSize = argc > 5 ? std::max(1, std::atoi(argv[5])) : 64;
+    const std::string rockDir = "resources/objects/rock";
+
+    HeadlessContext gl;
+    if (!gl.create())
+    {
+        std::cout << "Failed to create an EGL context (eglGetError " << std::hex << eglGetError() << std::dec << ")"
+                  << std::endl;
+        gl.Delete();
+        return -1;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        gl.Delete();
+        return -1;
+    }
+
+    // same orientation the demo loads textures with
+    stbi_set_flip_vertically_on_load(true);
+
+    Shader bakeShader("impostor_bake.vs", "impostor_bake.fs");
+    // the same rocks the demo draws, from (or into) the same library cache
+    vector<RockMeshData> library = LoadOrGenerateRockLibrary(rockDir, seed, variants, subdivisions);
+    Texture rockTexture = { TextureFromFile("rock.png", rockDir), "texture_diffuse", "rock.png" };
+    for (unsigned int v = 0; v < variants; v++)
+    {
+        Model rock(vector<Mesh>{ Mesh(library[v].vertices, library[v].indices, { rockTexture }) });
+        ImpostorAtlas atlas = BakeImpostor(rock, bakeShader, frames, frameSize);
+        std::string outPath = RockImpostorPath(rockDir, seed, v, subdivisions, frames, frameSize);
+        if (!SaveImpostor(outPath, atlas))
+        {
+            gl.Delete();
+            return -1;
+        }
+        std::cout << "Baked " << frames << "x" << frames << " frames of " << frameSize << "px into " << outPath
+                  << " (radius " << atlas.radius << ")" << std::endl;
+    }
+
+    gl.Delete();
+    return 0;
+}
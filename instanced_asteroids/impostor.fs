@@ -0,0 +1,35 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 AtlasCoords;
+in vec3 WorldPos;
+in vec3 WorldViewDir;
+in float WorldRadius;
+in float Fade;
+
+uniform sampler2D texture_diffuse1;   // albedo atlas
+uniform sampler2D texture_normal1;    // normal.xyz, depth.w
+uniform mat4 projection;
+uniform mat4 view;
+
+// ordered dither, the mesh pass keeps the pixels this one throws away so the cross-fade needs no sorting
+const float bayer[16] = float[](0.0f, 8.0f, 2.0f, 10.0f, 12.0f, 4.0f, 14.0f, 6.0f,
+                                3.0f, 11.0f, 1.0f, 9.0f, 15.0f, 7.0f, 13.0f, 5.0f);
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy) % 4;
+    if ((bayer[p.y * 4 + p.x] + 0.5f) / 16.0f >= Fade)
+        discard;
+
+    vec4 albedo = texture(texture_diffuse1, AtlasCoords);
+    if (albedo.a < 0.5f)
+        discard;
+
+    // push the fragment back onto the baked surface so impostors intersect each other and the meshes properly
+    float depth = texture(texture_normal1, AtlasCoords).a * 2.0f - 1.0f;
+    vec4 clip = projection * view * vec4(WorldPos + WorldViewDir * depth * WorldRadius, 1.0f);
+    gl_FragDepth = (clip.z / clip.w) * 0.5f + 0.5f;
+
+    FragColor = vec4(albedo.rgb, 1.0f);
+}
@@ -0,0 +1,237 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "mesh.h"
+#include "model.h"
+#include "shader_m.h"
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+// An octahedral impostor is a grid of frames x frames snapshots of a model. Each frame looks at the model from one
+// direction, picked by unfolding an octahedron over the square (the same mapping the shader uses to find the frame
+// closest to the current view). Albedo goes into one atlas, object space normal plus depth along the view into another.
+struct ImpostorAtlas {
+    unsigned int albedo = 0;
+    unsigned int normalDepth = 0;
+    int frames = 0;            // frames per side of the grid
+    int frameSize = 0;         // pixels per side of one frame
+    float radius = 0.0f;       // bounding sphere radius of the model, the half-size of every frame
+    glm::vec3 center = glm::vec3(0.0f);
+
+    int atlasSize() const { return frames * frameSize; }
+};
+
+// square [0,1]^2 -> unit direction on the sphere, y is up
+inline glm::vec3 octahedralDecode(glm::vec2 uv)
+{
+    glm::vec2 f = uv * 2.0f - 1.0f;
+    glm::vec3 n(f.x, 1.0f - std::fabs(f.x) - std::fabs(f.y), f.y);
+    float t = std::max(-n.y, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.z += n.z >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+// the right/up axes a frame is rendered with. impostor.vs builds exactly the same basis
+inline void impostorFrameBasis(const glm::vec3 &dir, glm::vec3 &right, glm::vec3 &up)
+{
+    glm::vec3 worldUp = std::fabs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    right = glm::normalize(glm::cross(worldUp, dir));
+    up = glm::cross(dir, right);
+}
+
+inline unsigned int createAtlasTexture(int size, const void *data = nullptr)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    // no mipmaps, they would bleed neighbouring frames into each other
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// renders the model once per octahedral direction into the two atlases. bakeShader is impostor_bake.vs/fs.
+// Needs a current context but no visible window, see bake_impostor.cpp.
+ImpostorAtlas BakeImpostor(Model &model, Shader &bakeShader, int frames = 16, int frameSize = 128)
+{
+    ImpostorAtlas atlas;
+    atlas.frames = frames;
+    atlas.frameSize = frameSize;
+
+    // bounding sphere around the centre of the vertices' box
+    glm::vec3 minP(1e30f), maxP(-1e30f);
+    for (const Mesh &mesh : model.meshes)
+        for (const Vertex &v : mesh.vertices)
+        {
+            minP = glm::min(minP, v.Position);
+            maxP = glm::max(maxP, v.Position);
+        }
+    atlas.center = (minP + maxP) * 0.5f;
+    for (const Mesh &mesh : model.meshes)
+        for (const Vertex &v : mesh.vertices)
+            atlas.radius = std::max(atlas.radius, glm::length(v.Position - atlas.center));
+
+    int size = atlas.atlasSize();
+    atlas.albedo = createAtlasTexture(size);
+    atlas.normalDepth = createAtlasTexture(size);
+
+    unsigned int fbo, rbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, atlas.normalDepth, 0);
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "ERROR::IMPOSTOR:: Framebuffer is not complete!" << endl;
+
+    GLint oldViewport[4];
+    glGetIntegerv(GL_VIEWPORT, oldViewport);
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, size, size);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    float r = atlas.radius;
+    glm::mat4 projection = glm::ortho(-r, r, -r, r, 0.0f, 4.0f * r);
+    bakeShader.use();
+    bakeShader.setMat4("projection", projection);
+    bakeShader.setVec3("center", atlas.center);
+    bakeShader.setFloat("radius", r);
+    for (int y = 0; y < frames; y++)
+        for (int x = 0; x < frames; x++)
+        {
+            glm::vec3 dir = octahedralDecode(glm::vec2((x + 0.5f) / frames, (y + 0.5f) / frames));
+            glm::vec3 right, up;
+            impostorFrameBasis(dir, right, up);
+            glm::mat4 view = glm::lookAt(atlas.center + dir * 2.0f * r, atlas.center, up);
+
+            glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+            bakeShader.setMat4("view", view);
+            bakeShader.setVec3("viewDir", dir);
+            model.Draw(bakeShader);
+        }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &rbo);
+    glDeleteFramebuffers(1, &fbo);
+    glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+    return atlas;
+}
+
+// .impostor file: header followed by the albedo and normal/depth atlases as raw RGBA8
+struct ImpostorHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t frames;
+    uint32_t frameSize;
+    float radius;
+    float center[3];
+};
+
+bool SaveImpostor(const string &path, const ImpostorAtlas &atlas)
+{
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "ERROR::IMPOSTOR:: could not write " << path << endl;
+        return false;
+    }
+    ImpostorHeader header = { {'I', 'M', 'P', 'O'}, 1, (uint32_t)atlas.frames, (uint32_t)atlas.frameSize, atlas.radius,
+                              { atlas.center.x, atlas.center.y, atlas.center.z } };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    vector<unsigned char> pixels((size_t)atlas.atlasSize() * atlas.atlasSize() * 4);
+    unsigned int textures[2] = { atlas.albedo, atlas.normalDepth };
+    for (unsigned int texture : textures)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return file.good();
+}
+
+// where the atlas of procedural rock 'variant' is cached. Everything the atlas depends on is in the name: the rock
+// library's seed and subdivisions (rock i only depends on the seed and i) and the bake's frames and frameSize, so
+// changing any of them bakes a new atlas instead of loading one made for a different mesh
+inline string RockImpostorPath(const string &cacheDir, uint64_t seed, unsigned int variant, int subdivisions,
+                               int frames, int frameSize)
+{
+    return cacheDir + "/rocks_" + std::to_string(seed) + "_" + std::to_string(variant) + "_" +
+           std::to_string(subdivisions) + "_" + std::to_string(frames) + "_" + std::to_string(frameSize) + ".impostor";
+}
+
+bool LoadImpostor(const string &path, ImpostorAtlas &atlas)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+    ImpostorHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, "IMPO", 4) != 0 || header.version != 1)
+    {
+        cout << "ERROR::IMPOSTOR:: " << path << " is not an impostor atlas" << endl;
+        return false;
+    }
+    atlas.frames = header.frames;
+    atlas.frameSize = header.frameSize;
+    atlas.radius = header.radius;
+    atlas.center = glm::vec3(header.center[0], header.center[1], header.center[2]);
+
+    size_t bytes = (size_t)atlas.atlasSize() * atlas.atlasSize() * 4;
+    vector<unsigned char> albedo(bytes), normalDepth(bytes);
+    file.read(reinterpret_cast<char*>(albedo.data()), bytes);
+    file.read(reinterpret_cast<char*>(normalDepth.data()), bytes);
+    if (!file)
+    {
+        cout << "ERROR::IMPOSTOR:: " << path << " is truncated" << endl;
+        return false;
+    }
+    atlas.albedo = createAtlasTexture(atlas.atlasSize(), albedo.data());
+    atlas.normalDepth = createAtlasTexture(atlas.atlasSize(), normalDepth.data());
+    return true;
+}
+
+// a unit quad (corners at +-1) carrying the atlases as its material, so it can be drawn with the same
+// instance streams and Mesh::DrawInstanced as the full model. impostor.fs samples texture_diffuse1/texture_normal1.
+Mesh MakeImpostorQuad(const ImpostorAtlas &atlas)
+{
+    vector<Vertex> vertices(4);
+    glm::vec2 corners[4] = { {-1.0f, -1.0f}, {1.0f, -1.0f}, {-1.0f, 1.0f}, {1.0f, 1.0f} };
+    for (int i = 0; i < 4; i++)
+    {
+        Vertex vertex = {};
+        vertex.Position = glm::vec3(corners[i], 0.0f);
+        vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        vertex.TexCoords = corners[i] * 0.5f + 0.5f;
+        vertices[i] = vertex;
+    }
+    vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3 };
+    vector<Texture> textures = { { atlas.albedo, "texture_diffuse", "impostor_albedo" },
+                                 { atlas.normalDepth, "texture_normal", "impostor_normal_depth" } };
+    return Mesh(vertices, indices, textures);
+}
+#endif
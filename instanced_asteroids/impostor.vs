@@ -0,0 +1,71 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;      // quad corner in [-1, 1]
+layout (location = 7) in mat4 aInstanceMatrix;
+
+out vec2 AtlasCoords;
+out vec3 WorldPos;
+out vec3 WorldViewDir;
+out float WorldRadius;
+out float Fade;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 viewPos;
+uniform float lodDistance;
+uniform float fadeWidth;
+
+uniform int frames;
+uniform float radius;
+uniform vec3 center;
+
+// same mapping as octahedralDecode in impostor.h
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 uv = n.xz;
+    if (n.y < 0.0f)
+        uv = (1.0f - abs(n.zx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.z >= 0.0f ? 1.0f : -1.0f);
+    return uv * 0.5f + 0.5f;
+}
+
+vec3 octahedralDecode(vec2 uv)
+{
+    vec2 f = uv * 2.0f - 1.0f;
+    vec3 n = vec3(f.x, 1.0f - abs(f.x) - abs(f.y), f.y);
+    float t = max(-n.y, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.z += n.z >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 instanceCenter = vec3(aInstanceMatrix * vec4(center, 1.0f));
+    float scale = length(aInstanceMatrix[0].xyz);
+    mat3 rotation = mat3(aInstanceMatrix) / scale;
+
+    // close instances are drawn as meshes, collapse their quad
+    float dist = length(viewPos - instanceCenter);
+    Fade = clamp((dist - lodDistance) / fadeWidth, 0.0f, 1.0f);
+    if (dist < lodDistance)
+    {
+        gl_Position = vec4(0.0f);
+        return;
+    }
+
+    // pick the baked frame closest to the direction we look at the rock from, in the rock's own space
+    vec3 toCamera = transpose(rotation) * normalize(viewPos - instanceCenter);
+    vec2 cell = clamp(floor(octahedralEncode(toCamera) * frames), vec2(0.0f), vec2(frames - 1));
+    vec3 frameDir = octahedralDecode((cell + 0.5f) / frames);
+
+    // and lay the quad out exactly the way that frame was rendered (impostorFrameBasis)
+    vec3 worldUp = abs(frameDir.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+    vec3 right = normalize(cross(worldUp, frameDir));
+    vec3 up = cross(frameDir, right);
+
+    WorldRadius = radius * scale;
+    WorldViewDir = rotation * frameDir;
+    WorldPos = instanceCenter + rotation * (aPos.x * right + aPos.y * up) * WorldRadius;
+    AtlasCoords = (cell + aPos.xy * 0.5f + 0.5f) / frames;
+    gl_Position = projection * view * vec4(WorldPos, 1.0f);
+}
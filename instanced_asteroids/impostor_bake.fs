@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) out vec4 Albedo;
+layout (location = 1) out vec4 NormalDepth;
+
+in vec2 TexCoords;
+in vec3 Normal;
+in vec3 LocalPos;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 viewDir;   // from the model towards the bake camera
+uniform float radius;
+
+void main()
+{
+    Albedo = vec4(texture(texture_diffuse1, TexCoords).rgb, 1.0f);
+    // object space normal, and how far the surface sits in front of the frame's plane, both packed into [0,1]
+    float depth = dot(LocalPos, viewDir) / radius;
+    NormalDepth = vec4(normalize(Normal) * 0.5f + 0.5f, depth * 0.5f + 0.5f);
+}
@@ -14,6 +14,9 @@
 #include "shader_m.h"
 #include "camera.h"
 #include "model.h"
+#include "impostor.h"
+#include "rock_generator.h"
+#include "rock_grid.h"
 
 #include <iostream>
 
@@ -36,15 +39,26 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// procedural rocks
+const unsigned int ROCK_VARIANTS = 8;
+const int ROCK_SUBDIVISIONS = 3;
+const int IMPOSTOR_FRAMES = 16;
+const int IMPOSTOR_FRAME_SIZE = 64;
+uint64_t rockSeed = 1337;
+
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 
 
-int main()
+// optional first argument: the seed for the rock shapes and the belt layout
+int main(int argc, char** argv)
 {
-        glfwInit();
+    if (argc > 1)
+        rockSeed = std::strtoull(argv[1], NULL, 10);
+
+    glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -85,56 +99,94 @@ int main()
     //Shaders:
     Shader asteroidShader("asteroids.vs", "asteroids.fs");
     Shader planetShader("planets.vs", "planets.fs");
+    Shader impostorShader("impostor.vs", "impostor.fs");
 
     //models
-    Model rock("resources/objects/rock/rock.obj");
     Model planet("resources/objects/planet/planet.obj");
 
-
-   // Model rock("resources/objects/rock/rock.obj");
-    std::cout << "Rock meshes loaded: " << rock.meshes.size() << std::endl;
-    std::cout << "Rock textures loaded: " << rock.textures_loaded.size() << std::endl;
-
-    // Also check if the model file exists
-    std::ifstream file("resources/objects/rock/rock.obj");
-    if (!file.good()) {
-        std::cout << "Model file not found!" << std::endl;
-    } else {
-        std::cout << "Model file exists" << std::endl;
+    // a library of distinct procedural rocks, all wearing rock.png. Cached on disk after the first run
+    std::cout << "Rock seed: " << rockSeed << std::endl;
+    vector<RockMeshData> rockLibrary = LoadOrGenerateRockLibrary("resources/objects/rock", rockSeed, ROCK_VARIANTS,
+                                                                 ROCK_SUBDIVISIONS);
+    Texture rockTexture = { TextureFromFile("rock.png", "resources/objects/rock"), "texture_diffuse", "rock.png" };
+    vector<Model> rocks;
+    for (const RockMeshData &data : rockLibrary)
+        rocks.push_back(Model(vector<Mesh>{ Mesh(data.vertices, data.indices, { rockTexture }) }));
+
+    // far away rocks are drawn as octahedral impostors, one atlas per rock, baked here the first time round
+    Shader bakeShader("impostor_bake.vs", "impostor_bake.fs");
+    vector<ImpostorAtlas> rockAtlases(ROCK_VARIANTS);
+    vector<Mesh> rockImpostors;
+    for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+    {
+        string atlasPath = RockImpostorPath("resources/objects/rock", rockSeed, v, ROCK_SUBDIVISIONS, IMPOSTOR_FRAMES,
+                                            IMPOSTOR_FRAME_SIZE);
+        if (!LoadImpostor(atlasPath, rockAtlases[v]))
+        {
+            std::cout << "Baking impostor for rock " << v << "..." << std::endl;
+            rockAtlases[v] = BakeImpostor(rocks[v], bakeShader, IMPOSTOR_FRAMES, IMPOSTOR_FRAME_SIZE);
+            SaveImpostor(atlasPath, rockAtlases[v]);
+        }
+        rockImpostors.push_back(MakeImpostorQuad(rockAtlases[v]));
     }
 
-    //semi-random transformation matrices
-    unsigned int amount = 5000;
+    // rocks closer than lodDistance are full meshes, further than lodDistance + fadeWidth only impostors,
+    // in between both are drawn and dithered into each other
+    float lodDistance = 40.0f;
+    float fadeWidth = 5.0f;
+    const float meshDistance = lodDistance + fadeWidth;
+
+    //semi-random transformation matrices, reproducible from the seed
+    unsigned int amount = 1000000;
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
-    srand(glfwGetTime());
-    float radius = 50.0f;
-    float offset = 4.5f;
+    RockRandom layout(rockSeed);
+    float radius = 150.0f;
+    float offset = 25.0f;
+    vector<unsigned int> rockVariants(amount);
     for (unsigned int i=0;i<amount;i++)
     {
         glm::mat4 model = glm::mat4(1.0f);
         // translation: displace along circle wih radius in range [-offset, offset]
         float angle = (float)i/(float)amount*360.0f;
-        float displacement = (rand()%(int)(2*offset*100))/100.0f-offset;
+        float displacement = layout.range(-offset, offset);
         float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        displacement = layout.range(-offset, offset);
         float y = displacement * 0.4f; // keep height of field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        displacement = layout.range(-offset, offset);
         float z = cos(angle) * radius + displacement;
         model = glm::translate(model, glm::vec3(x,y,z));
 
         // scale: scale between 0.05 and 0.25f
-        float scale = (rand() % 20) / 100.0f + 0.05;
+        float scale = layout.range(0.05f, 0.25f);
         model = glm::scale(model, glm::vec3(scale));
 
         // rotation: random reotationangle aroudn a rotation axis vector
-        float rotAngle = (rand() % 360);
+        float rotAngle = layout.range(0.0f, 360.0f);
         model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
 
         // add to list of matrix
         modelMatrices[i] = model;
+        rockVariants[i] = layout.nextInt(ROCK_VARIANTS);
     } // after this for loop have amount number of modelMatrices describing the matrices for asteroid positions
 
+    // store the matrices grouped by rock so every rock draws its own slice of the buffer
+    RockBuckets buckets = BucketRocks(rockVariants, ROCK_VARIANTS);
+    glm::mat4* sortedMatrices = new glm::mat4[amount];
+    for (unsigned int slot = 0; slot < amount; slot++)
+        sortedMatrices[slot] = modelMatrices[buckets.order[slot]];
+    delete[] modelMatrices;
+    modelMatrices = sortedMatrices;
+
+    // where each rock's bounds end up, binned so the ones close enough to need the real mesh are found without
+    // looking at the whole belt every frame
+    glm::vec3* rockCenters = new glm::vec3[amount];
+    for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+        for (unsigned int slot = buckets.first[v]; slot < buckets.first[v] + buckets.count[v]; slot++)
+            rockCenters[slot] = glm::vec3(modelMatrices[slot] * glm::vec4(rockAtlases[v].center, 1.0f));
+    RockGrid rockGrid(rockCenters, buckets, meshDistance / 4.0f);
+    delete[] rockCenters;
+
 
     // we need to configure the instanced array:
     unsigned int buffer;
@@ -142,28 +194,20 @@ int main()
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
     glBufferData(GL_ARRAY_BUFFER, amount*sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
 
-    //
-    for (unsigned int i = 0; i < rock.meshes.size(); i++)
-    {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
-    }
+    // the matrices are one mat4 per asteroid, bound after the rock's own vertex attributes.
+    // every rock goes through the impostor pass, only the near ones are copied into nearBuffer for the mesh pass
+    vector<vector<InstanceStream>> rockStreams;
+    for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+        rockStreams.push_back({ { buffer, VertexLayout().addMat4(), 1, static_cast<unsigned int>(buckets.first[v] * sizeof(glm::mat4)) } });
+    // sized once for the fullest spot in the belt, then refilled in place every frame
+    unsigned int nearCapacity = std::max(1u, rockGrid.maxNear(meshDistance));
+    unsigned int nearBuffer;
+    glGenBuffers(1, &nearBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, nearBuffer);
+    glBufferData(GL_ARRAY_BUFFER, nearCapacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    vector<glm::mat4> nearMatrices;
+    nearMatrices.reserve(nearCapacity);
+    vector<unsigned int> nearFirst(ROCK_VARIANTS), nearCount(ROCK_VARIANTS);
 
 
 
@@ -185,6 +229,15 @@ int main()
         asteroidShader.use();
         asteroidShader.setMat4("projection", projection);
         asteroidShader.setMat4("view", view);
+        asteroidShader.setVec3("viewPos", camera.Position);
+        asteroidShader.setFloat("lodDistance", lodDistance);
+        asteroidShader.setFloat("fadeWidth", fadeWidth);
+        impostorShader.use();
+        impostorShader.setMat4("projection", projection);
+        impostorShader.setMat4("view", view);
+        impostorShader.setVec3("viewPos", camera.Position);
+        impostorShader.setFloat("lodDistance", lodDistance);
+        impostorShader.setFloat("fadeWidth", fadeWidth);
         planetShader.use();
         planetShader.setMat4("projection", projection);
         planetShader.setMat4("view", view);
@@ -196,22 +249,35 @@ int main()
         planetShader.setMat4("model",model);
         planet.Draw(planetShader);
 
-        //meteroites
+        //meteroites: full meshes for the few near the camera, still grouped by rock
+        rockGrid.gatherNear(camera.Position, meshDistance, modelMatrices, nearMatrices, nearFirst, nearCount);
+        if (!nearMatrices.empty())
+        {
+            // orphan last frame's storage so the driver hands over a fresh block instead of waiting on the GPU
+            glBindBuffer(GL_ARRAY_BUFFER, nearBuffer);
+            glBufferData(GL_ARRAY_BUFFER, nearCapacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, nearMatrices.size() * sizeof(glm::mat4), nearMatrices.data());
+        }
+
         asteroidShader.use();
-        asteroidShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        if (!rock.textures_loaded.empty()) {
-            glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); 
-        } else{
-            std::cout << "empty!" << std::endl;
+        for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+        {
+            if (nearCount[v] == 0)
+                continue;
+            vector<InstanceStream> nearStreams = { { nearBuffer, VertexLayout().addMat4(), 1, static_cast<unsigned int>(nearFirst[v] * sizeof(glm::mat4)) } };
+            asteroidShader.setVec3("center", rockAtlases[v].center);
+            rocks[v].DrawInstanced(asteroidShader, nearStreams, nearCount[v]);
         }
 
-        
-        for (unsigned int i = 0; i<rock.meshes.size(); i++)
+        // and a quad each for everything else
+        impostorShader.use();
+        for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
         {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
-            glBindVertexArray(0);
+            impostorShader.setInt("frames", rockAtlases[v].frames);
+            impostorShader.setFloat("radius", rockAtlases[v].radius);
+            impostorShader.setVec3("center", rockAtlases[v].center);
+            rockImpostors[v].BindInstanceStreams(rockStreams[v]);
+            rockImpostors[v].DrawInstanced(impostorShader, buckets.count[v]);
         }
 
         glfwSwapBuffers(window);
@@ -11,9 +11,12 @@
 
 #include <string>
 #include <vector>
+#include <iostream>
 using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
+// locations 0-6 are taken by the Vertex attributes below, per-instance streams start after them
+#define FIRST_INSTANCE_LOCATION 7
 
 struct Vertex {
     // position
@@ -38,6 +41,58 @@ struct Texture {
     string path;
 };
 
+// one attribute inside an interleaved buffer (size is the component count, 1-4)
+struct VertexAttribute {
+    int size;
+    GLenum type;
+    unsigned int offset;
+
+    bool operator==(const VertexAttribute &other) const
+    {
+        return size == other.size && type == other.type && offset == other.offset;
+    }
+};
+
+// describes how an interleaved buffer is laid out, attributes are appended in location order
+struct VertexLayout {
+    unsigned int stride = 0;
+    vector<VertexAttribute> attributes;
+
+    VertexLayout& add(int size, GLenum type = GL_FLOAT)
+    {
+        unsigned int bytes = 4;
+        if (type == GL_HALF_FLOAT || type == GL_SHORT || type == GL_UNSIGNED_SHORT)
+            bytes = 2;
+        else if (type == GL_BYTE || type == GL_UNSIGNED_BYTE)
+            bytes = 1;
+        attributes.push_back({size, type, stride});
+        stride += size * bytes;
+        return *this;
+    }
+    // a mat4 takes up four consecutive vec4 locations
+    VertexLayout& addMat4()
+    {
+        for (int i = 0; i < 4; i++)
+            add(4);
+        return *this;
+    }
+    unsigned int locationCount() const { return static_cast<unsigned int>(attributes.size()); }
+    // same stride and the same attributes in the same order, so a VAO set up for one reads the other right
+    bool operator==(const VertexLayout &other) const
+    {
+        return stride == other.stride && attributes == other.attributes;
+    }
+};
+
+// a buffer of per-instance data, advanced once every 'divisor' instances. offset (in bytes) lets several
+// meshes draw from their own slice of one shared buffer
+struct InstanceStream {
+    unsigned int buffer;
+    VertexLayout layout;
+    unsigned int divisor = 1;
+    unsigned int offset = 0;
+};
+
 class Mesh {
 public:
     // mesh Data
@@ -59,6 +114,95 @@ public:
 
     // render the mesh
     void Draw(Shader &shader) 
+    {
+        bindTextures(shader);
+        
+        // draw mesh
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // attaches the instance streams to this mesh's VAO, starting at FIRST_INSTANCE_LOCATION.
+    // the streams are laid out one after the other, so a shader reading a mat4 stream followed by a vec4
+    // stream declares them at locations 7 and 11. Rebinding the same streams is a no-op.
+    void BindInstanceStreams(const vector<InstanceStream> &streams)
+    {
+        if (sameStreams(streams))
+            return;
+
+        GLint maxAttribs = 0;
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttribs);
+
+        glBindVertexArray(VAO);
+        // switch off whatever the previous streams enabled before laying out the new ones
+        for (unsigned int i = 0; i < instanceLocations; i++)
+            glDisableVertexAttribArray(FIRST_INSTANCE_LOCATION + i);
+
+        unsigned int location = FIRST_INSTANCE_LOCATION;
+        for (const InstanceStream &stream : streams)
+        {
+            if (location + stream.layout.locationCount() > static_cast<unsigned int>(maxAttribs))
+            {
+                cout << "ERROR::MESH::INSTANCE_STREAMS_EXCEED_MAX_VERTEX_ATTRIBS: " << maxAttribs << endl;
+                break;
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+            for (const VertexAttribute &attribute : stream.layout.attributes)
+            {
+                glEnableVertexAttribArray(location);
+                if (attribute.type == GL_INT || attribute.type == GL_UNSIGNED_INT || attribute.type == GL_SHORT
+                    || attribute.type == GL_UNSIGNED_SHORT || attribute.type == GL_BYTE || attribute.type == GL_UNSIGNED_BYTE)
+                    glVertexAttribIPointer(location, attribute.size, attribute.type, stream.layout.stride, (void*)(size_t)(stream.offset + attribute.offset));
+                else
+                    glVertexAttribPointer(location, attribute.size, attribute.type, GL_FALSE, stream.layout.stride, (void*)(size_t)(stream.offset + attribute.offset));
+                glVertexAttribDivisor(location, stream.divisor);
+                location++;
+            }
+        }
+        glBindVertexArray(0);
+
+        instanceLocations = location - FIRST_INSTANCE_LOCATION;
+        boundStreams = streams;
+    }
+
+    // render 'count' instances of the mesh with whatever instance streams are bound
+    void DrawInstanced(Shader &shader, unsigned int count)
+    {
+        bindTextures(shader);
+
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0, count);
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    // render data 
+    unsigned int VBO, EBO;
+    // instance streams currently attached to the VAO
+    vector<InstanceStream> boundStreams;
+    unsigned int instanceLocations = 0;
+
+    bool sameStreams(const vector<InstanceStream> &streams) const
+    {
+        if (streams.size() != boundStreams.size())
+            return false;
+        for (size_t i = 0; i < streams.size(); i++)
+        {
+            const InstanceStream &a = streams[i];
+            const InstanceStream &b = boundStreams[i];
+            if (a.buffer != b.buffer || a.divisor != b.divisor || a.offset != b.offset || !(a.layout == b.layout))
+                return false;
+        }
+        return true;
+    }
+
+    void bindTextures(Shader &shader)
     {
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
@@ -85,20 +229,8 @@ public:
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
@@ -0,0 +1,331 @@
+#ifndef ROCK_GENERATOR_H
+#define ROCK_GENERATOR_H
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "thread_pool.h"
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+using namespace std;
+
+// Procedural asteroids: an icosphere pushed in and out by fractal value noise and squashed into an ellipsoid.
+// Everything is derived from a 64 bit seed, so the same seed always gives the same library no matter how many
+// threads built it.
+
+// splitmix64, small and good enough to seed noise and lay out instances
+class RockRandom
+{
+public:
+    RockRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    // [0, 1)
+    float nextFloat() { return (next() >> 40) * (1.0f / 16777216.0f); }
+    float range(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+    unsigned int nextInt(unsigned int n) { return static_cast<unsigned int>(next() % n); }
+
+private:
+    uint64_t state;
+};
+
+struct RockMeshData {
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+};
+
+inline float rockLatticeValue(int x, int y, int z, uint64_t seed)
+{
+    uint64_t h = seed ^ (uint64_t)(uint32_t)x * 0x8DA6B343ull ^ (uint64_t)(uint32_t)y * 0xD8163841ull ^ (uint64_t)(uint32_t)z * 0xCB1AB31Full;
+    return RockRandom(h).nextFloat() * 2.0f - 1.0f;
+}
+
+// smoothly interpolated random values on the integer lattice, in [-1, 1]
+inline float rockValueNoise(glm::vec3 p, uint64_t seed)
+{
+    glm::vec3 i = glm::floor(p);
+    glm::vec3 f = p - i;
+    glm::vec3 w = f * f * (3.0f - 2.0f * f);
+    int x = (int)i.x, y = (int)i.y, z = (int)i.z;
+
+    float c000 = rockLatticeValue(x, y, z, seed),         c100 = rockLatticeValue(x + 1, y, z, seed);
+    float c010 = rockLatticeValue(x, y + 1, z, seed),     c110 = rockLatticeValue(x + 1, y + 1, z, seed);
+    float c001 = rockLatticeValue(x, y, z + 1, seed),     c101 = rockLatticeValue(x + 1, y, z + 1, seed);
+    float c011 = rockLatticeValue(x, y + 1, z + 1, seed), c111 = rockLatticeValue(x + 1, y + 1, z + 1, seed);
+
+    float x00 = glm::mix(c000, c100, w.x), x10 = glm::mix(c010, c110, w.x);
+    float x01 = glm::mix(c001, c101, w.x), x11 = glm::mix(c011, c111, w.x);
+    return glm::mix(glm::mix(x00, x10, w.y), glm::mix(x01, x11, w.y), w.z);
+}
+
+inline float rockFbm(glm::vec3 p, uint64_t seed, int octaves)
+{
+    float sum = 0.0f, amplitude = 0.5f;
+    for (int o = 0; o < octaves; o++)
+    {
+        sum += amplitude * rockValueNoise(p, seed + o);
+        p *= 2.03f;
+        amplitude *= 0.5f;
+    }
+    return sum;
+}
+
+// unit icosphere, each subdivision splits every triangle into four
+inline void buildIcosphere(int subdivisions, vector<glm::vec3> &positions, vector<unsigned int> &indices)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    positions = { {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+                  {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1} };
+    for (glm::vec3 &p : positions)
+        p = glm::normalize(p);
+    indices = { 0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,  1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+                3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,  4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1 };
+
+    for (int s = 0; s < subdivisions; s++)
+    {
+        map<uint64_t, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+                return found->second;
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            unsigned int index = static_cast<unsigned int>(positions.size() - 1);
+            midpoints[key] = index;
+            return index;
+        };
+
+        vector<unsigned int> finer;
+        finer.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            finer.insert(finer.end(), { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca });
+        }
+        indices.swap(finer);
+    }
+}
+
+// one rock, roughly the size of rock.obj (radius ~1.6)
+RockMeshData GenerateRock(uint64_t seed, int subdivisions = 3)
+{
+    RockRandom rng(seed);
+    glm::vec3 stretch(rng.range(0.7f, 1.3f), rng.range(0.6f, 1.0f), rng.range(0.7f, 1.3f));
+    float roughness = rng.range(0.25f, 0.45f);
+    float frequency = rng.range(1.2f, 2.2f);
+    glm::vec3 noiseOffset(rng.range(-100.0f, 100.0f), rng.range(-100.0f, 100.0f), rng.range(-100.0f, 100.0f));
+    uint64_t noiseSeed = rng.next();
+
+    vector<glm::vec3> directions;
+    vector<unsigned int> indices;
+    buildIcosphere(subdivisions, directions, indices);
+
+    RockMeshData rock;
+    rock.vertices.resize(directions.size());
+    for (size_t i = 0; i < directions.size(); i++)
+    {
+        glm::vec3 d = directions[i];
+        float displacement = 1.0f + roughness * rockFbm(d * frequency + noiseOffset, noiseSeed, 5);
+        Vertex vertex = {};
+        vertex.Position = d * stretch * displacement * 1.6f;
+        // spherical mapping of the undisplaced direction
+        vertex.TexCoords = glm::vec2(std::atan2(d.z, d.x) / (2.0f * 3.14159265f) + 0.5f, std::asin(glm::clamp(d.y, -1.0f, 1.0f)) / 3.14159265f + 0.5f);
+        rock.vertices[i] = vertex;
+    }
+
+    // area weighted normals, before the seam is split so both sides of it shade the same
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        glm::vec3 faceNormal = glm::cross(rock.vertices[indices[i + 1]].Position - rock.vertices[indices[i]].Position,
+                                          rock.vertices[indices[i + 2]].Position - rock.vertices[indices[i]].Position);
+        for (size_t k = i; k < i + 3; k++)
+            rock.vertices[indices[k]].Normal += faceNormal;
+    }
+    for (Vertex &v : rock.vertices)
+        v.Normal = glm::normalize(v.Normal);
+
+    // triangles straddling the u = 0/1 seam get their own copies of the low-u vertices, shifted by one
+    map<unsigned int, unsigned int> seamCopies;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        float u0 = rock.vertices[indices[i]].TexCoords.x;
+        float u1 = rock.vertices[indices[i + 1]].TexCoords.x;
+        float u2 = rock.vertices[indices[i + 2]].TexCoords.x;
+        if (std::max(u0, std::max(u1, u2)) - std::min(u0, std::min(u1, u2)) < 0.5f)
+            continue;
+        for (size_t k = i; k < i + 3; k++)
+        {
+            if (rock.vertices[indices[k]].TexCoords.x >= 0.5f)
+                continue;
+            auto found = seamCopies.find(indices[k]);
+            if (found == seamCopies.end())
+            {
+                Vertex copy = rock.vertices[indices[k]];
+                copy.TexCoords.x += 1.0f;
+                rock.vertices.push_back(copy);
+                found = seamCopies.emplace(indices[k], static_cast<unsigned int>(rock.vertices.size() - 1)).first;
+            }
+            indices[k] = found->second;
+        }
+    }
+    rock.indices = indices;
+
+    // uv aligned tangents, accumulated per vertex
+    vector<glm::vec3> tangents(rock.vertices.size(), glm::vec3(0.0f));
+    vector<glm::vec3> bitangents(rock.vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i < rock.indices.size(); i += 3)
+    {
+        Vertex &a = rock.vertices[rock.indices[i]];
+        Vertex &b = rock.vertices[rock.indices[i + 1]];
+        Vertex &c = rock.vertices[rock.indices[i + 2]];
+        glm::vec3 e1 = b.Position - a.Position, e2 = c.Position - a.Position;
+        glm::vec2 t1 = b.TexCoords - a.TexCoords, t2 = c.TexCoords - a.TexCoords;
+        float det = t1.x * t2.y - t2.x * t1.y;
+        float r = std::fabs(det) > 1e-12f ? 1.0f / det : 0.0f;
+        glm::vec3 tangent = (e1 * t2.y - e2 * t1.y) * r;
+        glm::vec3 bitangent = (e2 * t1.x - e1 * t2.x) * r;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int index = rock.indices[i + k];
+            tangents[index] += tangent;
+            bitangents[index] += bitangent;
+        }
+    }
+    for (size_t i = 0; i < rock.vertices.size(); i++)
+    {
+        Vertex &v = rock.vertices[i];
+        // Gram-Schmidt against the smooth normal, keeping the handedness of the uv mapping
+        glm::vec3 t = tangents[i] - v.Normal * glm::dot(v.Normal, tangents[i]);
+        if (glm::dot(t, t) < 1e-12f)
+            t = glm::cross(std::fabs(v.Normal.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), v.Normal);
+        v.Tangent = glm::normalize(t);
+        float handedness = glm::dot(glm::cross(v.Normal, v.Tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+        v.Bitangent = glm::cross(v.Normal, v.Tangent) * handedness;
+    }
+    return rock;
+}
+
+// count different rocks, built in parallel. Rock i only depends on (seed, i)
+vector<RockMeshData> GenerateRockLibrary(uint64_t seed, unsigned int count, int subdivisions, ThreadPool &pool)
+{
+    vector<RockMeshData> library(count);
+    RockRandom seeds(seed);
+    vector<uint64_t> rockSeeds(count);
+    for (unsigned int i = 0; i < count; i++)
+        rockSeeds[i] = seeds.next();
+    pool.parallelFor(count, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            library[i] = GenerateRock(rockSeeds[i], subdivisions);
+    });
+    return library;
+}
+
+// instance indices grouped by the rock they use: order[first[v] .. first[v] + count[v]) are the instances of rock v,
+// so their matrices can be uploaded back to back and each rock drawn with a single instanced call
+struct RockBuckets {
+    vector<unsigned int> order;
+    vector<unsigned int> first;
+    vector<unsigned int> count;
+};
+
+RockBuckets BucketRocks(const vector<unsigned int> &variants, unsigned int variantCount)
+{
+    RockBuckets buckets;
+    buckets.first.assign(variantCount, 0);
+    buckets.count.assign(variantCount, 0);
+    for (unsigned int v : variants)
+        buckets.count[v]++;
+    for (unsigned int v = 1; v < variantCount; v++)
+        buckets.first[v] = buckets.first[v - 1] + buckets.count[v - 1];
+
+    buckets.order.resize(variants.size());
+    vector<unsigned int> cursor = buckets.first;
+    for (unsigned int i = 0; i < variants.size(); i++)
+        buckets.order[cursor[variants[i]]++] = i;
+    return buckets;
+}
+
+// cache file: header, then for every rock its vertex and index counts followed by the raw arrays
+struct RockLibraryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+    uint32_t count;
+    uint32_t subdivisions;
+};
+
+bool SaveRockLibrary(const string &path, uint64_t seed, int subdivisions, const vector<RockMeshData> &library)
+{
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "ERROR::ROCK_GENERATOR:: could not write " << path << endl;
+        return false;
+    }
+    RockLibraryHeader header = { {'R', 'O', 'C', 'K'}, 1, seed, (uint32_t)library.size(), (uint32_t)subdivisions };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const RockMeshData &rock : library)
+    {
+        uint32_t counts[2] = { (uint32_t)rock.vertices.size(), (uint32_t)rock.indices.size() };
+        file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+        file.write(reinterpret_cast<const char*>(rock.vertices.data()), rock.vertices.size() * sizeof(Vertex));
+        file.write(reinterpret_cast<const char*>(rock.indices.data()), rock.indices.size() * sizeof(unsigned int));
+    }
+    return file.good();
+}
+
+// only accepts a cache built from the same parameters
+bool LoadRockLibrary(const string &path, uint64_t seed, unsigned int count, int subdivisions, vector<RockMeshData> &library)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+    RockLibraryHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, "ROCK", 4) != 0 || header.version != 1 || header.seed != seed
+        || header.count != count || header.subdivisions != (uint32_t)subdivisions)
+        return false;
+
+    library.assign(count, RockMeshData());
+    for (RockMeshData &rock : library)
+    {
+        uint32_t counts[2];
+        file.read(reinterpret_cast<char*>(counts), sizeof(counts));
+        if (!file)
+            return false;
+        rock.vertices.resize(counts[0]);
+        rock.indices.resize(counts[1]);
+        file.read(reinterpret_cast<char*>(rock.vertices.data()), rock.vertices.size() * sizeof(Vertex));
+        file.read(reinterpret_cast<char*>(rock.indices.data()), rock.indices.size() * sizeof(unsigned int));
+    }
+    return file.good();
+}
+
+// reads the library from cacheDir if it was generated before, otherwise builds and stores it
+vector<RockMeshData> LoadOrGenerateRockLibrary(const string &cacheDir, uint64_t seed, unsigned int count, int subdivisions)
+{
+    string path = cacheDir + "/rocks_" + std::to_string(seed) + "_" + std::to_string(count) + "_" + std::to_string(subdivisions) + ".cache";
+    vector<RockMeshData> library;
+    if (LoadRockLibrary(path, seed, count, subdivisions, library))
+        return library;
+
+    ThreadPool pool;
+    library = GenerateRockLibrary(seed, count, subdivisions, pool);
+    SaveRockLibrary(path, seed, subdivisions, library);
+    return library;
+}
+#endif
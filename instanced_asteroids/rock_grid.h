@@ -0,0 +1,142 @@
+#ifndef ROCK_GRID_H
+#define ROCK_GRID_H
+
+#include <glm/glm.hpp>
+
+#include "rock_generator.h"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+// The rock instances binned into a uniform grid over the belt's x/z plane (the belt is thin in y), so finding the ones
+// near the camera only looks at the cells around it instead of every instance. Cells are row major (z rows, x
+// columns) and the binned slots are ordered by variant, then cell, so one row's run of cells for one variant is a
+// single contiguous range and a query comes out grouped by rock, like the instance buffer it points into.
+class RockGrid
+{
+public:
+    // centers[slot] is where instance 'slot' of the variant grouped buffer sits
+    RockGrid(const glm::vec3 *centers, const RockBuckets &buckets, float cellSize) : cellSize(cellSize)
+    {
+        unsigned int amount = static_cast<unsigned int>(buckets.order.size());
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (unsigned int slot = 0; slot < amount; slot++)
+        {
+            lo = glm::min(lo, centers[slot]);
+            hi = glm::max(hi, centers[slot]);
+        }
+        if (amount == 0)
+            lo = hi = glm::vec3(0.0f);
+        origin = glm::vec2(lo.x, lo.z);
+        cols = static_cast<int>(std::floor((hi.x - lo.x) / cellSize)) + 1;
+        rows = static_cast<int>(std::floor((hi.z - lo.z) / cellSize)) + 1;
+        cellCount = static_cast<size_t>(rows) * cols;
+        variants = static_cast<unsigned int>(buckets.first.size());
+
+        // counting sort on (variant, cell)
+        cellFirst.assign(variants * cellCount + 1, 0);
+        vector<unsigned int> cellOf(amount);
+        for (unsigned int v = 0; v < variants; v++)
+            for (unsigned int slot = buckets.first[v]; slot < buckets.first[v] + buckets.count[v]; slot++)
+            {
+                cellOf[slot] = static_cast<unsigned int>(cellRow(centers[slot].z) * cols + cellColumn(centers[slot].x));
+                cellFirst[v * cellCount + cellOf[slot] + 1]++;
+            }
+        for (size_t c = 1; c < cellFirst.size(); c++)
+            cellFirst[c] += cellFirst[c - 1];
+        slots.resize(amount);
+        slotCenters.resize(amount);
+        vector<unsigned int> cursor(cellFirst.begin(), cellFirst.end() - 1);
+        for (unsigned int v = 0; v < variants; v++)
+            for (unsigned int slot = buckets.first[v]; slot < buckets.first[v] + buckets.count[v]; slot++)
+            {
+                unsigned int j = cursor[v * cellCount + cellOf[slot]]++;
+                slots[j] = slot;
+                slotCenters[j] = centers[slot];
+            }
+    }
+
+    // the matrices of every instance within distance of p, variant v's landing in out[first[v] .. first[v] + count[v]).
+    // Each row of cells is only searched across the width the sphere's shadow on the plane has there
+    void gatherNear(const glm::vec3 &p, float distance, const glm::mat4 *matrices, vector<glm::mat4> &out,
+                    vector<unsigned int> &first, vector<unsigned int> &count) const
+    {
+        out.clear();
+        float d2 = distance * distance;
+        int r0 = cellRow(p.z - distance), r1 = cellRow(p.z + distance);
+        for (unsigned int v = 0; v < variants; v++)
+        {
+            first[v] = static_cast<unsigned int>(out.size());
+            for (int r = r0; r <= r1; r++)
+            {
+                float rowLo = origin.y + r * cellSize;
+                float dz = std::max(std::max(rowLo - p.z, p.z - (rowLo + cellSize)), 0.0f);
+                if (dz > distance)
+                    continue;
+                float half = std::sqrt(d2 - dz * dz);
+                size_t row = v * cellCount + static_cast<size_t>(r) * cols;
+                unsigned int begin = cellFirst[row + cellColumn(p.x - half)];
+                unsigned int end = cellFirst[row + cellColumn(p.x + half) + 1];
+                for (unsigned int j = begin; j < end; j++)
+                {
+                    glm::vec3 d = slotCenters[j] - p;
+                    if (glm::dot(d, d) < d2)
+                        out.push_back(matrices[slots[j]]);
+                }
+            }
+            count[v] = static_cast<unsigned int>(out.size()) - first[v];
+        }
+    }
+
+    // the most instances gatherNear can return at this distance wherever the camera is: every query stays inside a
+    // square window of cells, so the fullest window bounds it. Lets the near buffer be sized once
+    unsigned int maxNear(float distance) const
+    {
+        int w = static_cast<int>(std::ceil(2.0f * distance / cellSize)) + 1;
+        // summed area table of the instances per cell, all variants together
+        vector<unsigned int> sums(static_cast<size_t>(rows + 1) * (cols + 1), 0);
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+            {
+                unsigned int here = 0;
+                for (unsigned int v = 0; v < variants; v++)
+                {
+                    size_t cell = v * cellCount + static_cast<size_t>(r) * cols + c;
+                    here += cellFirst[cell + 1] - cellFirst[cell];
+                }
+                sums[(r + 1) * (cols + 1) + c + 1] = here + sums[r * (cols + 1) + c + 1]
+                                                     + sums[(r + 1) * (cols + 1) + c] - sums[r * (cols + 1) + c];
+            }
+        unsigned int most = 0;
+        for (int r = 0; r + 1 <= rows; r++)
+            for (int c = 0; c + 1 <= cols; c++)
+            {
+                int r1 = std::min(rows, r + w), c1 = std::min(cols, c + w);
+                most = std::max(most, sums[r1 * (cols + 1) + c1] - sums[r * (cols + 1) + c1]
+                                      - sums[r1 * (cols + 1) + c] + sums[r * (cols + 1) + c]);
+            }
+        return most;
+    }
+
+private:
+    float cellSize;
+    glm::vec2 origin;          // x and z of the corner of cell 0
+    int rows = 1, cols = 1;
+    size_t cellCount = 1;
+    unsigned int variants = 0;
+    vector<unsigned int> cellFirst;  // variant * cellCount + cell -> where its slots start, then one past the end
+    vector<unsigned int> slots;      // instance buffer slots, ordered by variant then cell
+    vector<glm::vec3> slotCenters;   // their centers in the same order, so a query reads memory front to back
+
+    int cellRow(float z) const
+    {
+        return std::min(rows - 1, std::max(0, static_cast<int>(std::floor((z - origin.y) / cellSize))));
+    }
+    int cellColumn(float x) const
+    {
+        return std::min(cols - 1, std::max(0, static_cast<int>(std::floor((x - origin.x) / cellSize))));
+    }
+};
+#endif
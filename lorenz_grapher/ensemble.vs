@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// see EnsembleTrails: vertex i is trajectory i % trajectories at slot i / trajectories
+uniform int trajectories;
+uniform int trailLength;
+uniform int head;
+
+out vec3 Color;
+
+vec3 hue(float h)
+{
+	return clamp(abs(mod(h * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+}
+
+void main()
+{
+	int trajectory = gl_VertexID % trajectories;
+	int slot = gl_VertexID / trajectories;
+	// 0 at the tail of the trail, 1 at the head
+	float age = float(slot - head) / float(max(trailLength - 1, 1));
+	Color = hue(float(trajectory) / float(trajectories)) * (0.1 + 0.9 * age);
+	gl_Position = projection * view * vec4(aPos, 1.0);
+}
@@ -0,0 +1,97 @@
+#include <glm/glm.hpp>
+
+#include "lorenz_ensemble.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+
+// Lorenz ensemble throughput, no window needed: ensemble_bench [steps]
+// trajectory steps per second for the glm::vec3 rk4 the demos use against LorenzEnsemble (scalar, AVX2,
+// AVX2 + thread pool). Build with -O2 -mavx2 -mfma, without them the "avx2" rows run the scalar kernel.
+
+using Vec = glm::vec3;
+template<class F>
+Vec rk4(F&& f, const Vec& y, float dt) {
+    Vec k1 = f(y);
+    Vec k2 = f(y + 0.5f*dt*k1);
+    Vec k3 = f(y + 0.5f*dt*k2);
+    Vec k4 = f(y + dt*k3);
+    return y + (dt/6.0f)*(k1+2.0f*k2 + 2.0f*k3 + k4);
+}
+
+const float dt = 1e-3f;
+
+// seconds for one call of run
+double timeRun(const std::function<void()> &run)
+{
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void report(const char *name, double stepsPerSecond, double baseline)
+{
+    std::cout << "  " << std::left << std::setw(20) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << stepsPerSecond / 1e6 << " M steps/s  " << std::setw(6)
+              << stepsPerSecond / baseline << "x" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int steps = argc > 1 ? std::atoi(argv[1]) : 1000;
+    ThreadPool pool;
+#ifndef LORENZ_ENSEMBLE_AVX2
+    std::cout << "built without AVX2/FMA, the simd rows use the scalar kernel" << std::endl;
+#endif
+    std::cout << pool.size() << " worker threads, " << steps << " steps per trajectory" << std::endl;
+
+    const float sigma = 10.0f, rho = 28.0f, beta = 8.0f/3.0f;
+    auto lorenz = [=](const Vec& r) -> Vec {
+        return Vec {
+            sigma * (r.y - r.x),
+            r.x *   (rho - r.z) - r.y,
+            r.x * r.y - beta*r.z
+        };
+    };
+
+    size_t counts[3] = { 1000, 10000, 100000 };
+    for (size_t count : counts)
+    {
+        std::cout << count << " trajectories" << std::endl;
+        double total = (double)count * steps;
+
+        std::vector<Vec> states(count, Vec(-8.0f, 8.0f, 27.0f));
+        double seconds = timeRun([&] {
+            for (Vec &r : states)
+                for (int n = 0; n < steps; n++)
+                    r = rk4(lorenz, r, dt);
+        });
+        double baseline = total / seconds;
+        report("glm rk4", baseline, baseline);
+
+        struct Run { const char *name; ThreadPool *pool; bool simd; };
+        Run runs[] = { { "soa scalar", nullptr, false }, { "soa avx2", nullptr, true }, { "soa avx2 threads", &pool, true } };
+        for (const Run &run : runs)
+        {
+            LorenzEnsemble ensemble(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                ensemble.x[i] = -8.0f;
+                ensemble.y[i] = 8.0f;
+                ensemble.z[i] = 27.0f;
+            }
+            seconds = timeRun([&] { ensemble.step(dt, steps, run.pool, run.simd); });
+            report(run.name, total / seconds, baseline);
+            // keep the result alive and check it against the reference
+            if (glm::length(ensemble.position(0) - states[0]) > 1e-2f)
+                std::cout << "    differs from glm rk4 by " << glm::length(ensemble.position(0) - states[0]) << std::endl;
+        }
+    }
+    return 0;
+}
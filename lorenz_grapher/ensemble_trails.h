@@ -0,0 +1,101 @@
+#ifndef ENSEMBLE_TRAILS_H
+#define ENSEMBLE_TRAILS_H
+
+#include <glad/glad.h>
+
+#include "shader_m.h"
+#include "lorenz_ensemble.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// The last 'length' positions of every trajectory in a LorenzEnsemble, drawn as one line strip per trajectory in a
+// single glDrawElementsBaseVertex call.
+//
+// The VBO is time major: slot t holds all N trajectories, so recording a step is one contiguous upload. Every slot is
+// written twice, at t and t + length, which keeps the newest 'length' slots contiguous as [head, head + length) however
+// far the ring has turned. The index buffer walks trajectory j through slots 0 .. length-1 with a primitive restart
+// between trajectories and never changes; the base vertex head * N slides it onto the current window.
+class EnsembleTrails
+{
+public:
+    static const uint32_t RESTART = 0xFFFFFFFFu;
+
+    // every slot starts out as the ensemble's current positions
+    EnsembleTrails(const LorenzEnsemble &ensemble, size_t length) : trajectories(ensemble.size()), length(length),
+                                                                    staging(ensemble.size() * 3)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, 2 * length * slotBytes(), nullptr, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        std::vector<uint32_t> indices;
+        indices.reserve(trajectories * (length + 1));
+        for (size_t j = 0; j < trajectories; j++)
+        {
+            for (size_t t = 0; t < length; t++)
+                indices.push_back((uint32_t)(t * trajectories + j));
+            indices.push_back(RESTART);
+        }
+        indexCount = indices.size();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        ensemble.writePositions(staging.data());
+        for (size_t t = 0; t < 2 * length; t++)
+            glBufferSubData(GL_ARRAY_BUFFER, t * slotBytes(), slotBytes(), staging.data());
+    }
+
+    // appends the ensemble's current positions as the newest point of every trail
+    void record(const LorenzEnsemble &ensemble)
+    {
+        ensemble.writePositions(staging.data());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, head * slotBytes(), slotBytes(), staging.data());
+        glBufferSubData(GL_ARRAY_BUFFER, (head + length) * slotBytes(), slotBytes(), staging.data());
+        head = head + 1 == length ? 0 : head + 1;
+    }
+
+    // shader is ensemble.vs/fs with projection and view set
+    void Draw(Shader &shader)
+    {
+        shader.use();
+        shader.setInt("trajectories", (int)trajectories);
+        shader.setInt("trailLength", (int)length);
+        shader.setInt("head", (int)head);
+
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(RESTART);
+        glBindVertexArray(VAO);
+        glDrawElementsBaseVertex(GL_LINE_STRIP, (GLsizei)indexCount, GL_UNSIGNED_INT, 0, (GLint)(head * trajectories));
+        glBindVertexArray(0);
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+private:
+    size_t trajectories;
+    size_t length;
+    size_t head = 0; // slot the next record goes into, the oldest one in the window
+    size_t indexCount = 0;
+    std::vector<float> staging;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+
+    size_t slotBytes() const { return trajectories * 3 * sizeof(float); }
+};
+#endif
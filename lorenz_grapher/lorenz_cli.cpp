@@ -0,0 +1,130 @@
+// Lorenz without a window: integrates for a given stretch of sim time as fast as the CPU goes and streams the
+// trajectory to a sim_record.h file that main_new_ani --play can scrub through.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 -pthread -I.. lorenz_cli.cpp -o lorenz_cli
+//   ./lorenz_cli --out lorenz.rec --seconds 1000
+//
+// One trajectory goes through DormandPrince like main_new_ani, with a frame (x, y, z) every --frame-dt from the dense
+// output. --ensemble N runs N perturbed starts through LorenzEnsemble instead, RK4 at 1e-3, and each frame is all N
+// positions. Model parameters in the header: sigma, rho, beta, tolerance (0 for the ensemble), trajectories.
+
+#include <glm/glm.hpp>
+
+#include "ode.h"
+#include "thread_pool.h"
+#include "lorenz_ensemble.h"
+#include "particle_pool.h"
+#include "sim_record.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* outPath = nullptr;
+    double seconds = 100.0;
+    double frameDt = 1e-3;
+    double tolerance = 1e-7;
+    double sigma = 10.0, rho = 28.0, beta = 8.0 / 3.0;
+    unsigned int ensembleCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--frame-dt") == 0 && hasValue)
+            frameDt = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--tol") == 0 && hasValue)
+            tolerance = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--sigma") == 0 && hasValue)
+            sigma = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--rho") == 0 && hasValue)
+            rho = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--beta") == 0 && hasValue)
+            beta = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--ensemble") == 0 && hasValue)
+            ensembleCount = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cerr << "usage: lorenz_cli --out file|- [--seconds T] [--frame-dt dt] [--tol tol] [--sigma s] [--rho r]"
+                      << " [--beta b] [--ensemble N]" << std::endl;
+            return -1;
+        }
+    }
+    if (!outPath)
+    {
+        std::cerr << "ERROR::LORENZ_CLI:: --out is required" << std::endl;
+        return -1;
+    }
+
+    const double ensembleDt = 1e-3;
+    if (ensembleCount)
+        frameDt = std::max(1.0, std::round(frameDt / ensembleDt)) * ensembleDt; // the ensemble stops on whole steps
+    uint64_t frames = (uint64_t)std::llround(seconds / frameDt) + 1;
+    unsigned int trajectories = std::max(1u, ensembleCount);
+    SimRecordWriter writer;
+    if (!writer.open(outPath, ensembleCount ? "lorenz_ensemble" : "lorenz", trajectories * 3, frameDt,
+                     { sigma, rho, beta, ensembleCount ? 0.0 : tolerance, (double)trajectories }))
+        return -1;
+
+    auto start = std::chrono::steady_clock::now();
+    long long evaluations = 0;
+    if (ensembleCount == 0)
+    {
+        auto lorenz = [=](const glm::dvec3& r) {
+            return glm::dvec3(sigma * (r.y - r.x), r.x * (rho - r.z) - r.y, r.x * r.y - beta * r.z);
+        };
+        DormandPrince<glm::dvec3, double> solver(glm::dvec3(-8.0, 8.0, 27.0), tolerance, tolerance);
+        double next = 0.0;
+        bool ok = true;
+        odeSampleEvery(solver, lorenz, next, frameDt, (frames - 0.5) * frameDt, [&](double, const glm::dvec3& r) {
+            float frame[3] = { (float)r.x, (float)r.y, (float)r.z };
+            ok = ok && writer.write(frame);
+        }, (int)std::min<uint64_t>(frames, 0x7FFFFFFF));
+        evaluations = solver.stats.evaluations;
+        if (!ok)
+            return -1;
+    }
+    else
+    {
+        // the same perturbed starts as main_ensemble
+        ThreadPool pool;
+        LorenzEnsemble ensemble(ensembleCount);
+        ParticleRandom random(42);
+        std::vector<float> offsets(ensembleCount * 3);
+        random.uniform(offsets.data(), offsets.size(), -1e-3f, 1e-3f);
+        for (unsigned int i = 0; i < ensembleCount; i++)
+        {
+            ensemble.x[i] = -8.0f + offsets[i * 3 + 0];
+            ensemble.y[i] = 8.0f + offsets[i * 3 + 1];
+            ensemble.z[i] = 27.0f + offsets[i * 3 + 2];
+            ensemble.sigma[i] = (float)sigma;
+            ensemble.rho[i] = (float)rho;
+            ensemble.beta[i] = (float)beta;
+        }
+        const float dt = (float)ensembleDt;
+        int stepsPerFrame = (int)std::lround(frameDt / ensembleDt);
+        std::vector<float> frame(ensembleCount * 3);
+        for (uint64_t f = 0; f < frames; f++)
+        {
+            if (f > 0)
+                ensemble.step(dt, stepsPerFrame, &pool);
+            ensemble.writePositions(frame.data());
+            if (!writer.write(frame.data()))
+                return -1;
+        }
+        evaluations = (long long)(frames - 1) * stepsPerFrame * 4 * ensembleCount;
+    }
+    writer.close();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << writer.frameCount() << " frames of " << trajectories << " trajectories, " << seconds
+              << "s of sim time in " << wall << "s (" << seconds / wall << "x real time), " << evaluations
+              << " evaluations, " << writer.bytesWritten() / 1e6 << " MB" << std::endl;
+    return 0;
+}
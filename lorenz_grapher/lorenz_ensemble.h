@@ -0,0 +1,145 @@
+#ifndef LORENZ_ENSEMBLE_H
+#define LORENZ_ENSEMBLE_H
+
+#include <glm/glm.hpp>
+
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define LORENZ_ENSEMBLE_AVX2 1
+#endif
+
+// one RK4 step of dx/dt = s(y - x), dy/dt = x(r - z) - y, dz/dt = xy - bz. T is float for one trajectory or
+// Lanes8 for eight at once, the arithmetic is written once for both
+template<class T>
+inline void lorenzRk4(T &x, T &y, T &z, const T &s, const T &r, const T &b, const T &h)
+{
+    const T halfH = h * T(0.5f);
+    T k1x = s * (y - x), k1y = x * (r - z) - y, k1z = x * y - b * z;
+    T x2 = x + halfH * k1x, y2 = y + halfH * k1y, z2 = z + halfH * k1z;
+    T k2x = s * (y2 - x2), k2y = x2 * (r - z2) - y2, k2z = x2 * y2 - b * z2;
+    T x3 = x + halfH * k2x, y3 = y + halfH * k2y, z3 = z + halfH * k2z;
+    T k3x = s * (y3 - x3), k3y = x3 * (r - z3) - y3, k3z = x3 * y3 - b * z3;
+    T x4 = x + h * k3x, y4 = y + h * k3y, z4 = z + h * k3z;
+    T k4x = s * (y4 - x4), k4y = x4 * (r - z4) - y4, k4z = x4 * y4 - b * z4;
+    const T sixthH = h * T(1.0f / 6.0f), two = T(2.0f);
+    x = x + sixthH * (k1x + two * (k2x + k3x) + k4x);
+    y = y + sixthH * (k1y + two * (k2y + k3y) + k4y);
+    z = z + sixthH * (k1z + two * (k2z + k3z) + k4z);
+}
+
+#ifdef LORENZ_ENSEMBLE_AVX2
+// eight floats in an AVX register with just the operators lorenzRk4 needs
+struct Lanes8 {
+    __m256 v;
+    Lanes8(__m256 v) : v(v) {}
+    explicit Lanes8(float f) : v(_mm256_set1_ps(f)) {}
+};
+inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return _mm256_add_ps(a.v, b.v); }
+inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return _mm256_sub_ps(a.v, b.v); }
+inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return _mm256_mul_ps(a.v, b.v); }
+#endif
+
+// N independent Lorenz trajectories as structure of arrays, each with its own sigma/rho/beta. The count is padded
+// to a multiple of 8 with harmless extra lanes so the kernel never needs a scalar tail. step() hands blocks of
+// trajectories to the thread pool and each block stays in registers for all of its steps, so advancing many steps
+// at once costs no memory traffic beyond one load and one store per trajectory.
+class LorenzEnsemble
+{
+public:
+    static const size_t GRAIN = 1024; // trajectories per thread pool job, a multiple of 8
+
+    float *x, *y, *z;
+    float *sigma, *rho, *beta;
+
+    explicit LorenzEnsemble(size_t count) : count(count), padded((count + 7) & ~size_t(7))
+    {
+        float** arrays[6] = { &x, &y, &z, &sigma, &rho, &beta };
+        for (float** array : arrays)
+            *array = static_cast<float*>(std::aligned_alloc(32, std::max<size_t>(padded, 8) * sizeof(float)));
+        for (size_t i = 0; i < padded; i++)
+        {
+            x[i] = y[i] = z[i] = 1.0f;
+            sigma[i] = 10.0f;
+            rho[i] = 28.0f;
+            beta[i] = 8.0f / 3.0f;
+        }
+    }
+
+    ~LorenzEnsemble()
+    {
+        float* arrays[6] = { x, y, z, sigma, rho, beta };
+        for (float* array : arrays)
+            std::free(array);
+    }
+
+    LorenzEnsemble(const LorenzEnsemble&) = delete;
+    LorenzEnsemble& operator=(const LorenzEnsemble&) = delete;
+
+    size_t size() const { return count; }
+
+    glm::vec3 position(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+
+    // advances every trajectory 'steps' RK4 steps of dt. simd = false forces the scalar kernel, for the benchmark
+    void step(float dt, int steps, ThreadPool *pool = nullptr, bool simd = true)
+    {
+        auto body = [&](size_t begin, size_t end) { stepRange(dt, steps, begin, end, simd); };
+        if (pool && padded > GRAIN)
+            pool->parallelFor(padded, GRAIN, body);
+        else
+            body(0, padded);
+    }
+
+    // x, y, z per trajectory into out (size() * 3 floats)
+    void writePositions(float *out) const
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i * 3 + 0] = x[i];
+            out[i * 3 + 1] = y[i];
+            out[i * 3 + 2] = z[i];
+        }
+    }
+
+private:
+    size_t count;
+    size_t padded;
+
+    void stepRange(float dt, int steps, size_t begin, size_t end, bool simd)
+    {
+        size_t i = begin;
+#ifdef LORENZ_ENSEMBLE_AVX2
+        if (simd)
+        {
+            Lanes8 h(dt);
+            for (; i + 8 <= end; i += 8)
+            {
+                Lanes8 px = _mm256_load_ps(x + i), py = _mm256_load_ps(y + i), pz = _mm256_load_ps(z + i);
+                Lanes8 s = _mm256_load_ps(sigma + i), r = _mm256_load_ps(rho + i), b = _mm256_load_ps(beta + i);
+                for (int n = 0; n < steps; n++)
+                    lorenzRk4(px, py, pz, s, r, b, h);
+                _mm256_store_ps(x + i, px.v);
+                _mm256_store_ps(y + i, py.v);
+                _mm256_store_ps(z + i, pz.v);
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < end; i++)
+        {
+            float px = x[i], py = y[i], pz = z[i];
+            for (int n = 0; n < steps; n++)
+                lorenzRk4(px, py, pz, sigma[i], rho[i], beta[i], dt);
+            x[i] = px;
+            y[i] = py;
+            z[i] = pz;
+        }
+    }
+};
+#endif
@@ -7,6 +7,9 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "trace_renderer.h"
+#include "trail_ring.h"
 
 #include <iostream>
 #include <vector>
@@ -37,7 +40,8 @@ struct TraceParticle {
 };
 
 const int MAX_TRACE_PARTICLES = 50000;
-std::vector<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
+const int MAX_TRAIL_POINTS = 50000; // the ring makes this free to raise, millions are fine
+ParticlePool<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
 float traceLifeTime = 15.9f;
 int traceSpawnRate = 1000;
 static float timeSinceLastSpawn = 0.0f;
@@ -90,6 +94,7 @@ int main()
 
     // build and compile shaders
     Shader particleShader("particle.vs", "particle.fs");
+    Shader traceShader("trace.vs", "trace.fs");
 
     // Generate the particle positions for our function
     //std::vector<float> particlePositions;
@@ -100,21 +105,11 @@ int main()
     
   //  std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
 
-        // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
+    // all trace particles go out in one buffer upload and one draw call per frame
+    TraceRenderer<TraceParticle> traceRenderer(MAX_TRACE_PARTICLES);
 
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_TRACE_PARTICLES * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // line positions
-    std::vector<float> linePositions;
-    linePositions.reserve(MAX_TRACE_PARTICLES * 3);
+    // line positions: a ring, the oldest point is overwritten once it's full and only new points are uploaded
+    TrailRing trail(MAX_TRAIL_POINTS);
 
 
 
@@ -168,36 +163,22 @@ int main()
         Vec r_new = rk4(lorenz, r_old, dt);
 
         /// Line Positionss:
-        linePositions.push_back(r_new.x);
-        linePositions.push_back(r_new.y);
-        linePositions.push_back(r_new.z);
-        if (linePositions.size() > MAX_TRACE_PARTICLES * 3) {
-            linePositions.erase(linePositions.begin(), linePositions.begin() + 3);
-        }
+        trail.push(r_new);
 
 
         timeSinceLastSpawn += deltaTime;
         if (timeSinceLastSpawn >= 1.0f/traceSpawnRate) {
-            for (auto& particle : traceParticles) {
-                if (particle.life <= 0.0f) {
-                    particle.position = glm::vec3(r_new.x,r_new.y,r_new.z); // spawn at curr position
-                    particle.life = 1.0f;
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles.spawn()) {
+                particle->position = glm::vec3(r_new.x,r_new.y,r_new.z); // spawn at curr position
+                particle->life = 1.0f;
             }
             timeSinceLastSpawn = 0.0f;
         }
 
-        std::vector<float> tracePositions;
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime/traceLifeTime;
-
-                tracePositions.push_back(particle.position.x);
-                tracePositions.push_back(particle.position.y);
-                tracePositions.push_back(particle.position.z);
-            }
-        }
+        traceParticles.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime/traceLifeTime;
+            return particle.life > 0.0f;
+        });
 
 
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
@@ -211,31 +192,15 @@ int main()
         particleShader.setMat4("model", glm::mat4(1.0f));
 
         particleShader.setVec3("color", 1.0f, 1.0f, 1.0f);  // line color
-        glBindVertexArray(particleVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, linePositions.size() * sizeof(float), linePositions.data());
-        glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)(linePositions.size() / 3));
-
+        trail.Upload();
+        trail.Draw();
 
 
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // 1.0 when fresh, 0.0 when dying    
 
-
-                particleShader.setVec3("color", 0.0f, intensity, 0.0f);
-
-   
-
-                glBindVertexArray(particleVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(5.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-
-            }
-        }
+        traceShader.use();
+        traceShader.setMat4("projection", projection);
+        traceShader.setMat4("view", view);
+        traceRenderer.Draw(traceShader, traceParticles, glm::vec3(0.0f, 1.0f, 0.0f), 5.0f);
 
         r_old = r_new;
 
@@ -244,6 +209,8 @@ int main()
         glfwPollEvents();
     }
 
+    traceRenderer.Delete();
+    trail.Delete();
     glfwTerminate();
     return 0;
 
@@ -0,0 +1,210 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "camera.h"
+#include "thread_pool.h"
+#include "lorenz_ensemble.h"
+#include "ensemble_trails.h"
+#include "particle_pool.h"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+
+// settings
+const unsigned int SCR_WIDTH = 1600;
+const unsigned int SCR_HEIGHT = 1200;
+
+// camera
+Camera camera(glm::vec3(0.0f, 7.0f, 40.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// ensemble
+unsigned int trajectoryCount = 10000;
+const int TRAIL_LENGTH = 128;       // points kept per trajectory
+const int STEPS_PER_RECORD = 10;    // RK4 steps between trail points
+bool sweepRho = false;              // false: same parameters, perturbed starts. true: same start, rho from 20 to 32
+
+// usage: main_ensemble [trajectories] [--rho]
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--rho") == 0)
+            sweepRho = true;
+        else
+            trajectoryCount = (unsigned int)std::strtoul(argv[i], nullptr, 10);
+    }
+
+    // glfw: initialize and configure
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+
+    // glfw window creation
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Lorenz Ensemble", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    Shader ensembleShader("ensemble.vs", "ensemble.fs");
+
+    // Lorenz stuff: every trajectory starts a hair away from the same point, or the same point with its own rho
+    LorenzEnsemble ensemble(trajectoryCount);
+    ParticleRandom random(42);
+    std::vector<float> offsets(trajectoryCount * 3);
+    random.uniform(offsets.data(), offsets.size(), -1e-3f, 1e-3f);
+    for (unsigned int i = 0; i < trajectoryCount; i++)
+    {
+        ensemble.x[i] = -8.0f;
+        ensemble.y[i] = 8.0f;
+        ensemble.z[i] = 27.0f;
+        if (sweepRho)
+            ensemble.rho[i] = 20.0f + 12.0f * i / std::max(1u, trajectoryCount - 1);
+        else
+        {
+            ensemble.x[i] += offsets[i * 3 + 0];
+            ensemble.y[i] += offsets[i * 3 + 1];
+            ensemble.z[i] += offsets[i * 3 + 2];
+        }
+    }
+    std::cout << "Integrating " << trajectoryCount << " trajectories" << (sweepRho ? " (rho sweep)" : "") << std::endl;
+
+    ThreadPool pool;
+    EnsembleTrails trails(ensemble, TRAIL_LENGTH);
+
+    float dt = 1e-3f; // time step for numerical integration
+    float simSpeed = 1.5f; // time scale
+    float acc = 0.0f; // leftover time from previous frame
+
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float now = (float)glfwGetTime();
+        deltaTime = now - lastFrame;
+        lastFrame = now;
+
+        processInput(window);
+
+        // render
+        // ------
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // whole trail points' worth of steps, the rest carries over. never more than one trail length a frame
+        acc += deltaTime * simSpeed;
+        int records = std::min((int)(acc / (dt * STEPS_PER_RECORD)), TRAIL_LENGTH);
+        acc = std::min(acc - records * dt * STEPS_PER_RECORD, dt * STEPS_PER_RECORD);
+        for (int n = 0; n < records; n++)
+        {
+            ensemble.step(dt, STEPS_PER_RECORD, &pool);
+            trails.record(ensemble);
+        }
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
+                                                (float)SCR_WIDTH / (float)SCR_HEIGHT, 
+                                                0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        ensembleShader.use();
+        ensembleShader.setMat4("projection", projection);
+        ensembleShader.setMat4("view", view);
+        trails.Draw(ensembleShader);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    trails.Delete();
+    glfwTerminate();
+    return 0;
+
+}
+
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos;
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
\ No newline at end of file
@@ -7,10 +7,19 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "trace_renderer.h"
+#include "trail_ring.h"
+#include "ode.h"
+#include "sim_runner.h"
+#include "sim_record.h"
 
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <array>
+#include <cstdint>
+#include <cstring>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -37,24 +46,65 @@ struct TraceParticle {
 };
 
 const int MAX_TRACE_PARTICLES = 50000;
-std::vector<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
+const int MAX_TRAIL_POINTS = 50000; // the ring makes this free to raise, millions are fine
+ParticlePool<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
 float traceLifeTime = 15.9f;
 int traceSpawnRate = 500;
 static float timeSinceLastSpawn = 0.0f;
 
-using Vec = glm::vec3; // this is really jsut for RK stuff
-template<class F>
-Vec rk4(F&& f, const Vec& y, float dt) {
-    Vec k1 = f(y);
-    Vec k2 = f(y + 0.5f*dt*k1);
-    Vec k3 = f(y + 0.5f*dt*k2);
-    Vec k4 = f(y + dt*k3);
-    return y + (dt/6.0f)*(k1+2.0f*k2 + 2.0f*k3 + k4);
+// --play: a lorenz_cli recording drawn instead of the live solver. Playback runs at simSpeed, left/right arrows scrub
+// and space pauses
+SimRecordReader recording;
+bool playing = false;
+bool playPaused = false;
+double playTime = 0.0;
+
+using Vec = glm::dvec3; // solver state, double so sim time doesn't lose precision over a long run
+
+// what the sim thread owns. Trail points go into a small ring of the newest ones, and 'produced' counts every point
+// ever made so the render thread can tell which it hasn't pushed yet even when it skips snapshots
+const int RECENT_POINTS = 1024;
+struct LorenzModel {
+    DormandPrince<Vec, double> solver;
+    double simTime = 0.0;
+    double nextTrailTime = 0.0;
+    std::array<glm::vec3, RECENT_POINTS> recent{};
+    uint64_t produced = 0;
+
+    glm::vec3 head() const { return produced ? recent[(produced - 1) % RECENT_POINTS] : glm::vec3(solver.state()); }
+};
+
+// the trail as it stands at frame 'target' of the recording, the first trajectory if it holds several. Moving forward
+// only pushes the frames since 'shown', a jump back or further than the trail holds rebuilds it from the mapping
+void showRecording(TrailRing& trail, uint64_t& shown, uint64_t target)
+{
+    uint64_t first = shown + 1;
+    if (trail.size() == 0 || target < shown || target - shown > trail.capacity())
+    {
+        trail.clear();
+        first = target + 1 > trail.capacity() ? target + 1 - trail.capacity() : 0;
+    }
+    for (uint64_t i = first; i <= target; i++)
+    {
+        const float* r = recording.frame(i);
+        trail.push(glm::vec3(r[0], r[1], r[2]));
+    }
+    shown = target;
 }
 
-int main()
+int main(int argc, char** argv)
 
 {
+    if (argc == 3 && std::strcmp(argv[1], "--play") == 0)
+    {
+        if (!recording.open(argv[2]) || recording.frameFloats() % 3 != 0 || recording.frameCount() == 0)
+        {
+            std::cout << "ERROR::PLAYBACK::NOT_A_LORENZ_RECORDING " << argv[2] << std::endl;
+            return -1;
+        }
+        playing = true;
+    }
+
     // glfw: initialize and configure
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -90,6 +140,7 @@ int main()
 
     // build and compile shaders
     Shader particleShader("particle.vs", "particle.fs");
+    Shader traceShader("trace.vs", "trace.fs");
 
     // Generate the particle positions for our function
     //std::vector<float> particlePositions;
@@ -100,21 +151,11 @@ int main()
     
   //  std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
 
-        // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
-
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_TRACE_PARTICLES * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    // all trace particles go out in one buffer upload and one draw call per frame
+    TraceRenderer<TraceParticle> traceRenderer(MAX_TRACE_PARTICLES);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // line positions
-    std::vector<float> linePositions;
-    linePositions.reserve(MAX_TRACE_PARTICLES * 3);
+    // line positions: a ring, the oldest point is overwritten once it's full and only new points are uploaded
+    TrailRing trail(MAX_TRAIL_POINTS);
 
 
 
@@ -129,7 +170,7 @@ int main()
    // const float sigma = 4.0f, rho = 20.0f, beta = 3.0f; // spiral?
  //   const float sigma = 40.0f, rho = 15.0f, beta = 2.0f; // another spiral?
 
-    const float sigma = 10.0f, rho = 28.0f, beta = 8.0f/3.0f; // another spiral?
+    const double sigma = 10.0, rho = 28.0, beta = 8.0/3.0; // another spiral?
 
 
     
@@ -144,13 +185,25 @@ int main()
         };
     };
 
-    Vec r_old = Vec(-8.0f, 8.0f, 27.0f);
-
-
-    float dt = 1e-3f; // time step for numerical integration
-    float simSpeed = 1.5f; // time scale
-    float acc = 0.0f; // leftover time from previous frame
-    const int maxSubsteps = 100000;
+    // the solver picks its own steps (a few hundredths of a second on the attractor), the trail still gets a
+    // point every trailDt of sim time from the dense output
+    const double trailDt = 1e-3; // sim time between trail points
+    const double simSpeed = 1.5; // time scale
+    const double simPeriod = 1.0 / 240.0; // wall time between sim steps
+    LorenzModel start{ DormandPrince<Vec, double>(Vec(-8.0, 8.0, 27.0), 1e-7, 1e-7) };
+    start.nextTrailTime = trailDt;
+    SimRunner<LorenzModel> sim(start, simPeriod, [=](LorenzModel& model) {
+        model.simTime += simPeriod * simSpeed;
+        odeSampleEvery(model.solver, lorenz, model.nextTrailTime, trailDt, model.simTime,
+                       [&](double, const Vec& r) { model.recent[model.produced++ % RECENT_POINTS] = glm::vec3(r); },
+                       RECENT_POINTS);
+    });
+    if (!playing)
+        sim.start();
+    glm::vec3 r_old = start.head();
+    uint64_t consumed = 0; // trail points already pushed
+    uint64_t shown = 0;    // recording frame the trail ends on
+    int frameCounter = 0;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -174,23 +227,32 @@ int main()
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        acc += deltaTime * simSpeed;
-
-        int stepsThisFrame = 0;
-        while (acc >= dt && stepsThisFrame < maxSubsteps) {
-            r_old = rk4(lorenz, r_old, dt);
-            // lines:
-            /// Line Positionss:
-            linePositions.push_back(r_old.x);
-            linePositions.push_back(r_old.y);
-            linePositions.push_back(r_old.z);
-            if (linePositions.size() > MAX_TRACE_PARTICLES * 3) {
-                linePositions.erase(linePositions.begin(), linePositions.begin() + 3);
-            }
-
-            //
-            acc  -= dt;
-            ++stepsThisFrame;
+        // new trail points since last frame (the oldest are gone if a frame took longer than the ring holds), and the
+        // head drawn one sim step behind, blended between the last two steps
+        if (playing)
+        {
+            if (!playPaused)
+                playTime += deltaTime * simSpeed;
+            playTime = std::min(std::max(playTime, 0.0), recording.duration());
+            double position = playTime / recording.header().frameDt;
+            uint64_t frame = std::min((uint64_t)position, recording.frameCount() - 1);
+            showRecording(trail, shown, frame);
+            const float* a = recording.frame(frame);
+            const float* b = recording.frame(std::min(frame + 1, recording.frameCount() - 1));
+            r_old = glm::mix(glm::vec3(a[0], a[1], a[2]), glm::vec3(b[0], b[1], b[2]), (float)(position - frame));
+        }
+        else
+        {
+            const SimSnapshot<LorenzModel>& snapshot = sim.latest();
+            const LorenzModel& model = snapshot.current;
+            consumed = std::max(consumed, model.produced > RECENT_POINTS ? model.produced - RECENT_POINTS : 0);
+            for (; consumed < model.produced; consumed++)
+                trail.push(model.recent[consumed % RECENT_POINTS]);
+            r_old = glm::mix(snapshot.previous.head(), model.head(), (float)sim.alpha());
+
+            sim.recordFrame(deltaTime);
+            if (++frameCounter % 1200 == 0)
+                sim.report();
         }
 
 
@@ -201,24 +263,17 @@ int main()
 
         timeSinceLastSpawn += deltaTime;
         if (timeSinceLastSpawn >= 1.0f/traceSpawnRate) {
-            for (auto& particle : traceParticles) {
-                if (particle.life <= 0.0f) {
-                    particle.position = r_old;
-                    particle.life = 1.0f;
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles.spawn()) {
+                particle->position = r_old;
+                particle->life = 1.0f;
             }
             timeSinceLastSpawn = 0.0f;
         }
 
-//        std::vector<float> tracePositions;
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime/traceLifeTime;
-
-                if (particle.life < 0.0f) particle.life = 0.0f;
-            }
-        }
+        traceParticles.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime/traceLifeTime;
+            return particle.life > 0.0f;
+        });
 
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
                                                     (float)SCR_WIDTH / (float)SCR_HEIGHT, 
@@ -233,36 +288,26 @@ int main()
 
 
         particleShader.setVec3("color", 1.0f, 1.0f, 1.0f);  // line color
-        glBindVertexArray(particleVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, linePositions.size() * sizeof(float), linePositions.data());
-        glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)(linePositions.size() / 3));
-
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // 1.0 when fresh, 0.0 when dying    
-
-  
-                particleShader.setVec3("color", 0.0f, intensity, 0.0f);
-
-   
-
-                glBindVertexArray(particleVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(5.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-
-            }
-        }
-
+        trail.Upload();
+        trail.Draw();
 
+        traceShader.use();
+        traceShader.setMat4("projection", projection);
+        traceShader.setMat4("view", view);
+        traceRenderer.Draw(traceShader, traceParticles, glm::vec3(0.0f, 1.0f, 0.0f), 5.0f);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    traceRenderer.Delete();
+    trail.Delete();
+    if (!playing)
+    {
+        sim.stop();
+        sim.report();
+    }
+    recording.close();
     glfwTerminate();
     return 0;
 
@@ -282,6 +327,20 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (playing)
+    {
+        // scrubbing covers 10 seconds of sim time per second held
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+            playTime -= 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+            playTime += 10.0 * deltaTime;
+        static bool spaceWasDown = false;
+        bool spaceDown = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        if (spaceDown && !spaceWasDown)
+            playPaused = !playPaused;
+        spaceWasDown = spaceDown;
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -7,6 +7,8 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "trace_renderer.h"
 
 #include <iostream>
 #include <vector>
@@ -37,7 +39,7 @@ struct TraceParticle {
 };
 
 const int MAX_TRACE_PARTICLES = 50000;
-std::vector<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
+ParticlePool<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
 float traceLifeTime = 15.9f;
 int traceSpawnRate = 1000;
 static float timeSinceLastSpawn = 0.0f;
@@ -89,7 +91,7 @@ int main()
     glEnable(GL_PROGRAM_POINT_SIZE);  // Allow setting point size in shader
 
     // build and compile shaders
-    Shader particleShader("particle.vs", "particle.fs");
+    Shader traceShader("trace.vs", "trace.fs");
 
     // Generate the particle positions for our function
     //std::vector<float> particlePositions;
@@ -100,17 +102,8 @@ int main()
     
   //  std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
 
-        // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
-
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_TRACE_PARTICLES * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // all trace particles go out in one buffer upload and one draw call per frame
+    TraceRenderer<TraceParticle> traceRenderer(MAX_TRACE_PARTICLES);
 
 
 
@@ -168,53 +161,27 @@ int main()
 
         timeSinceLastSpawn += deltaTime;
         if (timeSinceLastSpawn >= 1.0f/traceSpawnRate) {
-            for (auto& particle : traceParticles) {
-                if (particle.life <= 0.0f) {
-                    particle.position = glm::vec3(r_new.x,r_new.y,r_new.z); // spawn at curr position
-                    particle.life = 1.0f;
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles.spawn()) {
+                particle->position = glm::vec3(r_new.x,r_new.y,r_new.z); // spawn at curr position
+                particle->life = 1.0f;
             }
             timeSinceLastSpawn = 0.0f;
         }
 
-        std::vector<float> tracePositions;
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime/traceLifeTime;
-
-                tracePositions.push_back(particle.position.x);
-                tracePositions.push_back(particle.position.y);
-                tracePositions.push_back(particle.position.z);
-            }
-        }
-
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // 1.0 when fresh, 0.0 when dying    
+        traceParticles.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime/traceLifeTime;
+            return particle.life > 0.0f;
+        });
 
-                glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
-                                                        (float)SCR_WIDTH / (float)SCR_HEIGHT, 
-                                                        0.1f, 100.0f);
-                glm::mat4 view = camera.GetViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 
+                                                (float)SCR_WIDTH / (float)SCR_HEIGHT, 
+                                                0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
 
-                particleShader.use();
-                particleShader.setMat4("projection", projection);
-                particleShader.setMat4("view", view);
-                particleShader.setMat4("model", glm::mat4(1.0f));
-                particleShader.setVec3("color", 0.0f, intensity, 0.0f);
-
-   
-
-                glBindVertexArray(particleVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(4.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-
-            }
-        }
+        traceShader.use();
+        traceShader.setMat4("projection", projection);
+        traceShader.setMat4("view", view);
+        traceRenderer.Draw(traceShader, traceParticles, glm::vec3(0.0f, 1.0f, 0.0f), 4.0f);
 
         r_old = r_new;
 
@@ -223,6 +190,7 @@ int main()
         glfwPollEvents();
     }
 
+    traceRenderer.Delete();
     glfwTerminate();
     return 0;
 
@@ -0,0 +1,328 @@
+#ifndef ODE_H
+#define ODE_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+// Integrators for autonomous systems dy/dt = f(y), shared by the Lorenz and pendulum demos. State is anything with
+// State + State, State - State and Real * State: a float, a glm vector (a double pendulum fits in a vec4), or a small
+// struct with those operators and an odeErrorNorm overload. Each integrator keeps its own time and the previous step,
+// so sample(t) gives the state anywhere inside the last step without stepping there (dense output). That's what lets
+// a trail be sampled at whatever spacing looks good while the solver takes the steps accuracy needs.
+//
+//  Rk4           fixed step, 4 evaluations per step, cubic Hermite between steps
+//  DormandPrince adaptive RK45 with error control, 6 evaluations per accepted step (first same as last), 4th order
+//                interpolant from the step's own stages
+//  Leapfrog      kick-drift-kick for x'' = a(x), 1 evaluation per step, symplectic so energy doesn't drift
+
+struct OdeStats {
+    long long evaluations = 0;
+    long long accepted = 0;
+    long long rejected = 0;
+};
+
+// largest component of |err| / (atol + rtol * max(|a|, |b|)), DormandPrince accepts a step when this is <= 1
+template<class Real>
+inline Real odeErrorNorm(Real err, Real a, Real b, Real atol, Real rtol)
+{
+    return std::abs(err) / (atol + rtol * std::max(std::abs(a), std::abs(b)));
+}
+
+template<glm::length_t L, class T, glm::qualifier Q, class Real>
+inline Real odeErrorNorm(const glm::vec<L, T, Q> &err, const glm::vec<L, T, Q> &a, const glm::vec<L, T, Q> &b,
+                         Real atol, Real rtol)
+{
+    Real worst = 0;
+    for (glm::length_t i = 0; i < L; i++)
+        worst = std::max(worst, odeErrorNorm<Real>((Real)err[i], (Real)a[i], (Real)b[i], atol, rtol));
+    return worst;
+}
+
+// cubic through (y0, slope d0) at s = 0 and (y1, slope d1) at s = 1, slopes already scaled by the step
+template<class State, class Real>
+inline State odeHermite(const State &y0, const State &d0, const State &y1, const State &d1, Real s)
+{
+    Real s2 = s * s, s3 = s2 * s;
+    return (2 * s3 - 3 * s2 + 1) * y0 + (s3 - 2 * s2 + s) * d0 + (-2 * s3 + 3 * s2) * y1 + (s3 - s2) * d1;
+}
+
+// one classic RK4 step, for callers that don't need the rest
+template<class State, class Real, class F>
+inline State rk4Step(F &&f, const State &y, Real h)
+{
+    State k1 = f(y);
+    State k2 = f(y + (h / 2) * k1);
+    State k3 = f(y + (h / 2) * k2);
+    State k4 = f(y + h * k3);
+    return y + (h / 6) * (k1 + Real(2) * (k2 + k3) + k4);
+}
+
+template<class State, class Real = float>
+class Rk4
+{
+public:
+    OdeStats stats;
+
+    Rk4(const State &y0, Real h, Real t0 = 0) : h(h) { reset(y0, t0); }
+
+    void reset(const State &y0, Real t0 = 0)
+    {
+        y = yPrev = y0;
+        t = tPrev = t0;
+        haveSlope = false;
+    }
+
+    // the slope at the end of a step is the first stage of the next, so it's kept for both that and sample()
+    template<class F>
+    void step(F &&f)
+    {
+        if (!haveSlope)
+        {
+            slope = f(y);
+            stats.evaluations++;
+        }
+        State k1 = slope;
+        State k2 = f(y + (h / 2) * k1);
+        State k3 = f(y + (h / 2) * k2);
+        State k4 = f(y + h * k3);
+        yPrev = y;
+        slopePrev = k1;
+        tPrev = t;
+        y = y + (h / 6) * (k1 + Real(2) * (k2 + k3) + k4);
+        t += h;
+        slope = f(y);
+        haveSlope = true;
+        stats.evaluations += 4;
+        stats.accepted++;
+    }
+
+    template<class F>
+    void advanceTo(F &&f, Real tEnd)
+    {
+        while (t < tEnd)
+            step(f);
+    }
+
+    // state at tq, which has to lie in the last step [previousTime(), time()]
+    State sample(Real tq) const
+    {
+        if (t == tPrev)
+            return y;
+        Real span = t - tPrev;
+        return odeHermite(yPrev, span * slopePrev, y, span * slope, (tq - tPrev) / span);
+    }
+
+    const State& state() const { return y; }
+    Real time() const { return t; }
+    Real previousTime() const { return tPrev; }
+    Real stepSize() const { return h; }
+
+private:
+    Real h;
+    Real t, tPrev;
+    State y, yPrev;
+    State slope, slopePrev;
+    bool haveSlope = false;
+};
+
+template<class State, class Real = float>
+class DormandPrince
+{
+public:
+    OdeStats stats;
+    Real atol, rtol;
+    Real hMin, hMax;
+
+    DormandPrince(const State &y0, Real rtol = Real(1e-6), Real atol = Real(1e-6), Real hMax = Real(0.1), Real t0 = 0)
+        : atol(atol), rtol(rtol), hMin(Real(1e-7)), hMax(hMax)
+    {
+        reset(y0, t0);
+    }
+
+    void reset(const State &y0, Real t0 = 0)
+    {
+        y = y0;
+        t = tPrev = t0;
+        h = hMax / 100;
+        haveSlope = false;
+        r1 = y0;
+        k1 = r2 = r3 = r4 = r5 = y0 - y0;
+    }
+
+    // one accepted step, retrying with smaller steps until the error estimate passes (or h hits hMin)
+    template<class F>
+    void step(F &&f)
+    {
+        if (!haveSlope)
+        {
+            k1 = f(y);
+            stats.evaluations++;
+            haveSlope = true;
+        }
+        for (;;)
+        {
+            State k2 = f(y + h * (Real(1.0 / 5) * k1));
+            State k3 = f(y + h * (Real(3.0 / 40) * k1 + Real(9.0 / 40) * k2));
+            State k4 = f(y + h * (Real(44.0 / 45) * k1 + Real(-56.0 / 15) * k2 + Real(32.0 / 9) * k3));
+            State k5 = f(y + h * (Real(19372.0 / 6561) * k1 + Real(-25360.0 / 2187) * k2 + Real(64448.0 / 6561) * k3
+                                  + Real(-212.0 / 729) * k4));
+            State k6 = f(y + h * (Real(9017.0 / 3168) * k1 + Real(-355.0 / 33) * k2 + Real(46732.0 / 5247) * k3
+                                  + Real(49.0 / 176) * k4 + Real(-5103.0 / 18656) * k5));
+            State yNew = y + h * (Real(35.0 / 384) * k1 + Real(500.0 / 1113) * k3 + Real(125.0 / 192) * k4
+                                  + Real(-2187.0 / 6784) * k5 + Real(11.0 / 84) * k6);
+            State k7 = f(yNew);
+            stats.evaluations += 6;
+
+            // difference between the 5th and embedded 4th order solutions
+            State err = h * (Real(71.0 / 57600) * k1 + Real(-71.0 / 16695) * k3 + Real(71.0 / 1920) * k4
+                             + Real(-17253.0 / 339200) * k5 + Real(22.0 / 525) * k6 + Real(-1.0 / 40) * k7);
+            Real e = odeErrorNorm(err, y, yNew, atol, rtol);
+            Real factor = e > 0 ? Real(0.9) * std::pow(e, Real(-0.2)) : Real(5);
+            factor = std::min(Real(5), std::max(Real(0.2), factor));
+
+            if (e <= 1 || h <= hMin)
+            {
+                // interpolant coefficients, from Hairer's dopri5 dense output
+                State dy = yNew - y;
+                State bspl = h * k1 - dy;
+                r1 = y;
+                r2 = dy;
+                r3 = bspl;
+                r4 = dy - h * k7 - bspl;
+                r5 = h * (Real(-12715105075.0 / 11282082432) * k1 + Real(87487479700.0 / 32700410799) * k3
+                          + Real(-10690763975.0 / 1880347072) * k4 + Real(701980252875.0 / 199316789632) * k5
+                          + Real(-1453857185.0 / 822651844) * k6 + Real(69997945.0 / 29380423) * k7);
+                tPrev = t;
+                t += h;
+                y = yNew;
+                k1 = k7;
+                h = std::min(hMax, h * factor);
+                stats.accepted++;
+                return;
+            }
+            stats.rejected++;
+            h = std::max(hMin, h * std::min(Real(1), factor));
+        }
+    }
+
+    template<class F>
+    void advanceTo(F &&f, Real tEnd)
+    {
+        while (t < tEnd)
+            step(f);
+    }
+
+    // state at tq, which has to lie in the last step [previousTime(), time()]
+    State sample(Real tq) const
+    {
+        if (t == tPrev)
+            return y;
+        Real s = (tq - tPrev) / (t - tPrev), s1 = 1 - s;
+        return r1 + s * (r2 + s1 * (r3 + s * (r4 + s1 * r5)));
+    }
+
+    const State& state() const { return y; }
+    Real time() const { return t; }
+    Real previousTime() const { return tPrev; }
+    Real stepSize() const { return h; }
+
+private:
+    Real h;
+    Real t, tPrev;
+    State y;
+    State k1;
+    State r1, r2, r3, r4, r5;
+    bool haveSlope = false;
+};
+
+// x'' = a(x) with a fixed step, positions and velocities stay in step with each other (velocity Verlet)
+template<class State, class Real = float>
+class Leapfrog
+{
+public:
+    OdeStats stats;
+
+    Leapfrog(const State &x0, const State &v0, Real h, Real t0 = 0) : h(h) { reset(x0, v0, t0); }
+
+    void reset(const State &x0, const State &v0, Real t0 = 0)
+    {
+        x = xPrev = x0;
+        v = vPrev = v0;
+        a = x0 - x0;
+        t = tPrev = t0;
+        haveAccel = false;
+    }
+
+    template<class A>
+    void step(A &&accel)
+    {
+        if (!haveAccel)
+        {
+            a = accel(x);
+            stats.evaluations++;
+            haveAccel = true;
+        }
+        xPrev = x;
+        vPrev = v;
+        tPrev = t;
+        State vHalf = v + (h / 2) * a;
+        x = x + h * vHalf;
+        a = accel(x);
+        v = vHalf + (h / 2) * a;
+        t += h;
+        stats.evaluations++;
+        stats.accepted++;
+    }
+
+    template<class A>
+    void advanceTo(A &&accel, Real tEnd)
+    {
+        while (t < tEnd)
+            step(accel);
+    }
+
+    // position at tq in the last step, cubic Hermite through the two ends
+    State sample(Real tq) const
+    {
+        if (t == tPrev)
+            return x;
+        Real span = t - tPrev;
+        return odeHermite(xPrev, span * vPrev, x, span * v, (tq - tPrev) / span);
+    }
+
+    const State& position() const { return x; }
+    const State& velocity() const { return v; }
+    Real time() const { return t; }
+    Real previousTime() const { return tPrev; }
+    Real stepSize() const { return h; }
+
+private:
+    Real h;
+    Real t, tPrev;
+    State x, xPrev;
+    State v, vPrev;
+    State a;
+    bool haveAccel = false;
+};
+
+// hands emit(t, state) the solution every 'interval' from 'next' up to tEnd, stepping the solver only as far as that
+// needs. next is left at the first sample time not yet emitted; at most maxSamples are emitted per call so a long
+// stall can't turn into an endless catch-up
+template<class Solver, class F, class Emit, class Real>
+inline int odeSampleEvery(Solver &solver, F &&f, Real &next, Real interval, Real tEnd, Emit &&emit,
+                          int maxSamples = 100000)
+{
+    int samples = 0;
+    while (next <= tEnd && samples < maxSamples)
+    {
+        while (solver.time() < next)
+            solver.step(f);
+        emit(next, solver.sample(next));
+        next += interval;
+        samples++;
+    }
+    return samples;
+}
+#endif
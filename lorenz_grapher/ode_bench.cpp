@@ -0,0 +1,115 @@
+// Function evaluations per simulated second for the ode.h integrators at matched accuracy.
+//
+//   g++ -O2 -std=c++17 -I.. ode_bench.cpp -o ode_bench && ./ode_bench
+//
+// Lorenz: error at t = T against a very fine RK4 reference, for a sweep of RK4 step sizes and DormandPrince
+// tolerances. Pendulum: the same for Leapfrog, RK4 and DormandPrince on theta'' = -(g/L) sin(theta), plus how much
+// energy each one has gained or lost after a long run. Everything runs in double so the numbers show the method
+// error rather than float rounding.
+
+#include <glm/glm.hpp>
+
+#include "ode.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+using Vec = glm::dvec3;
+
+static Vec lorenz(const Vec &r)
+{
+    const double sigma = 10.0, rho = 28.0, beta = 8.0 / 3.0;
+    return Vec(sigma * (r.y - r.x), r.x * (rho - r.z) - r.y, r.x * r.y - beta * r.z);
+}
+
+static void row(const char *method, const char *param, double value, double error, long long evaluations, double T)
+{
+    std::cout << std::left << std::setw(16) << method << std::setw(6) << param << std::setw(12) << value
+              << std::setw(14) << error << std::fixed << std::setprecision(0) << evaluations / T
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setprecision(3);
+
+    // lorenz, short enough that the chaos doesn't swamp the comparison
+    const double T = 2.0;
+    const Vec start(-8.0, 8.0, 27.0);
+    Vec reference = start;
+    for (int i = 0; i < 2000000; i++)
+        reference = rk4Step(lorenz, reference, 1e-6);
+
+    std::cout << "lorenz to t = " << T << "\n";
+    std::cout << std::left << std::setw(16) << "method" << std::setw(6) << "" << std::setw(12) << "value"
+              << std::setw(14) << "error" << "evals/sim s" << std::endl;
+    for (double h : { 1e-2, 5e-3, 2e-3, 1e-3, 5e-4 })
+    {
+        Rk4<Vec, double> rk(start, h);
+        rk.advanceTo(lorenz, T - h / 2);
+        row("rk4", "h", h, glm::length(rk.state() - reference), rk.stats.evaluations, T);
+    }
+    for (double tol : { 1e-4, 1e-6, 1e-8, 1e-10 })
+    {
+        DormandPrince<Vec, double> dp(start, tol, tol, 1.0);
+        dp.advanceTo(lorenz, T);
+        row("dormand-prince", "tol", tol, glm::length(dp.sample(T) - reference), dp.stats.evaluations, T);
+    }
+
+    // simple pendulum from 170 degrees, nearly over the top so the period is long and the motion far from linear
+    const double g = 9.81, L = 3.0, theta0 = 170.0 * M_PI / 180.0;
+    auto accel = [=](double theta) { return -(g / L) * std::sin(theta); };
+    auto field = [=](const glm::dvec2 &s) { return glm::dvec2(s.y, -(g / L) * std::sin(s.x)); };
+    auto energy = [=](double theta, double omega) { return 0.5 * L * L * omega * omega + g * L * (1 - std::cos(theta)); };
+    const double E0 = energy(theta0, 0.0);
+
+    const double P = 10.0;
+    glm::dvec2 pendulumRef(theta0, 0.0);
+    for (int i = 0; i < 10000000; i++)
+        pendulumRef = rk4Step(field, pendulumRef, 1e-6);
+
+    std::cout << "\npendulum to t = " << P << "\n";
+    for (double h : { 1e-2, 1e-3, 1e-4 })
+    {
+        Leapfrog<double, double> lf(theta0, 0.0, h);
+        lf.advanceTo(accel, P - h / 2);
+        row("leapfrog", "h", h, std::abs(lf.position() - pendulumRef.x), lf.stats.evaluations, P);
+    }
+    for (double h : { 1e-2, 1e-3 })
+    {
+        Rk4<glm::dvec2, double> rk(glm::dvec2(theta0, 0.0), h);
+        rk.advanceTo(field, P - h / 2);
+        row("rk4", "h", h, std::abs(rk.state().x - pendulumRef.x), rk.stats.evaluations, P);
+    }
+    for (double tol : { 1e-4, 1e-6, 1e-8 })
+    {
+        DormandPrince<glm::dvec2, double> dp(glm::dvec2(theta0, 0.0), tol, tol, 1.0);
+        dp.advanceTo(field, P);
+        row("dormand-prince", "tol", tol, std::abs(dp.sample(P).x - pendulumRef.x), dp.stats.evaluations, P);
+    }
+
+    // long run energy at about the same number of evaluations: leapfrog's error stays bounded, the Runge-Kutta
+    // ones creep
+    const double longRun = 10000.0;
+    std::cout << "\nrelative energy change after t = " << longRun << "\n";
+    {
+        Leapfrog<double, double> lf(theta0, 0.0, 1e-2);
+        lf.advanceTo(accel, longRun);
+        std::cout << "leapfrog h 1e-2        " << (energy(lf.position(), lf.velocity()) - E0) / E0
+                  << "  (" << lf.stats.evaluations << " evaluations)" << std::endl;
+    }
+    {
+        Rk4<glm::dvec2, double> rk(glm::dvec2(theta0, 0.0), 4e-2);
+        rk.advanceTo(field, longRun);
+        std::cout << "rk4 h 4e-2             " << (energy(rk.state().x, rk.state().y) - E0) / E0
+                  << "  (" << rk.stats.evaluations << " evaluations)" << std::endl;
+    }
+    {
+        DormandPrince<glm::dvec2, double> dp(glm::dvec2(theta0, 0.0), 1e-6, 1e-6, 1.0);
+        dp.advanceTo(field, longRun);
+        std::cout << "dormand-prince tol 1e-6 " << (energy(dp.state().x, dp.state().y) - E0) / E0
+                  << "  (" << dp.stats.evaluations << " evaluations)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#ifndef SIM_RECORD_H
+#define SIM_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A recorded run: one SimRecordHeader, then frames of frameFloats floats each, back to back, so frame i starts at
+// headerBytes + i * frameFloats * 4 and the whole file can be mapped and indexed in place. Frames are frameDt of sim
+// time apart starting at startTime. frameCount is patched in when the writer closes; a file whose writer never got
+// there (killed part way through a long run) has 0 and the reader counts whole frames from the file size instead.
+// Everything is in the byte order of the machine that wrote it.
+struct SimRecordHeader {
+    char magic[8];          // "SIMREC" then version 1
+    uint32_t headerBytes;   // frames start here
+    uint32_t frameFloats;
+    uint64_t frameCount;
+    double frameDt;
+    double startTime;
+    char model[32];         // which solver wrote it, e.g. "lorenz", "double_pendulum"
+    uint32_t paramCount;
+    uint32_t reserved0;
+    double params[20];      // model parameters in the order the writer documents
+    char reserved[16];
+};
+static_assert(sizeof(SimRecordHeader) == 256, "frames start 256 bytes in");
+
+static const char SIM_RECORD_MAGIC[8] = { 'S', 'I', 'M', 'R', 'E', 'C', 0, 1 };
+
+// streams frames through a large stdio buffer, nothing is held in memory. A path of "-" writes to stdout so a run
+// can be piped straight into something else; the frame count can't be patched in then, and errors go to stderr so
+// they never end up in the data
+class SimRecordWriter
+{
+public:
+    SimRecordWriter() {}
+    ~SimRecordWriter() { close(); }
+
+    SimRecordWriter(const SimRecordWriter&) = delete;
+    SimRecordWriter& operator=(const SimRecordWriter&) = delete;
+
+    bool open(const char *path, const char *model, uint32_t frameFloats, double frameDt,
+              const std::vector<double> &params, double startTime = 0.0)
+    {
+        close();
+        toStdout = std::strcmp(path, "-") == 0;
+        file = toStdout ? stdout : std::fopen(path, "wb");
+        if (!file)
+        {
+            std::cerr << "ERROR::SIM_RECORD::FILE_NOT_OPENED " << path << std::endl;
+            return false;
+        }
+        // stdout outlives the writer, so stdio gets to own its buffer; a file's is ours and goes when it closes
+        if (toStdout)
+            std::setvbuf(file, nullptr, _IOFBF, 1 << 22);
+        else
+        {
+            buffer.resize(1 << 22);
+            std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+        }
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, SIM_RECORD_MAGIC, sizeof(header.magic));
+        header.headerBytes = sizeof(SimRecordHeader);
+        header.frameFloats = frameFloats;
+        header.frameDt = frameDt;
+        header.startTime = startTime;
+        std::strncpy(header.model, model, sizeof(header.model) - 1);
+        header.paramCount = (uint32_t)std::min<size_t>(params.size(), 20);
+        for (uint32_t i = 0; i < header.paramCount; i++)
+            header.params[i] = params[i];
+        frames = 0;
+        return std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    // frameFloats floats
+    bool write(const float *frame)
+    {
+        if (!file || std::fwrite(frame, sizeof(float), header.frameFloats, file) != header.frameFloats)
+        {
+            std::cerr << "ERROR::SIM_RECORD::WRITE_FAILED" << std::endl;
+            return false;
+        }
+        frames++;
+        return true;
+    }
+
+    // writes the frame count into the header and closes the file
+    void close()
+    {
+        if (!file)
+            return;
+        if (toStdout)
+            std::fflush(file);
+        else
+        {
+            header.frameCount = frames;
+            std::fseek(file, 0, SEEK_SET);
+            std::fwrite(&header, sizeof(header), 1, file);
+            std::fclose(file);
+        }
+        file = nullptr;
+    }
+
+    uint64_t frameCount() const { return frames; }
+    uint64_t bytesWritten() const { return sizeof(SimRecordHeader) + frames * header.frameFloats * sizeof(float); }
+
+private:
+    FILE *file = nullptr;
+    bool toStdout = false;
+    SimRecordHeader header;
+    uint64_t frames = 0;
+    std::vector<char> buffer;
+};
+
+// maps a recording read only, frames are read straight out of the mapping and the OS pages them in as they're touched
+class SimRecordReader
+{
+public:
+    SimRecordReader() {}
+    ~SimRecordReader() { close(); }
+
+    SimRecordReader(const SimRecordReader&) = delete;
+    SimRecordReader& operator=(const SimRecordReader&) = delete;
+
+    bool open(const char *path)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            std::cout << "ERROR::SIM_RECORD::FILE_NOT_OPENED " << path << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SimRecordHeader))
+        {
+            std::cout << "ERROR::SIM_RECORD::FILE_TOO_SHORT " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        bytes = (size_t)info.st_size;
+        void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            std::cout << "ERROR::SIM_RECORD::MAP_FAILED " << path << std::endl;
+            return false;
+        }
+        base = static_cast<const unsigned char*>(mapped);
+        const SimRecordHeader &h = header();
+        if (std::memcmp(h.magic, SIM_RECORD_MAGIC, sizeof(h.magic)) != 0 || h.frameFloats == 0 || h.headerBytes > bytes)
+        {
+            std::cout << "ERROR::SIM_RECORD::NOT_A_RECORDING " << path << std::endl;
+            close();
+            return false;
+        }
+        uint64_t whole = (bytes - h.headerBytes) / frameBytes();
+        count = h.frameCount && h.frameCount <= whole ? h.frameCount : whole;
+        return true;
+    }
+
+    void close()
+    {
+        if (base)
+            munmap(const_cast<unsigned char*>(base), bytes);
+        base = nullptr;
+        bytes = 0;
+        count = 0;
+    }
+
+    const SimRecordHeader& header() const { return *reinterpret_cast<const SimRecordHeader*>(base); }
+    uint64_t frameCount() const { return count; }
+    uint32_t frameFloats() const { return header().frameFloats; }
+    double timeOf(uint64_t frame) const { return header().startTime + frame * header().frameDt; }
+    double duration() const { return count ? timeOf(count - 1) - header().startTime : 0.0; }
+
+    // frame i, i < frameCount()
+    const float* frame(uint64_t i) const
+    {
+        return reinterpret_cast<const float*>(base + header().headerBytes + i * frameBytes());
+    }
+
+private:
+    const unsigned char *base = nullptr;
+    size_t bytes = 0;
+    uint64_t count = 0;
+
+    size_t frameBytes() const { return (size_t)header().frameFloats * sizeof(float); }
+};
+#endif
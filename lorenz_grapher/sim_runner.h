@@ -0,0 +1,270 @@
+#ifndef SIM_RUNNER_H
+#define SIM_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Single writer, single reader hand-off of the latest value. The writer fills its own slot and swaps it with the
+// shared middle one; the reader swaps the middle slot with its own only when something new has been published. Neither
+// side ever waits on the other and neither ever sees a slot the other is still working on.
+template<class T>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const T &initial) : slots{ initial, initial, initial } {}
+
+    // writer side: fill this, then publish()
+    T& writeSlot() { return slots[back]; }
+    void publish() { back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // reader side: picks up the newest published value if there is one, returns whether it did
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& read() const { return slots[front]; }
+
+private:
+    static const unsigned INDEX = 3, FRESH = 4;
+    T slots[3];
+    std::atomic<unsigned> middle{ 0 };
+    unsigned back = 1;  // only touched by the writer
+    unsigned front = 2; // only touched by the reader
+};
+
+// Durations in quarter-octave buckets from 1 microsecond to about a minute. record() is wait free so one thread can
+// fill it while another prints it.
+class TimingHistogram
+{
+public:
+    static const int BUCKETS = 104;
+
+    void record(double seconds)
+    {
+        double us = std::max(seconds * 1e6, 1.0);
+        int bucket = std::min(BUCKETS - 1, (int)(4.0 * std::log2(us)));
+        counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add((uint64_t)(seconds * 1e9), std::memory_order_relaxed);
+        uint64_t ns = (uint64_t)(seconds * 1e9), seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? sumNs.load(std::memory_order_relaxed) * 1e-9 / count() : 0.0; }
+    double max() const { return maxNs.load(std::memory_order_relaxed) * 1e-9; }
+
+    // upper edge of the bucket holding the p-th fraction of samples, never past the largest one seen
+    double percentile(double p) const
+    {
+        uint64_t n = count(), seen = 0;
+        if (n == 0)
+            return 0.0;
+        for (int b = 0; b < BUCKETS; b++)
+        {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= p * n)
+                return std::min(std::exp2((b + 1) / 4.0) * 1e-6, max());
+        }
+        return max();
+    }
+
+    void print(const char *name) const
+    {
+        std::cout << std::fixed << std::setprecision(3) << name << ": " << count() << " samples, mean "
+                  << mean() * 1e3 << "ms, p50 " << percentile(0.5) * 1e3 << "ms, p99 " << percentile(0.99) * 1e3
+                  << "ms, max " << max() * 1e3 << "ms" << std::defaultfloat << std::endl;
+    }
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{ 0 };
+    std::atomic<uint64_t> sumNs{ 0 };
+    std::atomic<uint64_t> maxNs{ 0 };
+};
+
+// what the renderer reads of the model after two consecutive steps, enough to draw anything in between
+template<class View>
+struct SimSnapshot {
+    View previous;
+    View current;
+    uint64_t step = 0;
+    double dueAt = 0.0; // seconds since the runner started at which 'current' was due
+};
+
+// Steps a Model on its own thread every 'period' seconds of wall time, whatever the render loop is doing, and hands
+// the last two states to the render thread through a TripleBuffer. The renderer draws one step behind, blending
+// previous into current by alpha(), so motion stays smooth at any frame rate and a slow frame never changes the
+// physics. If the sim thread falls more than maxCatchUp steps behind it drops the backlog instead of spiralling.
+//
+// The model belongs to the sim thread once start() is called; anything the render thread wants to change (a reset,
+// a drag) goes through post(), which runs it on the sim thread before the next step.
+//
+// Snapshots hold a View of the model, by default all of it. A model too big to copy every step passes a capture
+// function that fills a View with just what the renderer reads (one grid of a wave model, say); it writes into the
+// same View objects over and over, so a View that reuses its storage on assignment never allocates.
+template<class Model, class View = Model>
+class SimRunner
+{
+public:
+    typedef std::function<void(Model&)> StepFunction;
+    typedef std::function<void(const Model&, View&)> CaptureFunction;
+
+    TimingHistogram stepTimes;  // time spent inside each step
+    TimingHistogram frameTimes; // whatever the render thread passes to recordFrame()
+    int maxCatchUp = 8;
+
+    SimRunner(const Model &initial, double period, StepFunction step)
+        : model(initial), previous(initial), period(period), stepModel(std::move(step)),
+          capture([](const Model &from, View &to) { to = from; }),
+          buffer(SimSnapshot<View>{ initial, initial, 0, 0.0 }), startTime(Clock::now()) {}
+
+    // the View has to be default constructible here, capture fills it in
+    SimRunner(const Model &initial, double period, StepFunction step, CaptureFunction capture)
+        : model(initial), period(period), stepModel(std::move(step)), capture(std::move(capture)),
+          buffer(firstSnapshot(initial, this->capture)), startTime(Clock::now())
+    {
+        this->capture(initial, previous);
+    }
+
+    ~SimRunner() { stop(); }
+
+    SimRunner(const SimRunner&) = delete;
+    SimRunner& operator=(const SimRunner&) = delete;
+
+    void start()
+    {
+        if (running.exchange(true))
+            return;
+        startTime = Clock::now();
+        thread = std::thread([this] { run(); });
+    }
+
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        thread.join();
+    }
+
+    // runs on the sim thread before its next step
+    void post(StepFunction command)
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.push_back(std::move(command));
+    }
+
+    // render thread: the newest snapshot, fetched at most once per call
+    const SimSnapshot<View>& latest()
+    {
+        buffer.update();
+        return buffer.read();
+    }
+
+    // render thread: how far between latest().previous and latest().current to draw right now, 0 to 1
+    double alpha() const
+    {
+        double now = std::chrono::duration<double>(Clock::now() - startTime).count();
+        return std::min(1.0, std::max(0.0, (now - buffer.read().dueAt) / period));
+    }
+
+    void recordFrame(double seconds) { frameTimes.record(seconds); }
+
+    uint64_t droppedSteps() const { return dropped.load(std::memory_order_relaxed); }
+    double stepPeriod() const { return period; }
+
+    void report() const
+    {
+        std::cout << "sim runner: " << 1.0 / period << " steps/s, " << droppedSteps() << " dropped" << std::endl;
+        stepTimes.print("  sim step");
+        frameTimes.print("  frame");
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Model model;
+    View previous; // the model as it was before its latest step
+    double period;
+    StepFunction stepModel;
+    CaptureFunction capture;
+    TripleBuffer<SimSnapshot<View>> buffer;
+
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::thread thread;
+    Clock::time_point startTime;
+
+    std::mutex commandMutex;
+    std::vector<StepFunction> commands;
+    std::vector<StepFunction> pendingCommands; // sim thread's copy, swapped with commands
+
+    static SimSnapshot<View> firstSnapshot(const Model &initial, const CaptureFunction &capture)
+    {
+        SimSnapshot<View> snapshot;
+        capture(initial, snapshot.current);
+        snapshot.previous = snapshot.current;
+        return snapshot;
+    }
+
+    void run()
+    {
+        uint64_t steps = 0;
+        Clock::duration tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(period));
+        Clock::time_point due = startTime + tick;
+        while (running.load(std::memory_order_relaxed))
+        {
+            {
+                std::lock_guard<std::mutex> lock(commandMutex);
+                pendingCommands.swap(commands);
+            }
+            for (StepFunction &command : pendingCommands)
+                command(model);
+            pendingCommands.clear();
+
+            int taken = 0;
+            while (Clock::now() >= due && taken < maxCatchUp)
+            {
+                Clock::time_point begin = Clock::now();
+                capture(model, previous);
+                stepModel(model);
+                stepTimes.record(std::chrono::duration<double>(Clock::now() - begin).count());
+                steps++;
+                taken++;
+                due += tick;
+            }
+            if (taken == maxCatchUp && Clock::now() >= due)
+            {
+                // too far behind to catch up, let the missed steps go
+                Clock::time_point now = Clock::now();
+                dropped.fetch_add((uint64_t)((now - due) / tick) + 1, std::memory_order_relaxed);
+                due = now + tick;
+            }
+
+            if (taken > 0)
+            {
+                // the slot's old previous is stale either way, so it's swapped out rather than copied over
+                SimSnapshot<View> &slot = buffer.writeSlot();
+                std::swap(slot.previous, previous);
+                capture(model, slot.current);
+                slot.step = steps;
+                slot.dueAt = std::chrono::duration<double>(due - tick - startTime).count();
+                buffer.publish();
+            }
+            std::this_thread::sleep_until(due);
+        }
+    }
+};
+#endif
@@ -0,0 +1,97 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+// A fixed set of worker threads pulling jobs off a shared queue. parallelFor splits an index range into chunks and
+// blocks until every chunk is done, which is all the demos need.
+class ThreadPool
+{
+public:
+    // threads = 0 uses one worker per hardware thread
+    ThreadPool(unsigned int threads = 0)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threads; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // calls body(begin, end) over [0, count) in chunks of at most 'grain' indices, returns once all have run
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(1, grain);
+        size_t chunks = (count + grain - 1) / grain;
+
+        std::mutex doneMutex;
+        std::condition_variable doneCv;
+        size_t remaining = chunks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t c = 0; c < chunks; c++)
+            {
+                size_t begin = c * grain;
+                size_t end = std::min(count, begin + grain);
+                jobs.push_back([&, begin, end] {
+                    body(begin, end);
+                    std::lock_guard<std::mutex> doneLock(doneMutex);
+                    if (--remaining == 0)
+                        doneCv.notify_one();
+                });
+            }
+        }
+        wake.notify_all();
+
+        std::unique_lock<std::mutex> doneLock(doneMutex);
+        doneCv.wait(doneLock, [&] { return remaining == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+#endif
@@ -0,0 +1,70 @@
+#ifndef TRACE_RENDERER_H
+#define TRACE_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "shader_m.h"
+#include "particle_pool.h"
+
+#include <cstddef>
+
+// Draws every live particle of a ParticlePool as GL_POINTS with one upload and one draw call. The pool's live range
+// is already packed, so it goes to the GPU as is: position is attribute 0 and life attribute 1, read straight out of
+// the particle struct with its own stride. trace.vs/fs scale the colour by life, so the fade needs no per particle
+// uniforms. Particle needs a glm::vec3 'position' and a float 'life'.
+template<class Particle>
+class TraceRenderer
+{
+public:
+    explicit TraceRenderer(size_t capacity) : capacity(capacity)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Particle), nullptr, GL_STREAM_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, life));
+        glBindVertexArray(0);
+    }
+
+    // shader is trace.vs/fs with projection and view already set for the frame
+    void Draw(Shader &shader, ParticlePool<Particle> &pool, const glm::vec3 &color, float pointSize)
+    {
+        size_t count = pool.size() < capacity ? pool.size() : capacity;
+        if (count == 0)
+            return;
+
+        shader.use();
+        shader.setVec3("color", color);
+        shader.setFloat("pointSize", pointSize);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        // orphan last frame's storage so the upload doesn't wait on draws still reading it
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Particle), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Particle), pool.data());
+
+        glBindVertexArray(VAO);
+        glPointSize(pointSize);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+        glBindVertexArray(0);
+    }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+
+private:
+    unsigned int VAO = 0, VBO = 0;
+    size_t capacity;
+};
+#endif
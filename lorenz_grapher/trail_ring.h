@@ -0,0 +1,105 @@
+#ifndef TRAIL_RING_H
+#define TRAIL_RING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// Fixed length trail kept as a circular buffer, mirrored in a VBO of the same layout. push() overwrites the oldest
+// point once the trail is full, so adding a point costs the same at any length, and Upload() only sends the points
+// pushed since the last upload (at most two glBufferSubData calls when they straddle the wrap).
+//
+// The VBO has one slot more than the trail holding a copy of point 0, so once the ring has wrapped the older half
+// [head, capacity] runs straight on into point 0 and the trail draws as two line strips with no gap at the seam.
+class TrailRing
+{
+public:
+    explicit TrailRing(size_t capacity) : points(capacity), cap(capacity)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (cap + 1) * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    void push(const glm::vec3 &point)
+    {
+        points[head] = point;
+        head = head + 1 == cap ? 0 : head + 1;
+        if (count < cap)
+            count++;
+        if (pending < cap)
+            pending++;
+    }
+
+    // sends the points pushed since the last call
+    void Upload()
+    {
+        if (pending == 0)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        size_t start = (head + cap - pending) % cap;
+        if (start + pending <= cap)
+            uploadRange(start, pending);
+        else
+        {
+            uploadRange(start, cap - start);
+            uploadRange(0, pending - (cap - start));
+        }
+        pending = 0;
+    }
+
+    // oldest to newest as GL_LINE_STRIP, with whatever shader is bound
+    void Draw()
+    {
+        if (count < 2)
+            return;
+        glBindVertexArray(VAO);
+        if (count < cap || head == 0)
+            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)count);
+        else
+        {
+            glDrawArrays(GL_LINE_STRIP, (GLint)head, (GLsizei)(cap - head + 1)); // ends on the copy of point 0
+            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)head);
+        }
+        glBindVertexArray(0);
+    }
+
+    void clear() { head = count = pending = 0; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+    // most recent point, the trail must not be empty
+    const glm::vec3& back() const { return points[head == 0 ? cap - 1 : head - 1]; }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+
+private:
+    std::vector<glm::vec3> points;
+    size_t cap;
+    size_t head = 0;     // next slot to write, the oldest point once the ring is full
+    size_t count = 0;
+    size_t pending = 0;  // pushed but not uploaded yet, the newest 'pending' points before head
+    unsigned int VAO = 0, VBO = 0;
+
+    void uploadRange(size_t first, size_t n)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::vec3), n * sizeof(glm::vec3), &points[first]);
+        if (first == 0)
+            glBufferSubData(GL_ARRAY_BUFFER, cap * sizeof(glm::vec3), sizeof(glm::vec3), &points[0]);
+    }
+};
+#endif
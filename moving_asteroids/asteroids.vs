@@ -1,7 +1,7 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in mat4 aInstanceMatrix;
+layout (location = 7) in mat4 aInstanceMatrix; // after the mesh attributes, see FIRST_INSTANCE_LOCATION
 
 out vec2 TexCoords;
 
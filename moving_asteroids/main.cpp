@@ -14,6 +14,7 @@
 #include "shader_m.h"
 #include "camera.h"
 #include "model.h"
+#include "rock_generator.h"
 
 #include <iostream>
 
@@ -38,15 +39,23 @@ bool firstMouse = true;
 
 float orbitTime = 0.0f;
 
+// procedural rocks
+const unsigned int ROCK_VARIANTS = 8;
+uint64_t rockSeed = 1337;
+
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 
 
-int main()
+// optional first argument: the seed for the rock shapes and the belt layout
+int main(int argc, char** argv)
 {
-        glfwInit();
+    if (argc > 1)
+        rockSeed = std::strtoull(argv[1], NULL, 10);
+
+    glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -89,27 +98,21 @@ int main()
     Shader planetShader("planets.vs", "planets.fs");
 
     //models
-    Model rock("resources/objects/rock/rock.obj");
     Model planet("resources/objects/planet/planet.obj");
 
+    // a library of distinct procedural rocks, all wearing rock.png. Cached on disk after the first run
+    std::cout << "Rock seed: " << rockSeed << std::endl;
+    vector<RockMeshData> rockLibrary = LoadOrGenerateRockLibrary("resources/objects/rock", rockSeed, ROCK_VARIANTS, 3);
+    Texture rockTexture = { TextureFromFile("rock.png", "resources/objects/rock"), "texture_diffuse", "rock.png" };
+    vector<Model> rocks;
+    for (const RockMeshData &data : rockLibrary)
+        rocks.push_back(Model(vector<Mesh>{ Mesh(data.vertices, data.indices, { rockTexture }) }));
 
-   // Model rock("resources/objects/rock/rock.obj");
-    std::cout << "Rock meshes loaded: " << rock.meshes.size() << std::endl;
-    std::cout << "Rock textures loaded: " << rock.textures_loaded.size() << std::endl;
-
-    // Also check if the model file exists
-    std::ifstream file("resources/objects/rock/rock.obj");
-    if (!file.good()) {
-        std::cout << "Model file not found!" << std::endl;
-    } else {
-        std::cout << "Model file exists" << std::endl;
-    }
-
-    //semi-random transformation matrices
+    //semi-random transformation matrices, reproducible from the seed
     unsigned int amount = 5000;
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
-    srand(glfwGetTime());
+    RockRandom layout(rockSeed);
     float radius = 50.0f;
     float offset = 6.5f;
 
@@ -117,8 +120,9 @@ int main()
     float* asteroidRadii = new float[amount];      // Each asteroid's distance from center
     float* asteroidHeights = new float[amount];    // Each asteroid's y offset
     float* asteroidRotAngles = new float[amount];
+    vector<unsigned int> rockVariants(amount);
 
-    float scaleRange = 30.0f; // the variation in asteroid size
+    float scaleRange = 0.3f; // the variation in asteroid size
     float minScale = 0.05f; // smallest asteroid size
 
     for (unsigned int i=0;i<amount;i++)
@@ -126,14 +130,15 @@ int main()
         glm::mat4 model = glm::mat4(1.0f);
         // translation: displace along circle wih radius in range [-offset, offset]
         float angle = (float)i/(float)amount*360.0f;
-        float displacement = (rand()%(int)(2*offset*100))/100.0f-offset;
+        float displacement = layout.range(-offset, offset);
         asteroidRadii[i] = radius + displacement;
 
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
+        displacement = layout.range(-offset, offset);
         asteroidHeights[i] = displacement * 0.4f;  // Store y offset
 
-        asteroidScales[i] = (rand() % (int)scaleRange) / 100.0f + minScale;
-        asteroidRotAngles[i] = (rand() % 360);
+        asteroidScales[i] = layout.range(0.0f, scaleRange) + minScale;
+        asteroidRotAngles[i] = layout.range(0.0f, 360.0f);
+        rockVariants[i] = layout.nextInt(ROCK_VARIANTS);
 
         float x = sin(angle) * asteroidRadii[i];
         float y = asteroidHeights[i];
@@ -151,6 +156,15 @@ int main()
         modelMatrices[i] = model;
     } // after this for loop have amount number of modelMatrices describing the matrices for asteroid positions
 
+    // the buffer holds the matrices grouped by rock (slot -> asteroid i is buckets.order), so every rock draws its
+    // own slice of it with one instanced call
+    RockBuckets buckets = BucketRocks(rockVariants, ROCK_VARIANTS);
+    glm::mat4* sortedMatrices = new glm::mat4[amount];
+    for (unsigned int slot = 0; slot < amount; slot++)
+        sortedMatrices[slot] = modelMatrices[buckets.order[slot]];
+    delete[] modelMatrices;
+    modelMatrices = sortedMatrices;
+
 
     // we need to configure the instanced array:
     unsigned int buffer;
@@ -158,28 +172,10 @@ int main()
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
     glBufferData(GL_ARRAY_BUFFER, amount*sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
 
-    //
-    for (unsigned int i = 0; i < rock.meshes.size(); i++)
-    {
-        unsigned int VAO = rock.meshes[i].VAO;
-        glBindVertexArray(VAO);
-        // set attribute pointers for matrix (4 times vec4)
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
-    }
+    // the matrices are one mat4 per asteroid, bound after the rock's own vertex attributes
+    vector<vector<InstanceStream>> rockStreams;
+    for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+        rockStreams.push_back({ { buffer, VertexLayout().addMat4(), 1, static_cast<unsigned int>(buckets.first[v] * sizeof(glm::mat4)) } });
 
 
 
@@ -191,8 +187,9 @@ int main()
         lastFrame = currentFrame;
 
         orbitTime += deltaTime*0.1f; // 0.5f controls speed of orbit
-        for (unsigned int i = 0; i < amount; i++)
+        for (unsigned int slot = 0; slot < amount; slot++)
         {
+            unsigned int i = buckets.order[slot];
             glm::mat4 model = glm::mat4(1.0f);
             float baseAngle =  (float)i / (float)amount * 360.0f;
             float currentAngle = baseAngle + orbitTime*30.0f; // 30.0f degrees per second
@@ -206,7 +203,7 @@ int main()
             model = glm::rotate(model, asteroidRotAngles[i], glm::vec3(0.4f, 0.6f, 0.8f)); 
 
             //scale as before
-            modelMatrices[i] = model;
+            modelMatrices[slot] = model;
         }
 
         glBindBuffer(GL_ARRAY_BUFFER, buffer);
@@ -238,21 +235,8 @@ int main()
 
         //meteroites
         asteroidShader.use();
-        asteroidShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        if (!rock.textures_loaded.empty()) {
-            glBindTexture(GL_TEXTURE_2D, rock.textures_loaded[0].id); 
-        } else{
-            std::cout << "empty!" << std::endl;
-        }
-
-        
-        for (unsigned int i = 0; i<rock.meshes.size(); i++)
-        {
-            glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
-            glBindVertexArray(0);
-        }
+        for (unsigned int v = 0; v < ROCK_VARIANTS; v++)
+            rocks[v].DrawInstanced(asteroidShader, rockStreams[v], buckets.count[v]);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
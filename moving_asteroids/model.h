@@ -39,12 +39,28 @@ public:
         loadModel(path);
     }
 
+    // wraps meshes that were built in code rather than loaded from a file
+    Model(vector<Mesh> const &meshes) : meshes(meshes), gammaCorrection(false)
+    {
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // draws 'count' instances of every mesh, one instanced draw call per mesh with its textures bound once.
+    // the streams are attached after the regular vertex attributes (see FIRST_INSTANCE_LOCATION in mesh.h).
+    void DrawInstanced(Shader &shader, const vector<InstanceStream> &streams, unsigned int count)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            meshes[i].BindInstanceStreams(streams);
+            meshes[i].DrawInstanced(shader, count);
+        }
+    }
     
 private:
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in float aLife;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main() {
+    if (aLife > 0.0)
+        gl_Position = projection * view * vec4(aPos, 1.0);
+    else
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // not born yet, outside the clip volume
+    gl_PointSize = 3.0; // size of point
+}
@@ -0,0 +1,149 @@
+#ifndef GPU_PARTICLES_H
+#define GPU_PARTICLES_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "shader_m.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <iostream>
+
+// one particle as it sits in the GPU buffers. Transform feedback writes the update shader's outputs back packed in
+// exactly this order, so the struct and the varyings list in GpuParticleSystem must stay in step.
+struct GpuParticle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float life;        // (0, 1] alive, <= 0 not born yet (counts up to 0)
+    uint32_t seed;     // per particle xorshift state
+};
+
+// where and how particles are (re)born: on a cone around 'direction', like the Cherenkov cone behind the sphere
+struct ParticleEmitter {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    float coneAngle = glm::radians(22.0f);
+    float speed = 1.5f;
+    float lifetime = 10.0f; // seconds
+};
+
+// Particle state lives in two VBOs on the GPU. Every Update runs particle_update.vs over one of them with the
+// rasterizer off and captures the result into the other with transform feedback, then the two swap. Aging,
+// integration and respawning all happen in that shader, the CPU only sets the emitter uniforms, so no particle data
+// crosses the bus after the first upload.
+//
+// There is no spawn counter: every particle is recycled the moment it dies, so the system emits count / lifetime
+// particles per second. Initial lives are staggered over one lifetime to get a steady stream from the start.
+class GpuParticleSystem
+{
+public:
+    // relinks updateShader (particle_update.vs/fs) with the transform feedback outputs
+    GpuParticleSystem(unsigned int count, Shader &updateShader, uint32_t seed = 2024) : count(count)
+    {
+        const char* varyings[] = { "outPosition", "outVelocity", "outLife", "outSeed" };
+        glTransformFeedbackVaryings(updateShader.ID, 4, varyings, GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(updateShader.ID);
+        GLint linked;
+        glGetProgramiv(updateShader.ID, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(updateShader.ID, 1024, NULL, infoLog);
+            std::cout << "ERROR::GPU_PARTICLES:: transform feedback link failed\n" << infoLog << std::endl;
+        }
+
+        std::vector<GpuParticle> initial(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            GpuParticle &particle = initial[i];
+            particle.position = glm::vec3(0.0f);
+            particle.velocity = glm::vec3(0.0f);
+            particle.life = -(i + 1.0f) / count;
+            // splitmix64 so neighbouring particles don't start on correlated xorshift sequences
+            uint64_t z = (seed + (uint64_t)i * 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            particle.seed = static_cast<uint32_t>(z ^ (z >> 31)) | 1u;
+        }
+
+        glGenVertexArrays(2, VAO);
+        glGenBuffers(2, VBO);
+        for (int b = 0; b < 2; b++)
+        {
+            glBindVertexArray(VAO[b]);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO[b]);
+            glBufferData(GL_ARRAY_BUFFER, count * sizeof(GpuParticle), b == 0 ? initial.data() : nullptr, GL_DYNAMIC_COPY);
+
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, velocity));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, life));
+            glEnableVertexAttribArray(3);
+            glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GpuParticle), (void*)offsetof(GpuParticle, seed));
+        }
+        glBindVertexArray(0);
+    }
+
+    // steps every particle by deltaTime on the GPU
+    void Update(Shader &updateShader, const ParticleEmitter &emitter, float deltaTime)
+    {
+        // same cone basis the CPU emitter builds
+        glm::vec3 axis = glm::normalize(emitter.direction);
+        glm::vec3 u = std::fabs(axis.x) < 0.9f ? glm::normalize(glm::cross(axis, glm::vec3(1, 0, 0)))
+                                               : glm::normalize(glm::cross(axis, glm::vec3(0, 1, 0)));
+        glm::vec3 v = glm::cross(axis, u);
+
+        updateShader.use();
+        updateShader.setFloat("deltaTime", deltaTime);
+        updateShader.setFloat("lifetime", emitter.lifetime);
+        updateShader.setVec3("emitterPos", emitter.position);
+        updateShader.setVec3("coneAxis", axis);
+        updateShader.setVec3("coneU", u);
+        updateShader.setVec3("coneV", v);
+        updateShader.setFloat("cosAngle", std::cos(emitter.coneAngle));
+        updateShader.setFloat("sinAngle", std::sin(emitter.coneAngle));
+        updateShader.setFloat("speed", emitter.speed);
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(VAO[current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, VBO[1 - current]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, count);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        current = 1 - current;
+    }
+
+    // draws the latest state as points. renderShader reads position (0) and life (2), see gpu_particle.vs
+    void Draw(Shader &renderShader)
+    {
+        renderShader.use();
+        glBindVertexArray(VAO[current]);
+        glDrawArrays(GL_POINTS, 0, count);
+        glBindVertexArray(0);
+    }
+
+    unsigned int size() const { return count; }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteVertexArrays(2, VAO);
+        glDeleteBuffers(2, VBO);
+    }
+
+private:
+    unsigned int VAO[2] = { 0, 0 };
+    unsigned int VBO[2] = { 0, 0 };
+    unsigned int count;
+    int current = 0; // buffer holding the latest state
+};
+#endif
@@ -7,36 +7,36 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "particle_soa.h"
+#include "thread_pool.h"
+#include "gpu_particles.h"
 
 #include <iostream>
 #include <vector>
 #include <cmath> 
-
-struct Particle {
-    glm::vec3 position;
-    glm::vec3 velocity;
-    float life;
-
-};
+#include <cstdlib>
+#include <cstring>
 
 const int MAX_PARTICLES = 50000;
-std::vector<Particle> particles(MAX_PARTICLES);
+ParticleSoA particles(MAX_PARTICLES);
+ParticleForces particleForces; // none by default, the cone just drifts
+ParticleRandom particleRandom(2024);
 float particleSpeed = 1.5f;
 float particleLifetime = 10.0f; // seconds
 int particlesPerFrame = 50; // how many to spawn per frame
 
+// the GPU path recycles each particle as it dies, so it emits count / lifetime per second.
+// 30000 over 10s matches the CPU path's 50 a frame at 60fps
+unsigned int gpuParticleCount = 30000;
+bool useGpuParticles = true;
 
-void spawnParticle(Particle& particle, const glm::vec3& spherePos, const glm::vec3& sphereVel) {
-    particle.position = spherePos;
-
+// emits up to 'count' particles on the Cherenkov cone behind the sphere
+void spawnParticles(int count, const glm::vec3& spherePos, const glm::vec3& sphereVel) {
     glm::vec3 sphereDir = glm::normalize(sphereVel);
     float cherenkovAngle = glm::radians(22.0f);
 
-    // generate random points on cone:
-    float azimuth = ((float)(rand() % 1000) / 1000.0f)* 2.0f * M_PI;
-
-    //create perpendicular vector to sphereDir
-
+    //create perpendicular vector to sphereDir, the cone is the same for the whole batch
     glm::vec3 perpendicular;
     if (abs(sphereDir.x) < 0.9f) {
         perpendicular = glm::normalize(glm::cross(sphereDir, glm::vec3(1,0,0)));
@@ -45,15 +45,34 @@ void spawnParticle(Particle& particle, const glm::vec3& spherePos, const glm::ve
     }
     glm::vec3 perpendicular2 = glm::cross(sphereDir, perpendicular);
 
-    // direction on cone:
     float sinAngle = sin(cherenkovAngle);
     float cosAngle = cos(cherenkovAngle);
 
-    glm::vec3 particleDir = cosAngle * sphereDir + 
-                            sinAngle * ((float)cos(azimuth) * perpendicular + (float)sin(azimuth)*perpendicular2);
-
-    particle.velocity = particleDir * particleSpeed;
-    particle.life = 1.0f;
+    // generate random points on cone, a batch of azimuths at a time:
+    const int BATCH = 256;
+    float azimuths[BATCH];
+    while (count > 0) {
+        int batch = std::min(count, BATCH);
+        particleRandom.uniform(azimuths, batch, 0.0f, 2.0f * (float)M_PI);
+        size_t spawned = particles.spawn(batch);
+        size_t first = particles.size() - spawned;
+        for (size_t k = 0; k < spawned; k++) {
+            // direction on cone:
+            glm::vec3 particleDir = cosAngle * sphereDir +
+                                    sinAngle * (std::cos(azimuths[k]) * perpendicular + std::sin(azimuths[k]) * perpendicular2);
+            size_t i = first + k;
+            particles.x[i] = spherePos.x;
+            particles.y[i] = spherePos.y;
+            particles.z[i] = spherePos.z;
+            particles.vx[i] = particleDir.x * particleSpeed;
+            particles.vy[i] = particleDir.y * particleSpeed;
+            particles.vz[i] = particleDir.z * particleSpeed;
+            particles.life[i] = 1.0f;
+        }
+        if (spawned < (size_t)batch)
+            break; // pool is full
+        count -= batch;
+    }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -140,8 +159,17 @@ void generateSphere(float radius, int latitudeSegments, int longitudeSegments,
 
 
 
-int main()
+// usage: main [particle count] [--cpu]
+int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--cpu") == 0)
+            useGpuParticles = false;
+        else
+            gpuParticleCount = (unsigned int)std::strtoul(argv[i], nullptr, 10);
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -188,6 +216,8 @@ int main()
     Shader lightingShader("2.2.basic_lighting.vs", "2.2.basic_lighting.fs");
     Shader lightCubeShader("2.2.light_cube.vs", "2.2.light_cube.fs");
     Shader particleShader("particle.vs", "particle.fs");
+    Shader gpuParticleShader("gpu_particle.vs", "particle.fs");
+    Shader particleUpdateShader("particle_update.vs", "particle_update.fs");
 
 
     std::vector<float> sphereVertices;
@@ -287,11 +317,18 @@ int main()
 
     glBindVertexArray(particleVAO);
     glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES*3*sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES*4*sizeof(float), nullptr, GL_DYNAMIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), (void*)0);
+    // ParticleSoA's vertex stream is x, y, z, life per particle
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 4*sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    ThreadPool particleWorkers;
 
+    // GPU particles: state stays in video memory, stepped with transform feedback
+    GpuParticleSystem gpuParticles(useGpuParticles ? gpuParticleCount : 0, particleUpdateShader);
+    ParticleEmitter emitter;
+    emitter.speed = particleSpeed;
+    emitter.lifetime = particleLifetime;
 
     // render loop
     // -----------
@@ -337,41 +374,33 @@ int main()
 
 
         // particle time:
-        for (int i = 0; i < particlesPerFrame; ++i) {
-            //find dead particle to respawn:
-            for (auto& particle : particles) {
-                if (particle.life <= 0.0f) {
-                    spawnParticle(particle, spherePosition, sphereVelocity);
-                    break;
-                }
-            }
-        }
+        if (useGpuParticles) {
+            emitter.position = spherePosition;
+            emitter.direction = sphereVelocity;
+            gpuParticles.Update(particleUpdateShader, emitter, deltaTime);
+
+            gpuParticleShader.use();
+            gpuParticleShader.setMat4("projection", projection);
+            gpuParticleShader.setMat4("view", view);
+            gpuParticles.Draw(gpuParticleShader);
+        } else {
+            spawnParticles(particlesPerFrame, spherePosition, sphereVelocity);
 
-        //update existing particles:
-        std::vector<float> particlePositions;
-        for (auto& particle : particles) {
-            if (particle.life > 0.0f) {
-                particle.position += particle.velocity * deltaTime;
-                particle.life -= deltaTime / particleLifetime;
-
-                // add to render list:
-                particlePositions.push_back(particle.position.x);
-                particlePositions.push_back(particle.position.y);
-                particlePositions.push_back(particle.position.z);
-            }
-        }
+            //update existing particles, dropping the dead ones. the step writes the vertex stream as it goes
+            particles.step(particleForces, deltaTime, deltaTime / particleLifetime, &particleWorkers);
 
-        // render particles
-        if (!particlePositions.empty()) {
-            particleShader.use();
-            particleShader.setMat4("projection", projection);
-            particleShader.setMat4("view", view);
+            // render particles
+            if (particles.size() > 0) {
+                particleShader.use();
+                particleShader.setMat4("projection", projection);
+                particleShader.setMat4("view", view);
 
-            glBindVertexArray(particleVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, particlePositions.size() * sizeof(float), particlePositions.data());
+                glBindVertexArray(particleVAO);
+                glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, particles.size() * 4 * sizeof(float), particles.vertexData());
 
-            glDrawArrays(GL_POINTS,0,particlePositions.size()/3);
+                glDrawArrays(GL_POINTS, 0, (GLsizei)particles.size());
+            }
         }
 
         // also draw the lamp object
@@ -401,6 +430,7 @@ int main()
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &particleVAO);
     glDeleteBuffers(1, &particleVBO);
+    gpuParticles.Delete();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
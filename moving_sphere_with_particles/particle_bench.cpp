@@ -0,0 +1,126 @@
+#include <glm/glm.hpp>
+
+#include "particle_pool.h"
+#include "particle_soa.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+
+// CPU particle step benchmark, no window needed: particle_bench [steps]
+// times the demo's AoS ParticlePool loop against ParticleSoA (scalar, AVX2, AVX2 + thread pool)
+// at 50k, 1M and 10M particles. Build with -O2 -mavx2 -mfma, without them the "avx2" rows run the scalar kernel.
+
+struct Particle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float life;
+};
+
+const float dt = 1.0f / 60.0f;
+const float lifeStep = dt / 10.0f;
+
+// milliseconds per call of step, averaged over 'steps' calls
+double timeSteps(int steps, const std::function<void()> &step)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+        step();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / steps;
+}
+
+void fillSoA(ParticleSoA &soa, size_t count, ParticleRandom &random)
+{
+    soa.clear();
+    soa.spawn(count);
+    random.uniform(soa.x, count, -5.0f, 5.0f);
+    random.uniform(soa.y, count, -5.0f, 5.0f);
+    random.uniform(soa.z, count, -5.0f, 5.0f);
+    random.uniform(soa.vx, count, -1.0f, 1.0f);
+    random.uniform(soa.vy, count, -1.0f, 1.0f);
+    random.uniform(soa.vz, count, -1.0f, 1.0f);
+    random.uniform(soa.life, count, 0.0f, 1.0f);
+}
+
+void report(const char *name, double ms, double baseline)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(3) << ms << " ms  " << std::setw(6) << std::setprecision(1) << baseline / ms << "x"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int baseSteps = argc > 1 ? std::atoi(argv[1]) : 20;
+    ThreadPool pool;
+
+    ParticleForces none;
+    ParticleForces forces;
+    forces.gravity = glm::vec3(0.0f, -0.5f, 0.0f);
+    forces.drag = 0.1f;
+    forces.attractors = { { glm::vec3(2.0f, 0.0f, 0.0f), 1.0f }, { glm::vec3(-2.0f, 1.0f, 0.0f), 0.5f } };
+
+#ifndef PARTICLE_SOA_AVX2
+    std::cout << "built without AVX2/FMA, the simd rows use the scalar kernel" << std::endl;
+#endif
+    std::cout << pool.size() << " worker threads" << std::endl;
+
+    size_t counts[3] = { 50000, 1000000, 10000000 };
+    for (size_t count : counts)
+    {
+        // fewer steps for the big runs, a step at 10M is already tens of milliseconds
+        int steps = std::max(3, (int)(baseSteps * 50000 / count));
+        std::cout << count << " particles, " << steps << " steps" << std::endl;
+        ParticleRandom random(7);
+
+        double baseline;
+        {
+            // the loop moving_sphere_with_particles runs with --cpu
+            ParticlePool<Particle> particles(count);
+            std::vector<float> values(count);
+            random.uniform(values.data(), count, 0.0f, 1.0f);
+            particles.spawn(count, [&](Particle &particle, size_t k) {
+                particle.position = glm::vec3(values[k] * 10.0f - 5.0f);
+                particle.velocity = glm::vec3(values[k] * 2.0f - 1.0f);
+                particle.life = values[k];
+            });
+            baseline = timeSteps(steps, [&] {
+                std::vector<float> particlePositions;
+                particles.update([&](Particle &particle) {
+                    particle.position += particle.velocity * dt;
+                    particle.life -= lifeStep;
+                    if (particle.life <= 0.0f)
+                        return false;
+                    particlePositions.push_back(particle.position.x);
+                    particlePositions.push_back(particle.position.y);
+                    particlePositions.push_back(particle.position.z);
+                    return true;
+                });
+            });
+            report("aos loop", baseline, baseline);
+        }
+
+        ParticleSoA soa(count);
+        struct Run { const char *name; const ParticleForces *forces; ThreadPool *pool; bool simd; };
+        Run runs[] = {
+            { "soa scalar", &none, nullptr, false },
+            { "soa avx2", &none, nullptr, true },
+            { "soa avx2 threads", &none, &pool, true },
+            { "soa scalar + forces", &forces, nullptr, false },
+            { "soa avx2 + forces", &forces, nullptr, true },
+            { "soa avx2 threads + forces", &forces, &pool, true },
+        };
+        for (const Run &run : runs)
+        {
+            fillSoA(soa, count, random);
+            double ms = timeSteps(steps, [&] { soa.step(*run.forces, dt, lifeStep, run.pool, run.simd); });
+            report(run.name, ms, baseline);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#ifndef PARTICLE_SOA_H
+#define PARTICLE_SOA_H
+
+#include <glm/glm.hpp>
+
+#include "thread_pool.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PARTICLE_SOA_AVX2 1
+#endif
+
+// pulls every particle towards 'position', strength / distance^2 softened by ParticleForces::softening
+struct PointAttractor {
+    glm::vec3 position;
+    float strength;
+};
+
+struct ParticleForces {
+    glm::vec3 gravity = glm::vec3(0.0f);
+    float drag = 0.0f;        // linear, acceleration -= drag * velocity
+    float softening = 0.1f;   // keeps attractors finite when a particle passes right through them
+    std::vector<PointAttractor> attractors;
+};
+
+// Particle state as structure of arrays: one 32-byte aligned array per component, so eight particles load into one
+// AVX register per component with no gathers. step() integrates, applies the forces, ages and writes the render
+// stream (x, y, z, life per particle, ready for glBufferSubData) in one pass, split into chunks across a ThreadPool,
+// then packs the survivors to the front the same way ParticlePool does.
+class ParticleSoA
+{
+public:
+    static const size_t GRAIN = 16384; // particles per thread pool job, a multiple of 8 so chunks stay aligned
+
+    float *x, *y, *z;
+    float *vx, *vy, *vz;
+    float *life;
+
+    explicit ParticleSoA(size_t capacity) : cap(capacity), count(0)
+    {
+        size_t padded = (capacity + 7) & ~size_t(7);
+        float** arrays[7] = { &x, &y, &z, &vx, &vy, &vz, &life };
+        for (float** array : arrays)
+            *array = allocate(padded);
+        vertices = allocate(padded * 4);
+    }
+
+    ~ParticleSoA()
+    {
+        float* arrays[8] = { x, y, z, vx, vy, vz, life, vertices };
+        for (float* array : arrays)
+            std::free(array);
+    }
+
+    ParticleSoA(const ParticleSoA&) = delete;
+    ParticleSoA& operator=(const ParticleSoA&) = delete;
+
+    // grows the live range by up to 'amount' and returns how many fitted. The new particles are
+    // [size() - spawned, size()) and it's up to the caller to fill their components
+    size_t spawn(size_t amount)
+    {
+        size_t spawned = std::min(amount, cap - count);
+        count += spawned;
+        return spawned;
+    }
+
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+
+    // x, y, z, life for every live particle, as of the last step()
+    const float* vertexData() const { return vertices; }
+
+    // advances every particle by dt, ages it by lifeStep and drops the ones that die.
+    // simd = false forces the scalar kernel, only the benchmark wants that
+    void step(const ParticleForces &forces, float dt, float lifeStep, ThreadPool *pool = nullptr, bool simd = true)
+    {
+        size_t chunks = (count + GRAIN - 1) / GRAIN;
+        deadPerChunk.assign(chunks, 0);
+        auto body = [&](size_t begin, size_t end) {
+            deadPerChunk[begin / GRAIN] = stepRange(forces, dt, lifeStep, begin, end, simd);
+        };
+        if (pool && chunks > 1)
+            pool->parallelFor(count, GRAIN, body);
+        else
+            for (size_t c = 0; c < chunks; c++)
+                body(c * GRAIN, std::min(count, (c + 1) * GRAIN));
+        compact();
+    }
+
+private:
+    size_t cap;
+    size_t count;
+    float* vertices;
+    std::vector<size_t> deadPerChunk;
+
+    static float* allocate(size_t floats)
+    {
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t bytes = (floats * sizeof(float) + 31) & ~size_t(31);
+        return static_cast<float*>(std::aligned_alloc(32, std::max<size_t>(bytes, 32)));
+    }
+
+    // returns how many particles in [begin, end) died
+    size_t stepRange(const ParticleForces &forces, float dt, float lifeStep, size_t begin, size_t end, bool simd)
+    {
+        size_t dead = 0;
+        size_t i = begin;
+#ifdef PARTICLE_SOA_AVX2
+        if (simd)
+            for (; i + 8 <= end; i += 8)
+                dead += stepEight(forces, dt, lifeStep, i);
+#else
+        (void)simd;
+#endif
+        for (; i < end; i++)
+            dead += stepOne(forces, dt, lifeStep, i);
+        return dead;
+    }
+
+    size_t stepOne(const ParticleForces &forces, float dt, float lifeStep, size_t i)
+    {
+        glm::vec3 p(x[i], y[i], z[i]);
+        glm::vec3 v(vx[i], vy[i], vz[i]);
+        glm::vec3 a = forces.gravity - forces.drag * v;
+        float soft2 = forces.softening * forces.softening;
+        for (const PointAttractor &attractor : forces.attractors)
+        {
+            glm::vec3 d = attractor.position - p;
+            float inv = 1.0f / std::sqrt(glm::dot(d, d) + soft2);
+            a += attractor.strength * inv * inv * inv * d;
+        }
+        v += a * dt;
+        p += v * dt;
+        float l = life[i] - lifeStep;
+
+        x[i] = p.x; y[i] = p.y; z[i] = p.z;
+        vx[i] = v.x; vy[i] = v.y; vz[i] = v.z;
+        life[i] = l;
+        float* out = vertices + i * 4;
+        out[0] = p.x; out[1] = p.y; out[2] = p.z; out[3] = l;
+        return l <= 0.0f ? 1 : 0;
+    }
+
+#ifdef PARTICLE_SOA_AVX2
+    // same as stepOne for particles i .. i + 7, i is a multiple of 8 so every load is aligned
+    size_t stepEight(const ParticleForces &forces, float dt, float lifeStep, size_t i)
+    {
+        __m256 px = _mm256_load_ps(x + i), py = _mm256_load_ps(y + i), pz = _mm256_load_ps(z + i);
+        __m256 qx = _mm256_load_ps(vx + i), qy = _mm256_load_ps(vy + i), qz = _mm256_load_ps(vz + i);
+
+        __m256 negDrag = _mm256_set1_ps(-forces.drag);
+        __m256 ax = _mm256_fmadd_ps(negDrag, qx, _mm256_set1_ps(forces.gravity.x));
+        __m256 ay = _mm256_fmadd_ps(negDrag, qy, _mm256_set1_ps(forces.gravity.y));
+        __m256 az = _mm256_fmadd_ps(negDrag, qz, _mm256_set1_ps(forces.gravity.z));
+
+        __m256 soft2 = _mm256_set1_ps(forces.softening * forces.softening);
+        __m256 half = _mm256_set1_ps(0.5f), threeHalves = _mm256_set1_ps(1.5f);
+        for (const PointAttractor &attractor : forces.attractors)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(attractor.position.x), px);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(attractor.position.y), py);
+            __m256 dz = _mm256_sub_ps(_mm256_set1_ps(attractor.position.z), pz);
+            __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_fmadd_ps(dz, dz, soft2)));
+            // rsqrt is only good to 12 bits, one Newton step gets it close to 1 / sqrt
+            __m256 inv = _mm256_rsqrt_ps(r2);
+            inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), threeHalves));
+            __m256 s = _mm256_mul_ps(_mm256_set1_ps(attractor.strength), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+            ax = _mm256_fmadd_ps(s, dx, ax);
+            ay = _mm256_fmadd_ps(s, dy, ay);
+            az = _mm256_fmadd_ps(s, dz, az);
+        }
+
+        __m256 step = _mm256_set1_ps(dt);
+        qx = _mm256_fmadd_ps(ax, step, qx);
+        qy = _mm256_fmadd_ps(ay, step, qy);
+        qz = _mm256_fmadd_ps(az, step, qz);
+        px = _mm256_fmadd_ps(qx, step, px);
+        py = _mm256_fmadd_ps(qy, step, py);
+        pz = _mm256_fmadd_ps(qz, step, pz);
+        __m256 l = _mm256_sub_ps(_mm256_load_ps(life + i), _mm256_set1_ps(lifeStep));
+
+        _mm256_store_ps(x + i, px); _mm256_store_ps(y + i, py); _mm256_store_ps(z + i, pz);
+        _mm256_store_ps(vx + i, qx); _mm256_store_ps(vy + i, qy); _mm256_store_ps(vz + i, qz);
+        _mm256_store_ps(life + i, l);
+
+        // 4x8 transpose of x, y, z, life into eight xyzl vertices
+        __m256 t0 = _mm256_unpacklo_ps(px, py), t1 = _mm256_unpackhi_ps(px, py);
+        __m256 t2 = _mm256_unpacklo_ps(pz, l), t3 = _mm256_unpackhi_ps(pz, l);
+        __m256 v0 = _mm256_shuffle_ps(t0, t2, 0x44), v1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+        __m256 v2 = _mm256_shuffle_ps(t1, t3, 0x44), v3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+        float* out = vertices + i * 4;
+        _mm256_store_ps(out, _mm256_permute2f128_ps(v0, v1, 0x20));
+        _mm256_store_ps(out + 8, _mm256_permute2f128_ps(v2, v3, 0x20));
+        _mm256_store_ps(out + 16, _mm256_permute2f128_ps(v0, v1, 0x31));
+        _mm256_store_ps(out + 24, _mm256_permute2f128_ps(v2, v3, 0x31));
+
+        int deadMask = _mm256_movemask_ps(_mm256_cmp_ps(l, _mm256_setzero_ps(), _CMP_LE_OQ));
+        return (size_t)__builtin_popcount(deadMask);
+    }
+#endif
+
+    // swap-removes the dead, only visiting chunks that reported any. Holes are the only slots that ever get
+    // written, so a chunk with no dead particles can't end up holding one
+    void compact()
+    {
+        for (size_t c = 0; c < deadPerChunk.size(); c++)
+        {
+            size_t i = c * GRAIN;
+            if (i >= count)
+                break;
+            if (deadPerChunk[c] == 0)
+                continue;
+            size_t end = (c + 1) * GRAIN;
+            while (i < std::min(end, count))
+            {
+                if (life[i] > 0.0f)
+                    i++;
+                else
+                    move(--count, i); // the particle moved in hasn't been checked yet, so don't advance
+            }
+        }
+    }
+
+    void move(size_t from, size_t to)
+    {
+        x[to] = x[from]; y[to] = y[from]; z[to] = z[from];
+        vx[to] = vx[from]; vy[to] = vy[from]; vz[to] = vz[from];
+        life[to] = life[from];
+        for (int k = 0; k < 4; k++)
+            vertices[to * 4 + k] = vertices[from * 4 + k];
+    }
+};
+#endif
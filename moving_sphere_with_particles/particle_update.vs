@@ -0,0 +1,76 @@
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aVelocity;
+layout (location = 2) in float aLife;
+layout (location = 3) in uint aSeed;
+
+// captured by transform feedback, in the order of GpuParticle
+out vec3 outPosition;
+out vec3 outVelocity;
+out float outLife;
+flat out uint outSeed;
+
+uniform float deltaTime;
+uniform float lifetime;
+
+// emitter cone
+uniform vec3 emitterPos;
+uniform vec3 coneAxis;
+uniform vec3 coneU;
+uniform vec3 coneV;
+uniform float cosAngle;
+uniform float sinAngle;
+uniform float speed;
+
+const float TWO_PI = 6.28318530718;
+
+uint xorshift(uint x)
+{
+    x ^= x << 13u;
+    x ^= x >> 17u;
+    x ^= x << 5u;
+    return x;
+}
+
+void main()
+{
+    vec3 position = aPosition;
+    vec3 velocity = aVelocity;
+    float life = aLife;
+    uint seed = aSeed;
+
+    // how far past its death (or birth) the particle is this step, in lifetimes
+    float overshoot = -1.0;
+    float lifeStep = deltaTime / lifetime;
+    if (life > 0.0)
+    {
+        position += velocity * deltaTime;
+        life -= lifeStep;
+        if (life <= 0.0)
+            overshoot = -life;
+    }
+    else
+    {
+        // not born yet, count up to zero
+        life += lifeStep;
+        if (life >= 0.0)
+            overshoot = life;
+    }
+
+    if (overshoot >= 0.0)
+    {
+        // respawn on the cone. it was born 'overshoot' lifetimes ago, so move it along by that much
+        overshoot = min(overshoot, 1.0);
+        seed = xorshift(seed);
+        float azimuth = float(seed >> 8u) * (1.0 / 16777216.0) * TWO_PI;
+        vec3 dir = cosAngle * coneAxis + sinAngle * (cos(azimuth) * coneU + sin(azimuth) * coneV);
+        velocity = dir * speed;
+        position = emitterPos + velocity * (overshoot * lifetime);
+        life = 1.0 - overshoot;
+    }
+
+    outPosition = position;
+    outVelocity = velocity;
+    outLife = life;
+    outSeed = seed;
+}
@@ -7,10 +7,17 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#include "particle_pool.h"
+#include "trace_renderer.h"
+#include "ode.h"
+#include "sim_runner.h"
+#include "sim_record.h"
 
 #include <iostream>
 #include <vector>  // ADD THIS
 #include <cmath>   // ADD THIS
+#include <cstring>
+#include <algorithm>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
@@ -47,7 +54,21 @@ float sphereRadius = 0.3f;
 
 float theta_old;
 float theta_dot_old;
+
+// what the sim thread owns: leapfrog at a fixed 1 ms, held still while the bob is being dragged
+struct PendulumModel {
+    Leapfrog<double, double> pendulum;
+    bool held;
+};
+const double SIM_STEP = 1e-3;
 float rope_L = 3.0f;
+
+// --play: a pendulum_cli recording swings the bob instead of the sim. Left/right arrows scrub, space pauses and
+// Home goes back to the start (R already frees the cursor)
+SimRecordReader recording;
+bool playing = false;
+bool playPaused = false;
+double playTime = 0.0;
 glm::vec3 anchorPoint(0.0f, 2.0f, 0.0f);
 
 bool isDragging = false;
@@ -59,7 +80,7 @@ struct TraceParticle {
 };
 
 const int MAX_TRACE_PARTICLES = 1000;
-std::vector<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
+ParticlePool<TraceParticle> traceParticles(MAX_TRACE_PARTICLES);
 float traceLifeTime = 0.9f;
 int traceSpawnRate = 100;
 static float timeSinceLastSpawn = 0.0f;
@@ -140,8 +161,35 @@ void generateRopeLine(glm::vec3 anchorPoint, glm::vec3 spherePos, std::vector<fl
 static float fpsTimer = 0.0f;
 static int frameCount = 0;
 
-int main()
+// the angle at playTime, blended between the two recorded frames either side
+void updateFromRecording() {
+    if (!playPaused)
+        playTime += deltaTime;
+    playTime = std::min(std::max(playTime, 0.0), recording.duration());
+    double position = playTime / recording.header().frameDt;
+    uint64_t frame = std::min((uint64_t)position, recording.frameCount() - 1);
+    const float* a = recording.frame(frame);
+    const float* b = recording.frame(std::min(frame + 1, recording.frameCount() - 1));
+    float blend = (float)(position - frame);
+    theta_old = glm::mix(a[0], b[0], blend);
+    theta_dot_old = glm::mix(a[1], b[1], blend);
+}
+
+int main(int argc, char** argv)
 {
+    if (argc == 3 && std::strcmp(argv[1], "--play") == 0)
+    {
+        if (!recording.open(argv[2]) || recording.frameFloats() != 2 || recording.frameCount() == 0)
+        {
+            std::cout << "ERROR::PLAYBACK::NOT_A_PENDULUM_RECORDING " << argv[2] << std::endl;
+            return -1;
+        }
+        playing = true;
+        // pendulum_cli's header params are g, rope length, starting angle, step
+        if (recording.header().paramCount > 1)
+            rope_L = (float)recording.header().params[1];
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -188,6 +236,7 @@ int main()
     // ------------------------------------
     Shader lightingShader("2.2.basic_lighting.vs", "2.2.basic_lighting.fs");
     Shader lightCubeShader("2.2.light_cube.vs", "2.2.light_cube.fs");
+    Shader traceShader("trace.vs", "trace.fs");
 
 
 
@@ -270,17 +319,8 @@ int main()
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // particle setup:
-    unsigned int traceVBO, traceVAO;
-    glGenVertexArrays(1, &traceVAO);
-    glGenBuffers(1, &traceVBO);
-
-    glBindVertexArray(traceVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-    glBufferData(GL_ARRAY_BUFFER, MAX_TRACE_PARTICLES * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // particle setup: the whole trail is one upload and one draw call per frame
+    TraceRenderer<TraceParticle> traceRenderer(MAX_TRACE_PARTICLES);
 
     // rope setup
     
@@ -313,7 +353,6 @@ int main()
 
     // important inital tings for da pendulum:
     theta_old = 20.0f * M_PI/180.0f;
-    float theta_new;
     float g = 9.81f; // m/s^2
     
     // float rope_L = 3.0f;
@@ -325,10 +364,15 @@ int main()
     float z_new;
 
     theta_dot_old = 0;
-    float theta_dot_new;
-
-    float theta_dot_dot_old = -(g/rope_L)*sin(theta_old);
-    float theta_dot_dot_new;
+    SimRunner<PendulumModel> sim(PendulumModel{ Leapfrog<double, double>(theta_old, theta_dot_old, SIM_STEP), false },
+                                 SIM_STEP, [g](PendulumModel& model) {
+        if (!model.held)
+            model.pendulum.step([g](double theta) { return -(g/rope_L) * std::sin(theta); });
+    });
+    if (!playing)
+        sim.start();
+    bool wasDragging = false;
+    int framesSinceReport = 0;
 
     globalSpherePos = glm::vec3(x_old, y_old, z_old);
 
@@ -373,24 +417,41 @@ int main()
         globalView = camera.GetViewMatrix();
         
 
-        if (!isDragging) {
-            theta_dot_new = theta_dot_old + theta_dot_dot_old * deltaTime;
-            theta_new = theta_old + theta_dot_new * deltaTime;
-            theta_dot_dot_new = -(g/rope_L) * sin(theta_new);
-            
-            x_new = anchorPoint.x + sin(theta_new) * rope_L;
-            y_new = anchorPoint.y - cos(theta_new) * rope_L;
-            z_new = anchorPoint.z;
+        sim.recordFrame(deltaTime);
+        if (++framesSinceReport == 600 && !playing) {
+            sim.report();
+            framesSinceReport = 0;
+        }
 
-            theta_old = theta_new;
-            theta_dot_old = theta_dot_new;
-            theta_dot_dot_old = theta_dot_dot_new;
+        if (playing) {
+            updateFromRecording();
+            x_new = anchorPoint.x + sin(theta_old) * rope_L;
+            y_new = anchorPoint.y - cos(theta_old) * rope_L;
+            z_new = anchorPoint.z;
+        } else if (!isDragging) {
+            if (wasDragging)
+                sim.post([](PendulumModel& model) { model.held = false; });
+            // one sim step behind, blended between the last two
+            const SimSnapshot<PendulumModel>& snapshot = sim.latest();
+            double alpha = sim.alpha();
+            theta_old = (float)glm::mix(snapshot.previous.pendulum.position(), snapshot.current.pendulum.position(), alpha);
+            theta_dot_old = (float)snapshot.current.pendulum.velocity();
+
+            x_new = anchorPoint.x + sin(theta_old) * rope_L;
+            y_new = anchorPoint.y - cos(theta_old) * rope_L;
+            z_new = anchorPoint.z;
         } else {
-            // position is set by mouse callback
+            // position is set by mouse callback, the sim holds the bob there at rest until it's let go
+            float held = theta_old;
+            sim.post([held](PendulumModel& model) {
+                model.pendulum.reset(held, 0.0, model.pendulum.time());
+                model.held = true;
+            });
             x_new = globalSpherePos.x;
             y_new = globalSpherePos.y;
             z_new = globalSpherePos.z;
         }
+        wasDragging = isDragging;
 
         globalSpherePos = glm::vec3(x_new, y_new, z_new);
 
@@ -411,26 +472,17 @@ int main()
         
         timeSinceLastSpawn += deltaTime;
         if (timeSinceLastSpawn >= 1.0f/traceSpawnRate) {
-            for (auto& particle : traceParticles) {
-                if (particle.life <= 0.0f) {
-                    particle.position = spherePosition; // spawn at sphere center
-                    particle.life = 1.0f;
-                    break;
-                }
+            if (TraceParticle* particle = traceParticles.spawn()) {
+                particle->position = spherePosition; // spawn at sphere center
+                particle->life = 1.0f;
             }
             timeSinceLastSpawn = 0.0f;
         }
 
-        std::vector<float> tracePositions;
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                particle.life -= deltaTime/traceLifeTime;
-
-                tracePositions.push_back(particle.position.x);
-                tracePositions.push_back(particle.position.y);
-                tracePositions.push_back(particle.position.z);
-            }
-        }
+        traceParticles.update([&](TraceParticle& particle) {
+            particle.life -= deltaTime/traceLifeTime;
+            return particle.life > 0.0f;
+        });
     
 
         // be sure to activate shader when setting uniforms/drawing objects
@@ -463,41 +515,10 @@ int main()
         glBufferData(GL_ARRAY_BUFFER,  ropeVertices.size() * sizeof(float), ropeVertices.data(), GL_DYNAMIC_DRAW);
 
         // particles:
-        // if (!tracePositions.empty()) {
-        //     lightCubeShader.use();
-        //     lightCubeShader.setMat4("projection", globalProjection);
-        //     lightCubeShader.setMat4("view", globalView);
-        //     lightCubeShader.setMat4("model", glm::mat4(1.0f));
-        //     lightCubeShader.setVec3("color", 0.0f, 1.0f, 0.0f);
-
-        //     glBindVertexArray(traceVAO);
-        //     glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-        //     glBufferSubData(GL_ARRAY_BUFFER, 0, tracePositions.size() * sizeof(float), tracePositions.data());
-
-        //     glPointSize(3.0f);
-        //     glDrawArrays(GL_POINTS, 0, tracePositions.size()/3);
-
-        // }
-
-        for (auto& particle : traceParticles) {
-            if (particle.life > 0.0f) {
-                float intensity = particle.life; // 1.0 when fresh, 0.0 when dying
-
-                lightCubeShader.use();
-                lightCubeShader.setMat4("projection", globalProjection);
-                lightCubeShader.setMat4("view", globalView);
-                lightCubeShader.setMat4("model", glm::mat4(1.0f));
-                lightCubeShader.setVec3("color", 0.0f, intensity, 0.0f);
-
-
-                glBindVertexArray(traceVAO);
-                glBindBuffer(GL_ARRAY_BUFFER, traceVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float), &particle.position.x);
-
-                glPointSize(4.0f);
-                glDrawArrays(GL_POINTS, 0, 1);
-            }
-        }
+        traceShader.use();
+        traceShader.setMat4("projection", globalProjection);
+        traceShader.setMat4("view", globalView);
+        traceRenderer.Draw(traceShader, traceParticles, glm::vec3(0.0f, 1.0f, 0.0f), 4.0f);
 
 
         // light ube shader
@@ -539,6 +560,12 @@ int main()
     glDeleteBuffers(1, &sphereVBO);
     glDeleteBuffers(1, &sphereEBO);
     glDeleteBuffers(1, &cubeVBO);
+    traceRenderer.Delete();
+    if (!playing) {
+        sim.stop();
+        sim.report();
+    }
+    recording.close();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -592,6 +619,22 @@ void processInput(GLFWwindow *window)
     {
         tKeyPressed = false;
     }
+
+    if (playing)
+    {
+        // scrubbing covers 10 seconds of sim time per second held
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+            playTime -= 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+            playTime += 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_HOME) == GLFW_PRESS)
+            playTime = 0.0;
+        static bool spaceWasDown = false;
+        bool spaceDown = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        if (spaceDown && !spaceWasDown)
+            playPaused = !playPaused;
+        spaceWasDown = spaceDown;
+    }
 }
 
 
@@ -634,7 +677,8 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
             float pixel_sphere_radius = abs(sphereScreenX-edgeX);
             
             float distance = sqrt(pow(mouseX-sphereScreenX, 2)+pow(mouseY-sphereScreenY, 2));
-            if (distance < pixel_sphere_radius) {
+            // a recording can't be dragged
+            if (distance < pixel_sphere_radius && !playing) {
                 isDragging = true;
                 glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
       //          std::cout << "Started Dragging" << std::endl;
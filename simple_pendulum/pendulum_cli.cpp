@@ -0,0 +1,81 @@
+// The pendulum without a window: steps it for a given stretch of sim time as fast as the CPU goes and streams
+// (theta, theta_dot) every --frame-dt to a sim_record.h file that main --play can scrub through.
+//
+//   g++ -O2 -std=c++17 -I.. pendulum_cli.cpp -o pendulum_cli
+//   ./pendulum_cli --out pendulum.rec --seconds 3600 --theta 170
+//
+// Leapfrog at the same 1 ms as main.cpp. Frames land on whole steps, so --frame-dt is rounded to a multiple of the
+// step. Model parameters in the header: g, rope length, starting angle, step.
+
+#include "ode.h"
+#include "sim_record.h"
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* outPath = nullptr;
+    double seconds = 60.0;
+    double frameDt = 1.0 / 100.0;
+    double step = 1e-3;
+    double g = 9.81, ropeLength = 3.0;
+    double theta = 20.0 * M_PI / 180.0;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--frame-dt") == 0 && hasValue)
+            frameDt = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--step") == 0 && hasValue)
+            step = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--theta") == 0 && hasValue)
+            theta = std::atof(argv[++i]) * M_PI / 180.0;
+        else if (std::strcmp(argv[i], "--length") == 0 && hasValue)
+            ropeLength = std::atof(argv[++i]);
+        else
+        {
+            std::cerr << "usage: pendulum_cli --out file|- [--seconds T] [--frame-dt dt] [--step h] [--theta degrees]"
+                      << " [--length L]" << std::endl;
+            return -1;
+        }
+    }
+    if (!outPath)
+    {
+        std::cerr << "ERROR::PENDULUM_CLI:: --out is required" << std::endl;
+        return -1;
+    }
+
+    int stepsPerFrame = std::max(1, (int)std::lround(frameDt / step));
+    frameDt = stepsPerFrame * step;
+    uint64_t frames = (uint64_t)std::llround(seconds / frameDt) + 1;
+    SimRecordWriter writer;
+    if (!writer.open(outPath, "simple_pendulum", 2, frameDt, { g, ropeLength, theta, step }))
+        return -1;
+
+    auto accel = [=](double angle) { return -(g / ropeLength) * std::sin(angle); };
+    Leapfrog<double, double> pendulum(theta, 0.0, step);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t f = 0; f < frames; f++)
+    {
+        for (int s = 0; f > 0 && s < stepsPerFrame; s++)
+            pendulum.step(accel);
+        float frame[2] = { (float)pendulum.position(), (float)pendulum.velocity() };
+        if (!writer.write(frame))
+            return -1;
+    }
+    writer.close();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << writer.frameCount() << " frames, " << seconds << "s of sim time in " << wall << "s ("
+              << seconds / wall << "x real time), " << pendulum.stats.evaluations << " evaluations, "
+              << writer.bytesWritten() / 1e6 << " MB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in float Life;
+
+uniform vec3 color;
+
+void main()
+{
+    // 1.0 when fresh, 0.0 when dying
+    FragColor = vec4(color * clamp(Life, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,104 @@
+// How much of a pulse comes back off the edges of the grid against what the grid costs: fixed (u = 0) edges padded
+// out by more and more cells, and absorbing edges (waveAbsorbEdges) with little or no padding. The region of interest
+// is n x n cells with a Gaussian in the middle; every run is compared over that region against one on a grid wide
+// enough that nothing reflected gets back inside the run. The error is the worst, over checkpoints every 100 steps, of
+// the squared difference summed over the region, as a fraction of the pulse's starting energy.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 -pthread absorb_bench.cpp -o absorb_bench
+//   ./absorb_bench [n] [steps]        (default 200 and 2000)
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+static const float R = 0.3f;
+
+struct Run {
+    std::vector<std::vector<float>> checkpoints; // the region of interest every 100 steps
+    double seconds;
+    double cellSteps;
+};
+
+// the region of interest with 'pad' cells around it
+static Run run(int n, int pad, int steps, bool absorbing)
+{
+    const int size = n + 2 * pad;
+    Grid2D<float> past(size, size), current(size, size);
+    for (int i = 1; i < size - 1; ++i)
+        for (int k = 1; k < size - 1; ++k)
+        {
+            float x = i - size / 2.0f, y = k - size / 2.0f;
+            past[i][k] = 10.0f * std::exp(-(x * x + y * y) / (2.0f * 5.0f * 5.0f));
+        }
+    waveStartStep(past, current, R * R);
+
+    WaveSolver solver(R * R);
+    if (absorbing)
+        solver.setAbsorbingEdges(R);
+    Run result;
+    result.seconds = 0.0;
+    result.cellSteps = (double)size * size * steps;
+    for (int done = 0; done < steps; done += 100)
+    {
+        auto start = std::chrono::steady_clock::now();
+        solver.advance(past, current, std::min(100, steps - done));
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<float> region;
+        region.reserve((size_t)n * n);
+        for (int i = 0; i < n; ++i)
+            region.insert(region.end(), current[pad + i] + pad, current[pad + i] + pad + n);
+        result.checkpoints.push_back(region);
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::max(16, std::atoi(argv[1])) : 200;
+    int steps = argc > 2 ? std::max(100, std::atoi(argv[2])) : 2000;
+
+    // a reflection has to go out the padding and back at 0.3 cells a step; the numerical scheme can't move anything
+    // faster than a cell a step, so this much padding keeps even that out
+    const int referencePad = steps / 2 + 16;
+    Run reference = run(n, referencePad, steps, false);
+
+    double startEnergy = 0.0;
+    for (int i = 0; i < n; ++i)
+        for (int k = 0; k < n; ++k)
+        {
+            float x = i - n / 2.0f, y = k - n / 2.0f;
+            float u = 10.0f * std::exp(-(x * x + y * y) / (2.0f * 5.0f * 5.0f));
+            startEnergy += (double)u * u;
+        }
+
+    std::cout << n << "x" << n << " region, " << steps << " steps, reference padded by " << referencePad << "\n"
+              << "  edges      pad   grid       cell updates  seconds    reflected energy\n";
+    struct Case { bool absorbing; int pad; };
+    for (Case c : { Case{ false, 0 }, Case{ false, 25 }, Case{ false, 50 }, Case{ false, 100 }, Case{ false, 200 },
+                    Case{ true, 0 }, Case{ true, 4 }, Case{ true, 16 } })
+    {
+        Run result = run(n, c.pad, steps, c.absorbing);
+        double worst = 0.0;
+        for (size_t p = 0; p < result.checkpoints.size(); ++p)
+        {
+            double error = 0.0;
+            for (size_t j = 0; j < result.checkpoints[p].size(); ++j)
+            {
+                double d = result.checkpoints[p][j] - reference.checkpoints[p][j];
+                error += d * d;
+            }
+            worst = std::max(worst, error / startEnergy);
+        }
+        int size = n + 2 * c.pad;
+        std::cout << "  " << (c.absorbing ? "absorbing" : "fixed    ") << "  " << c.pad << "\t" << size << "x" << size
+                  << "\t" << result.cellSteps / 1e6 << "M\t" << result.seconds << "\t" << worst << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <utility>
+
+// In place radix 2 FFT of one power of two length: the input put in bit reversed order, then log2(n) passes of
+// butterflies. The bit reversal and the twiddles (worked out in double) are made once per length. forward is
+// X[m] = sum_j x[j] e^(-2 pi i j m / n); inverse is the same with +i and no 1/n, the caller scales.
+class Fft
+{
+public:
+    explicit Fft(int n = 1) { resize(n); }
+
+    static bool isPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+    // n has to be a power of two
+    void resize(int n)
+    {
+        length = n;
+        reversed.assign(n, 0);
+        int bits = 0;
+        while ((1 << bits) < n)
+            bits++;
+        for (int j = 0; j < n; j++)
+            for (int b = 0; b < bits; b++)
+                if (j & (1 << b))
+                    reversed[j] |= 1 << (bits - 1 - b);
+        twiddles.resize(n / 2);
+        const double pi = 3.14159265358979323846;
+        for (int j = 0; j < n / 2; j++)
+            twiddles[j] = std::complex<float>((float)std::cos(2.0 * pi * j / n), (float)-std::sin(2.0 * pi * j / n));
+    }
+
+    int size() const { return length; }
+
+    void transform(std::complex<float> *data, bool inverse) const
+    {
+        for (int j = 0; j < length; j++)
+            if (j < reversed[j])
+                std::swap(data[j], data[reversed[j]]);
+        // the products written out: std::complex's operator* checks for inf and nan the slow way
+        float *d = reinterpret_cast<float*>(data);
+        const float *w = reinterpret_cast<const float*>(twiddles.data());
+        const float sign = inverse ? -1.0f : 1.0f;
+        for (int half = 1; half < length; half *= 2)
+        {
+            const int step = length / (2 * half);
+            for (int start = 0; start < length; start += 2 * half)
+                for (int j = 0; j < half; j++)
+                {
+                    float wr = w[2 * j * step], wi = sign * w[2 * j * step + 1];
+                    float *a = d + 2 * (start + j), *b = d + 2 * (start + j + half);
+                    float vr = b[0] * wr - b[1] * wi, vi = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - vr;
+                    b[1] = a[1] - vi;
+                    a[0] += vr;
+                    a[1] += vi;
+                }
+        }
+    }
+
+private:
+    int length = 0;
+    std::vector<int> reversed;
+    std::vector<std::complex<float>> twiddles; // e^(-2 pi i j / n) for j < n / 2
+};
+#endif
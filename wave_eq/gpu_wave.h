@@ -0,0 +1,121 @@
+#ifndef GPU_WAVE_H
+#define GPU_WAVE_H
+
+#include <glad/glad.h>
+
+#include "shader_m.h"
+#include "wave_grid.h"
+
+#include <iostream>
+
+// The wave grid kept on the GPU: three R32F textures, each the colour attachment of its own framebuffer, cols texels
+// wide and rows high so texel (k, i) is grid[i][k]. A step is one full-screen pass of wave_step.vs/fs reading past and
+// current and writing next, then the three rotate (ping-pong between three). Nothing is read back, and after the
+// starting levels go up once nothing is uploaded either; whatever draws the wave samples heights() in its vertex
+// shader.
+class GpuWave
+{
+public:
+    // past and current are the two starting levels, as from waveStartStep
+    GpuWave(const Grid2D<float> &past, const Grid2D<float> &current, float r2)
+        : rows(past.rows()), cols(past.cols()), r2(r2)
+    {
+        glGenTextures(3, textures);
+        glGenFramebuffers(3, framebuffers);
+        for (int i = 0; i < 3; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cols, rows, 0, GL_RED, GL_FLOAT, nullptr);
+            // heights are fetched per texel, never filtered
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::GPU_WAVE:: Framebuffer is not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        upload(textures[PAST], past);
+        upload(textures[CURRENT], current);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // the full-screen triangle comes from gl_VertexID, the VAO is only there because core profile wants one bound
+        glGenVertexArrays(1, &emptyVAO);
+    }
+
+    // 'steps' leapfrog steps with stepShader (wave_step.vs/fs)
+    void step(Shader &stepShader, int steps)
+    {
+        if (steps <= 0)
+            return;
+        GLint oldViewport[4];
+        glGetIntegerv(GL_VIEWPORT, oldViewport);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+        glViewport(0, 0, cols, rows);
+
+        stepShader.use();
+        stepShader.setInt("past", 0);
+        stepShader.setInt("current", 1);
+        stepShader.setFloat("r2", r2);
+        glBindVertexArray(emptyVAO);
+        for (int s = 0; s < steps; s++)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[order[NEXT]]);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, textures[order[PAST]]);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, textures[order[CURRENT]]);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            int oldPast = order[PAST];
+            order[PAST] = order[CURRENT];
+            order[CURRENT] = order[NEXT];
+            order[NEXT] = oldPast;
+        }
+        stepCount += steps;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+    }
+
+    unsigned int heights() const { return textures[order[CURRENT]]; }
+    unsigned int previousHeights() const { return textures[order[PAST]]; }
+    int gridRows() const { return rows; }
+    int gridCols() const { return cols; }
+    long long steps() const { return stepCount; }
+
+    // call before the context goes away
+    void Delete()
+    {
+        glDeleteFramebuffers(3, framebuffers);
+        glDeleteTextures(3, textures);
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+
+private:
+    enum { PAST = 0, CURRENT = 1, NEXT = 2 };
+    int rows, cols;
+    float r2;
+    unsigned int textures[3];
+    unsigned int framebuffers[3];
+    unsigned int emptyVAO;
+    int order[3] = { 0, 1, 2 }; // which texture holds past, current and next
+    long long stepCount = 0;
+
+    void upload(unsigned int texture, const Grid2D<float> &grid)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)grid.stride());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cols, rows, GL_RED, GL_FLOAT, grid[0]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+};
+#endif
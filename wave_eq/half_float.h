@@ -0,0 +1,185 @@
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// 16 bit storage formats for grids that are computed on in float: Half is IEEE binary16 (11 bits of precision, up to
+// 65504), BFloat16 the top half of a float (8 bits of precision, float's range). Neither does arithmetic, values go
+// through toFloat() to be used and fromFloat<T>() to be stored, rounding to nearest even. The all-zero bit pattern is
+// 0 in both, so zeroed memory is a zeroed grid.
+//
+// fromFloatDithered<T>() rounds up or down instead with odds set by how close the value is to each neighbour, so the
+// rounding errors of a long run average out rather than pile up (a value changing by less than half a step each time
+// never moves at all under round to nearest). The coin is a hash the caller supplies, so results are reproducible.
+struct Half
+{
+    uint16_t bits;
+};
+
+struct BFloat16
+{
+    uint16_t bits;
+};
+
+inline float toFloat(float value) { return value; }
+
+inline float toFloat(Half value)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(value.bits);
+#else
+    // exponent rebiased from 15 to 127, subnormals normalised through a float subtraction
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    uint32_t bits = (uint32_t)(value.bits & 0x7fffu) << 13;
+    uint32_t exponent = bits & shiftedExponent;
+    bits += (127u - 15u) << 23;
+    if (exponent == shiftedExponent)
+        bits += (128u - 16u) << 23; // inf and nan
+    else if (exponent == 0)
+    {
+        const uint32_t magicBits = 113u << 23;
+        float f, magic;
+        bits += 1u << 23;
+        std::memcpy(&f, &bits, 4);
+        std::memcpy(&magic, &magicBits, 4);
+        f -= magic;
+        std::memcpy(&bits, &f, 4);
+    }
+    bits |= (uint32_t)(value.bits & 0x8000u) << 16;
+    float result;
+    std::memcpy(&result, &bits, 4);
+    return result;
+#endif
+}
+
+inline float toFloat(BFloat16 value)
+{
+    uint32_t bits = (uint32_t)value.bits << 16;
+    float result;
+    std::memcpy(&result, &bits, 4);
+    return result;
+}
+
+template<class T> T fromFloat(float value);
+
+template<> inline float fromFloat<float>(float value) { return value; }
+
+template<> inline Half fromFloat<Half>(float value)
+{
+#if defined(__F16C__)
+    return Half{ (uint16_t)_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT) };
+#else
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t result;
+    if (bits >= (127u + 16u) << 23)
+        result = bits > 0x7f800000u ? 0x7e00 : 0x7c00; // nan, or too big: inf
+    else if (bits < 113u << 23)
+    {
+        // subnormal or zero: adding 0.5 lines the half's last mantissa bit up with the float's, the add rounds
+        const uint32_t magicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+        float f, magic;
+        std::memcpy(&f, &bits, 4);
+        std::memcpy(&magic, &magicBits, 4);
+        f += magic;
+        std::memcpy(&bits, &f, 4);
+        result = (uint16_t)(bits - magicBits);
+    }
+    else
+    {
+        uint32_t odd = (bits >> 13) & 1u;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xfffu + odd;
+        result = (uint16_t)(bits >> 13);
+    }
+    return Half{ (uint16_t)(result | (sign >> 16)) };
+#endif
+}
+
+template<> inline BFloat16 fromFloat<BFloat16>(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    if ((bits & 0x7fffffffu) > 0x7f800000u)
+        return BFloat16{ (uint16_t)((bits >> 16) | 0x40u) }; // keep nan a nan
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return BFloat16{ (uint16_t)(bits >> 16) };
+}
+
+// a 32 bit hash for the coin, one multiply round: the low bits are all that's used and they come out mixed enough
+inline uint32_t ditherHash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    return x;
+}
+
+// the amount to add to value before truncating it to a Half, a uniform fraction (the low 13 bits of hash) of the Half
+// step at value's size, with value's sign. Half's steps stop shrinking below 2^-14 (subnormals), at 2^-24
+inline float halfDither(float value, uint32_t hash)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    int exponent = (int)((bits >> 23) & 0xffu);
+    uint32_t scaleBits = (uint32_t)(std::max(exponent - 10, 103) - 13) << 23;
+    float scale;
+    std::memcpy(&scale, &scaleBits, 4);
+    float dither = (float)(hash & 0x1fffu) * scale;
+    return (bits & 0x80000000u) ? -dither : dither;
+}
+
+inline Half halfTowardZero(float value)
+{
+#if defined(__F16C__)
+    return Half{ (uint16_t)_cvtss_sh(value, _MM_FROUND_TO_ZERO) };
+#else
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t result;
+    if (bits > 0x7f800000u)
+        result = 0x7e00;
+    else if (bits == 0x7f800000u)
+        result = 0x7c00;
+    else if (bits >= (127u + 16u) << 23)
+        result = 0x7bff; // truncating never rounds up to inf
+    else if (bits < 113u << 23)
+    {
+        float magnitude;
+        std::memcpy(&magnitude, &bits, 4);
+        result = (uint16_t)(magnitude * 16777216.0f); // in units of 2^-24, the cast truncates
+    }
+    else
+        result = (uint16_t)((bits - (112u << 23)) >> 13);
+    return Half{ (uint16_t)(result | (sign >> 16)) };
+#endif
+}
+
+template<class T> T fromFloatDithered(float value, uint32_t hash);
+
+template<> inline float fromFloatDithered<float>(float value, uint32_t) { return value; }
+
+template<> inline Half fromFloatDithered<Half>(float value, uint32_t hash)
+{
+    return halfTowardZero(value + halfDither(value, hash));
+}
+
+template<> inline BFloat16 fromFloatDithered<BFloat16>(float value, uint32_t hash)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    if ((bits & 0x7fffffffu) > 0x7f800000u)
+        return BFloat16{ (uint16_t)((bits >> 16) | 0x40u) };
+    bits += hash & 0xffffu;
+    return BFloat16{ (uint16_t)(bits >> 16) };
+}
+#endif
@@ -0,0 +1,276 @@
+#ifndef HALO_TRANSPORT_H
+#define HALO_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <csignal>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Point to point messages between the ranks of a fixed group of processes, all that SlabWaveSolver needs to swap halo
+// rows: blocking send and receive of raw bytes, in order between any two ranks, and a barrier. It's the part of MPI the
+// solver uses, so an MPI version is send = MPI_Send, receive = MPI_Recv and barrier = MPI_Barrier on a communicator.
+class HaloTransport
+{
+public:
+    virtual ~HaloTransport() {}
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    // returns once data can be reused, which may be before 'to' has received it
+    virtual void send(int to, const void *data, size_t bytes) = 0;
+    // returns once the next 'bytes' from 'from' are in data
+    virtual void receive(int from, void *data, size_t bytes) = 0;
+    virtual void barrier() = 0;
+
+    // swaps equal sized messages with peer. The lower rank sends first and the higher receives first, so this never
+    // waits on itself however little the transport buffers
+    void exchange(int peer, const void *out, void *in, size_t bytes)
+    {
+        if (rank() < peer)
+        {
+            send(peer, out, bytes);
+            receive(peer, in, bytes);
+        }
+        else
+        {
+            receive(peer, in, bytes);
+            send(peer, out, bytes);
+        }
+    }
+};
+
+// HaloTransport between processes forked from the one that made it, over a POSIX shared memory object mapped before
+// the fork. Every ordered pair of ranks has a channel: a ring of 'slots' fixed size slots counted by two process shared
+// semaphores (futexes underneath on Linux, so a waiting rank sleeps in the kernel rather than spinning), one for the
+// slots holding data and one for the free ones. A message bigger than a slot goes through in pieces. The object is
+// unlinked as soon as it's mapped, so nothing is left behind however the processes end.
+//
+// Make it in the parent, then runProcesses(); each child gets its rank through the transport.
+class SharedMemoryTransport : public HaloTransport
+{
+public:
+    SharedMemoryTransport(int ranks, size_t slotBytes = 256 * 1024, int slots = 4)
+        : ranks(std::max(1, ranks)), slotBytes(std::max<size_t>(64, slotBytes)), slots(std::max(1, slots))
+    {
+        channelBytes = (sizeof(Channel) + this->slots * this->slotBytes + 63) / 64 * 64;
+        mappedBytes = 64 + (size_t)this->ranks * this->ranks * channelBytes;
+
+        std::string name = "/wave_halo_" + std::to_string(getpid());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            std::cout << "ERROR::HALO_TRANSPORT::SHM_OPEN_FAILED: " << name << std::endl;
+            return;
+        }
+        shm_unlink(name.c_str());
+        if (ftruncate(fd, (off_t)mappedBytes) != 0)
+        {
+            std::cout << "ERROR::HALO_TRANSPORT::FTRUNCATE_FAILED: " << mappedBytes << " bytes" << std::endl;
+            close(fd);
+            return;
+        }
+        void *mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            std::cout << "ERROR::HALO_TRANSPORT::MMAP_FAILED: " << mappedBytes << " bytes" << std::endl;
+            return;
+        }
+        base = static_cast<unsigned char*>(mapped);
+
+        pthread_barrierattr_t attributes;
+        pthread_barrierattr_init(&attributes);
+        pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_barrier_init(groupBarrier(), &attributes, (unsigned)this->ranks);
+        pthread_barrierattr_destroy(&attributes);
+        for (int from = 0; from < this->ranks; from++)
+            for (int to = 0; to < this->ranks; to++)
+            {
+                Channel *c = channel(from, to);
+                sem_init(&c->full, 1, 0);
+                sem_init(&c->empty, 1, (unsigned)this->slots);
+                c->writeSlot = c->readSlot = 0;
+            }
+    }
+
+    ~SharedMemoryTransport()
+    {
+        if (base)
+            munmap(base, mappedBytes);
+    }
+
+    SharedMemoryTransport(const SharedMemoryTransport&) = delete;
+    SharedMemoryTransport& operator=(const SharedMemoryTransport&) = delete;
+
+    bool valid() const { return base != nullptr; }
+
+    int rank() const override { return me; }
+    int size() const override { return ranks; }
+
+    void send(int to, const void *data, size_t bytes) override
+    {
+        Channel *c = channel(me, to);
+        const unsigned char *from = static_cast<const unsigned char*>(data);
+        for (size_t done = 0; done < bytes; done += slotBytes)
+        {
+            size_t piece = std::min(slotBytes, bytes - done);
+            waitOn(&c->empty);
+            std::memcpy(slot(c, c->writeSlot), from + done, piece);
+            c->writeSlot = (c->writeSlot + 1) % slots;
+            sem_post(&c->full);
+        }
+    }
+
+    void receive(int from, void *data, size_t bytes) override
+    {
+        Channel *c = channel(from, me);
+        unsigned char *to = static_cast<unsigned char*>(data);
+        for (size_t done = 0; done < bytes; done += slotBytes)
+        {
+            size_t piece = std::min(slotBytes, bytes - done);
+            waitOn(&c->full);
+            std::memcpy(to + done, slot(c, c->readSlot), piece);
+            c->readSlot = (c->readSlot + 1) % slots;
+            sem_post(&c->empty);
+        }
+    }
+
+    void barrier() override { pthread_barrier_wait(groupBarrier()); }
+
+    // forks one process per rank, each running body with this transport as that rank, and waits for all of them.
+    // With pinToNodes, rank r is confined to the CPUs of NUMA node r % nodes before body runs, so the memory it first
+    // touches (its slab) is placed on that node. Returns whether every rank exited with 0
+    bool runProcesses(const std::function<int(HaloTransport&)> &body, bool pinToNodes = true)
+    {
+        if (!base)
+            return false;
+        std::vector<std::vector<int>> nodes = numaNodeCpus();
+        std::cout << std::flush;
+        std::vector<pid_t> children;
+        for (int r = 0; r < ranks; r++)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                me = r;
+                if (pinToNodes)
+                    pinToCpus(nodes[r % nodes.size()]);
+                int status = body(*this);
+                std::cout << std::flush;
+                _exit(status);
+            }
+            if (pid < 0)
+            {
+                std::cout << "ERROR::HALO_TRANSPORT::FORK_FAILED: rank " << r << std::endl;
+                for (pid_t child : children)
+                    kill(child, SIGKILL);
+                for (pid_t child : children)
+                    waitpid(child, nullptr, 0);
+                return false;
+            }
+            children.push_back(pid);
+        }
+        bool ok = true;
+        for (pid_t child : children)
+        {
+            int status = 0;
+            waitpid(child, &status, 0);
+            ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+        return ok;
+    }
+
+    // the CPUs of each NUMA node, from /sys; one node with every CPU where there's no such thing
+    static std::vector<std::vector<int>> numaNodeCpus()
+    {
+        std::vector<std::vector<int>> nodes;
+        for (int node = 0;; node++)
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!file || !std::getline(file, list))
+                break;
+            std::vector<int> cpus;
+            int first = -1, last = -1;
+            for (const char *p = list.c_str(); *p;)
+            {
+                int consumed = 0;
+                if (std::sscanf(p, "%d-%d%n", &first, &last, &consumed) == 2 ||
+                    (std::sscanf(p, "%d%n", &first, &consumed) == 1 && (last = first, true)))
+                {
+                    for (int cpu = first; cpu <= last; cpu++)
+                        cpus.push_back(cpu);
+                    p += consumed;
+                }
+                if (*p)
+                    p++; // the comma
+            }
+            if (!cpus.empty())
+                nodes.push_back(cpus);
+        }
+        if (nodes.empty())
+        {
+            nodes.emplace_back();
+            for (long cpu = 0; cpu < sysconf(_SC_NPROCESSORS_ONLN); cpu++)
+                nodes.back().push_back((int)cpu);
+        }
+        return nodes;
+    }
+
+private:
+    struct Channel
+    {
+        sem_t full, empty;
+        int writeSlot; // only the sending rank touches this
+        int readSlot;  // and only the receiving rank this
+    };
+
+    int ranks;
+    size_t slotBytes;
+    int slots;
+    size_t channelBytes = 0, mappedBytes = 0;
+    unsigned char *base = nullptr; // the barrier in the first 64 bytes, then the channels, from-major
+    int me = 0;
+    static_assert(sizeof(pthread_barrier_t) <= 64, "the barrier has to fit ahead of the channels");
+
+    pthread_barrier_t* groupBarrier() { return reinterpret_cast<pthread_barrier_t*>(base); }
+    Channel* channel(int from, int to)
+    {
+        return reinterpret_cast<Channel*>(base + 64 + ((size_t)from * ranks + to) * channelBytes);
+    }
+    unsigned char* slot(Channel *c, int index) { return reinterpret_cast<unsigned char*>(c + 1) + index * slotBytes; }
+
+    static void waitOn(sem_t *semaphore)
+    {
+        while (sem_wait(semaphore) != 0)
+            ; // interrupted by a signal
+    }
+
+    static void pinToCpus(const std::vector<int> &cpus)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+            CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+#endif
+    }
+};
+#endif
@@ -7,10 +7,22 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#define FRAME_ARENA_COUNT_HEAP
+#include "frame_arena.h"
+#include "sim_runner.h"
+#include "wave_grid.h"
+#include "wave_solver.h"
+#include "height_grid.h"
+#include "wave_record.h"
+#include "sim_record.h"
 
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 #include <array>
 #include <vector>
@@ -43,6 +55,20 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// M switches between the point cloud and the lit surface
+static bool drawSurface = false;
+
+// --play: a wave_cli recording, plain or --compress, drives the heights instead of the sim. Left/right arrows scrub,
+// space pauses and R goes back to the start
+WaveRecordReader recording;   // --compress: frames are decoded into playFrom and playTo
+SimRecordReader rawRecording; // plain: frames are read straight out of the mapping
+bool playRaw = false;
+bool playing = false;
+bool playPaused = false;
+double playTime = 0.0;
+std::vector<float> playFrom, playTo; // the decoded frames either side of playTime
+uint64_t playFrame = UINT64_MAX;     // which one playFrom is
+
 // Function to plot: z = f(x, y)
 float functionToPlot(float x, float y) {
     // Try different functions!
@@ -82,24 +108,112 @@ void generatePlotParticles(std::vector<float>& positions,
     }
 }
 
-void updateParticlesFromWave(std::vector<float>& positions,
-                             const std::vector<std::vector<float>>& wave_slice,
-                             const std::vector<float>& x,
-                             const std::vector<float>& y) {
-    positions.clear();
+typedef Grid2D<float> WaveGrid; // contiguous and padded, [i][k] indexes it like the old vector<vector>
+
+// what the sim thread owns: the last two time levels of the scheme
+struct WaveModel {
+    WaveGrid past;
+    WaveGrid current;
+};
+
+// writes the height of every grid point into heights (rows * cols floats, HeightGrid's vertex order), returns the
+// count. the height is blended from 'from' to 'to' by alpha
+size_t updateHeightsFromWave(float* heights,
+                             const WaveGrid& from,
+                             const WaveGrid& to,
+                             float alpha) {
+    size_t n = 0;
+    for (int i=0;i<to.rows();++i) {
+        const float* fromRow = from[i];
+        const float* toRow = to[i];
+        for (int k=0;k<to.cols();++k)
+            heights[n++] = fromRow[k] + alpha * (toRow[k] - fromRow[k]);
+    }
+    return n;
+}
 
-    for (int i=0;i<x.size();++i) {
-        for (int k=0;k<y.size();++k){
-            positions.push_back(x[i]);
-            positions.push_back(wave_slice[i][k]);
-            positions.push_back(y[k]);
+// the heights at playTime, blended between the two recorded frames either side. Playing forward only decodes the
+// frame it moves on to; a jump goes back to the start of the frame's chunk
+size_t updateHeightsFromRecording(float* heights) {
+    if (!playPaused)
+        playTime += deltaTime;
+    playTime = std::min(std::max(playTime, 0.0), playRaw ? rawRecording.duration() : recording.duration());
+    double position = playTime / (playRaw ? rawRecording.header().frameDt : recording.header().frameDt);
+    uint64_t frameCount = playRaw ? rawRecording.frameCount() : recording.frameCount();
+    uint64_t frame = std::min((uint64_t)position, frameCount - 1);
+    uint64_t next = std::min(frame + 1, frameCount - 1);
+    float blend = (float)(position - frame);
+    if (playRaw) {
+        const float* from = rawRecording.frame(frame);
+        const float* to = rawRecording.frame(next);
+        for (size_t j = 0; j < rawRecording.frameFloats(); ++j)
+            heights[j] = from[j] + blend * (to[j] - from[j]);
+        return rawRecording.frameFloats();
+    }
+    if (frame != playFrame) {
+        bool ok;
+        if (playFrame != UINT64_MAX && frame == playFrame + 1 && next != frame) {
+            playFrom.swap(playTo);
+            ok = recording.decode(next, playTo.data());
+        } else {
+            ok = recording.decode(frame, playFrom.data()) && recording.decode(next, playTo.data());
         }
+        playFrame = ok ? frame : UINT64_MAX;
     }
+    for (size_t j = 0; j < playFrom.size(); ++j)
+        heights[j] = playFrom[j] + blend * (playTo[j] - playFrom[j]);
+    return playFrom.size();
+}
 
+// whether path starts like a wave_record.h file, so --play knows which reader to open it with
+bool isCompressedRecording(const char* path) {
+    char magic[sizeof(WAVE_RECORD_MAGIC)] = {};
+    FILE* file = std::fopen(path, "rb");
+    if (!file)
+        return false;
+    bool compressed = std::fread(magic, sizeof(magic), 1, file) == 1 &&
+                      std::memcmp(magic, WAVE_RECORD_MAGIC, sizeof(magic)) == 0;
+    std::fclose(file);
+    return compressed;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    // the grid a recording was made on: L, then nx and ny
+    float playL = 20.0f;
+    int playRows = 0, playCols = 0;
+    if (argc == 3 && std::strcmp(argv[1], "--play") == 0)
+    {
+        playRaw = !isCompressedRecording(argv[2]);
+        bool opened;
+        if (playRaw) {
+            // wave_cli's plain header params are L, nx, ny, ...
+            opened = rawRecording.open(argv[2]) && rawRecording.header().paramCount >= 3;
+            if (opened) {
+                playL = (float)rawRecording.header().params[0];
+                playRows = (int)rawRecording.header().params[1];
+                playCols = (int)rawRecording.header().params[2];
+                opened = rawRecording.frameCount() > 0 && (size_t)playRows * playCols == rawRecording.frameFloats();
+            }
+        } else {
+            opened = recording.open(argv[2]) && recording.frameCount() > 0;
+            if (opened) {
+                if (recording.header().paramCount > 0)
+                    playL = (float)recording.header().params[0];
+                playRows = (int)recording.rows();
+                playCols = (int)recording.cols();
+                playFrom.resize((size_t)playRows * playCols);
+                playTo.resize(playFrom.size());
+            }
+        }
+        if (!opened || playRows < 2 || playCols < 2)
+        {
+            std::cout << "ERROR::PLAYBACK::NOT_A_WAVE_RECORDING " << argv[2] << std::endl;
+            return -1;
+        }
+        playing = true;
+    }
+
     // glfw: initialize and configure
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -138,20 +252,22 @@ int main()
     glEnable(GL_PROGRAM_POINT_SIZE);  // Allow setting point size in shader
 
     // build and compile shaders
-    Shader particleShader("particle.vs", "particle.fs");
+    Shader particleShader("height_grid.vs", "particle.fs");
+    Shader surfaceShader("height_surface.vs", "2.2.basic_lighting.fs");
 
 
 
 /// WAVE SETUP
 
-    float L = 20.0f;
+    float L = playing ? playL : 20.0f;
     float sigma = 1.0f;
     float c = 1.0;
     float t_final = 10.0f;
 
     /// nx,ny stuff:
-    float nx = 150;
-    float ny = 150;
+    // ./main [gridSize] [absorbing] or ./main --play file, M toggles the surface
+    int nx = playing ? playRows : argc > 1 ? std::max(3, std::atoi(argv[1])) : 150;
+    int ny = playing ? playCols : nx;
     float dx = L / (nx - 1.0f);
     float dy = L / (ny - 1.0f);
 
@@ -167,7 +283,6 @@ int main()
     /// pause for VAOs stuff
 
     // Generate the particle positions for our function
-    std::vector<float> particlePositions;
     
     // Domain: x from -10 to 10, y from -10 to 10
     // Samples: 100x100 = 10,000 particles
@@ -193,9 +308,8 @@ int main()
     }
 
 
-    std::vector<std::vector<float>> u_past(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
-    std::vector<std::vector<float>> u_current(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
-    std::vector<std::vector<float>> u_next(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
+    WaveGrid u_past(static_cast<int>(nx), static_cast<int>(ny));
+    WaveGrid u_current(static_cast<int>(nx), static_cast<int>(ny));
 
 
 
@@ -238,30 +352,32 @@ int main()
 
 
 
-    int stepsPerFrame = 1;
-    int frameSkip = 1;  // Only update physics every 5th frame
+    // the time stepping runs on its own thread at a fixed rate, WAVE_STEPS_PER_TICK steps at a time through the tiled
+    // solver; raise it (10-100 is fine on a 2048^2 grid) for a faster wave on a bigger grid
+    const double WAVE_STEPS_PER_SECOND = 60.0;
+    const int WAVE_STEPS_PER_TICK = 1;
+    ThreadPool wavePool;
+    WaveSolver waveSolver(rx*rx, &wavePool);
+    if (argc > 2 && std::strcmp(argv[2], "absorbing") == 0)
+        waveSolver.setAbsorbingEdges(rx); // the wave leaves through the edges instead of bouncing back
+    SimRunner<WaveModel, WaveGrid> sim(WaveModel{ u_past, u_current }, 1.0 / WAVE_STEPS_PER_SECOND,
+                             [&](WaveModel& model) {
+        // (j = time, i = x, k = y), rx == ry so the stencil takes a single r^2; the boundary stays at zero
+        waveSolver.advance(model.past, model.current, WAVE_STEPS_PER_TICK);
+    }, [](const WaveModel& model, WaveGrid& shown) {
+        shown = model.current; // the renderer only draws the newest level
+    });
+    if (!playing)
+        sim.start();
     int frameCounter = 0;
 
 /// END OF SETUP
 
 
-    updateParticlesFromWave(particlePositions, u_current, x, y);
-    std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
-
-
-    // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
-
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, particlePositions.size() * sizeof(float), 
-             particlePositions.data(), GL_DYNAMIC_DRAW);  // use .data(), not nullptr
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
+    // x and z go up once, after that a frame only sends one height per point
+    HeightGrid heightGrid(x, y);
+    FrameArena frameArena(heightGrid.vertexCount() * sizeof(float) + 4096);
+    std::cout << "Generated " << heightGrid.vertexCount() << " particles" << std::endl;
 
     /// end VAO set up
     // render loop
@@ -273,6 +389,14 @@ int main()
         lastFrame = currentFrame;
         frameCounter++;
 
+        // vertex data is rebuilt in the frame arena every frame, the heap count should stay at 0
+        frameArena.beginFrame();
+        if (frameCounter % 600 == 0) {
+            std::cout << "heap allocations last frame: " << frameArena.heapAllocationsLastFrame() << std::endl;
+            if (!playing)
+                sim.report();
+        }
+
         // input
         processInput(window);
 
@@ -291,31 +415,10 @@ int main()
 
     // MAIN LOOP
 
-    // (j = time, i = x, k = y):
-    if (frameCounter % frameSkip == 0) {
-   
-        for (int step =0; step < stepsPerFrame; step++) {
-                for (int i=1; i < nx-1; ++i) {
-                        for (int k=1; k<ny-1; ++k) {
-                            u_next[i][k] = 2*u_current[i][k] - u_past[i][k] + (rx*rx)*(u_current[i+1][k] - 2*u_current[i][k] + u_current[i-1][k]) + (ry*ry)*(u_current[i][k+1] - 2*u_current[i][k] + u_current[i][k-1]);
-                        }
-                }
-
-                for (int i=0; i<nx; ++i){
-                    u_next[i][0] = 0.0f;
-                    u_next[i][ny-1] = 0.0f;
-                }
-                for (int k=0; k<ny; ++k){
-                    u_next[0][k] = 0.0f;
-                    u_next[nx-1][k] = 0.0f;
-                }
-
-                u_past = u_current;
-                u_current = u_next;
-
-        }
-
-    }
+        // the wave one sim step behind, blended between the last two levels the sim thread published
+        const SimSnapshot<WaveGrid>& snapshot = sim.latest();
+        float alpha = (float)sim.alpha();
+        sim.recordFrame(deltaTime);
 
 
 
@@ -329,13 +432,24 @@ int main()
         particleShader.setMat4("view", view);
 
         // DATA
-        updateParticlesFromWave(particlePositions, u_current, x, y);
-
-        glBindVertexArray(particleVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, particlePositions.size() * sizeof(float), 
-                particlePositions.data());
-        glDrawArrays(GL_POINTS, 0, particlePositions.size() / 3);
+        float* heights = frameArena.allocate<float>(heightGrid.vertexCount());
+        if (playing)
+            updateHeightsFromRecording(heights);
+        else
+            updateHeightsFromWave(heights, snapshot.previous, snapshot.current, alpha);
+        heightGrid.setHeights(heights);
+        if (drawSurface) {
+            surfaceShader.use();
+            surfaceShader.setMat4("projection", projection);
+            surfaceShader.setMat4("view", view);
+            surfaceShader.setVec3("lightPos", 10.0f, 30.0f, 10.0f);
+            surfaceShader.setVec3("viewPos", camera.Position);
+            surfaceShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+            surfaceShader.setVec3("objectColor", 0.2f, 0.5f, 1.0f);
+            heightGrid.DrawSurface(surfaceShader);
+        } else {
+            heightGrid.DrawPoints();
+        }
 
 //        glPointSize(5.0f);
 
@@ -346,9 +460,12 @@ int main()
     }
 
     // cleanup
-    glDeleteVertexArrays(1, &particleVAO);
-    glDeleteBuffers(1, &particleVBO);
+    heightGrid.Delete();
 
+    if (!playing)
+        sim.stop();
+    recording.close();
+    rawRecording.close();
     glfwTerminate();
     return 0;
 }
@@ -358,6 +475,28 @@ void processInput(GLFWwindow *window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    static bool mWasDown = false;
+    bool mDown = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+    if (mDown && !mWasDown)
+        drawSurface = !drawSurface;
+    mWasDown = mDown;
+
+    if (playing)
+    {
+        // scrubbing covers 10 seconds of sim time per second held
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+            playTime -= 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+            playTime += 10.0 * deltaTime;
+        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+            playTime = 0.0;
+        static bool spaceWasDown = false;
+        bool spaceDown = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+        if (spaceDown && !spaceWasDown)
+            playPaused = !playPaused;
+        spaceWasDown = spaceDown;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -0,0 +1,219 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "camera.h"
+#include "wave_grid.h"
+#include "gpu_wave.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+// The wave demo with the grid on the GPU (see gpu_wave.h): the CPU sets up the starting levels once and after that
+// only decides how many steps to run each frame. The points are drawn straight from the height textures.
+//
+//   ./main_gpu [gridSize] [stepsPerSecond]     defaults 150 and 60, 4096 works
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+
+// settings
+const unsigned int SCR_WIDTH = 1600;
+const unsigned int SCR_HEIGHT = 1200;
+
+// camera
+Camera camera(glm::vec3(6.0f, 6.0f, 29.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::max(3, std::atoi(argv[1])) : 150;
+    double stepsPerSecond = argc > 2 ? std::atof(argv[2]) : 60.0;
+
+    // glfw: initialize and configure
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Wave Equation (GPU)", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_PROGRAM_POINT_SIZE);  // Allow setting point size in shader
+
+    // build and compile shaders
+    Shader particleShader("wave_particle.vs", "particle.fs");
+    Shader stepShader("wave_step.vs", "wave_step.fs");
+
+    // the same domain and starting Gaussian as main.cpp, at any resolution
+    const float L = 20.0f;
+    const float sigma = 1.0f;
+    const float amplitude = 10.0f;
+    const float r = 0.3f;
+    const float dx = L / (n - 1.0f);
+
+    Grid2D<float> u_past(n, n), u_current(n, n);
+    for (int i = 1; i < n - 1; ++i) {
+        for (int k = 1; k < n - 1; ++k) {
+            float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+            u_past[i][k] = amplitude * std::exp(-(x * x + y * y) / (2.0f * sigma * sigma));
+        }
+    }
+    waveStartStep(u_past, u_current, r * r);
+    GpuWave wave(u_past, u_current, r * r);
+    std::cout << "Stepping " << n << "x" << n << " on the GPU at " << stepsPerSecond << " steps/s" << std::endl;
+
+    // points come from gl_VertexID, nothing to put in the VAO
+    unsigned int pointsVAO;
+    glGenVertexArrays(1, &pointsVAO);
+
+    double stepClock = 0.0; // steps owed, fractional part is how far into the next one we are
+    float fpsTimer = 0.0f;
+    int fpsFrames = 0;
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        fpsTimer += deltaTime;
+        fpsFrames++;
+        if (fpsTimer >= 5.0f) {
+            std::cout << fpsFrames / fpsTimer << " fps, " << wave.steps() << " steps" << std::endl;
+            fpsTimer = 0.0f;
+            fpsFrames = 0;
+        }
+
+        // input
+        processInput(window);
+
+        // whole steps due since last frame, capped at a tenth of a second's worth so a stall is skipped rather than
+        // caught up in one long frame
+        stepClock += deltaTime * stepsPerSecond;
+        int steps = (int)stepClock;
+        stepClock -= steps;
+        wave.step(stepShader, std::min(steps, std::max(8, (int)(stepsPerSecond / 10.0))));
+
+        // render
+        glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
+                                                (float)SCR_WIDTH / (float)SCR_HEIGHT,
+                                                0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        particleShader.use();
+        particleShader.setMat4("projection", projection);
+        particleShader.setMat4("view", view);
+        particleShader.setInt("heights", 0);
+        particleShader.setInt("previousHeights", 1);
+        particleShader.setFloat("alpha", (float)stepClock);
+        particleShader.setVec2("spacing", dx, dx);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, wave.heights());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, wave.previousHeights());
+        glActiveTexture(GL_TEXTURE0);
+
+        glBindVertexArray(pointsVAO);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)n * n);
+
+        // glfw: swap buffers and poll IO events
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    // cleanup
+    glDeleteVertexArrays(1, &pointsVAO);
+    wave.Delete();
+
+    glfwTerminate();
+    return 0;
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos;
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
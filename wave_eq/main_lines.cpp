@@ -7,6 +7,12 @@
 
 #include "shader_m.h"
 #include "camera.h"
+#define FRAME_ARENA_COUNT_HEAP
+#include "frame_arena.h"
+#include "sim_runner.h"
+#include "wave_grid.h"
+#include "wave_solver.h"
+#include "height_grid.h"
 
 #include <iostream>
 #include <vector>
@@ -82,60 +88,28 @@ void generatePlotParticles(std::vector<float>& positions,
     }
 }
 
-void updateParticlesFromWave(std::vector<float>& positions,
-                             const std::vector<std::vector<float>>& wave_slice,
-                             const std::vector<float>& x,
-                             const std::vector<float>& y) {
-    positions.clear();
-
-    for (int i=0;i<x.size();++i) {
-        for (int k=0;k<y.size();++k){
-            positions.push_back(x[i]);
-            positions.push_back(wave_slice[i][k]);
-            positions.push_back(y[k]);
-        }
-    }
-
-}
-
-void updateLinesFromWave(std::vector<float>& linePositions,
-                        const std::vector<std::vector<float>>& wave_slice,
-                        const std::vector<float>& x,
-                        const std::vector<float>& y) {
-    linePositions.clear();
-    
-    int nx = x.size();
-    int ny = y.size();
-    
-    // Horizontal lines (connect each point to its right neighbor)
-    for (int i = 0; i < nx-1; ++i) {
-        for (int k = 0; k < ny; ++k) {
-            // Start vertex
-            linePositions.push_back(x[i]);
-            linePositions.push_back(wave_slice[i][k]);
-            linePositions.push_back(y[k]);
-            
-            // End vertex (right neighbor)
-            linePositions.push_back(x[i+1]);
-            linePositions.push_back(wave_slice[i+1][k]);
-            linePositions.push_back(y[k]);
-        }
-    }
-    
-    // Vertical lines (connect each point to its bottom neighbor)
-    for (int i = 0; i < nx; ++i) {
-        for (int k = 0; k < ny-1; ++k) {
-            // Start vertex
-            linePositions.push_back(x[i]);
-            linePositions.push_back(wave_slice[i][k]);
-            linePositions.push_back(y[k]);
-            
-            // End vertex (bottom neighbor)
-            linePositions.push_back(x[i]);
-            linePositions.push_back(wave_slice[i][k+1]);
-            linePositions.push_back(y[k+1]);
-        }
+typedef Grid2D<float> WaveGrid; // contiguous and padded, [i][k] indexes it like the old vector<vector>
+
+// what the sim thread owns: the last two time levels of the scheme
+struct WaveModel {
+    WaveGrid past;
+    WaveGrid current;
+};
+
+// writes the height of every grid point into heights (rows * cols floats, HeightGrid's vertex order), returns the
+// count. the height is blended from 'from' to 'to' by alpha
+size_t updateHeightsFromWave(float* heights,
+                             const WaveGrid& from,
+                             const WaveGrid& to,
+                             float alpha) {
+    size_t n = 0;
+    for (int i=0;i<to.rows();++i) {
+        const float* fromRow = from[i];
+        const float* toRow = to[i];
+        for (int k=0;k<to.cols();++k)
+            heights[n++] = fromRow[k] + alpha * (toRow[k] - fromRow[k]);
     }
+    return n;
 }
 
 int main()
@@ -180,7 +154,7 @@ int main()
     glEnable(GL_PROGRAM_POINT_SIZE);  // Allow setting point size in shader
 
     // build and compile shaders
-    Shader particleShader("particle.vs", "particle.fs");
+    Shader particleShader("height_grid.vs", "particle.fs");
 
 
 
@@ -192,8 +166,8 @@ int main()
     float t_final = 10.0f;
 
     /// nx,ny stuff:
-    float nx = 150;
-    float ny = 150;
+    int nx = 150;
+    int ny = 150;
     float dx = L / (nx - 1.0f);
     float dy = L / (ny - 1.0f);
 
@@ -209,7 +183,6 @@ int main()
     /// pause for VAOs stuff
 
     // Generate the particle positions for our function
-    std::vector<float> particlePositions;
     
     // Domain: x from -10 to 10, y from -10 to 10
     // Samples: 100x100 = 10,000 particles
@@ -235,9 +208,8 @@ int main()
     }
 
 
-    std::vector<std::vector<float>> u_past(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
-    std::vector<std::vector<float>> u_current(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
-    std::vector<std::vector<float>> u_next(static_cast<int>(nx), std::vector<float>(static_cast<int>(ny), 0.0f));
+    WaveGrid u_past(static_cast<int>(nx), static_cast<int>(ny));
+    WaveGrid u_current(static_cast<int>(nx), static_cast<int>(ny));
 
 
 
@@ -280,51 +252,29 @@ int main()
 
 
 
-    int stepsPerFrame = 1;
-    int frameSkip = 1;  // Only update physics every 5th frame
+    // the time stepping runs on its own thread at a fixed rate, WAVE_STEPS_PER_TICK steps at a time through the tiled
+    // solver; raise it (10-100 is fine on a 2048^2 grid) for a faster wave on a bigger grid
+    const double WAVE_STEPS_PER_SECOND = 60.0;
+    const int WAVE_STEPS_PER_TICK = 1;
+    ThreadPool wavePool;
+    WaveSolver waveSolver(rx*rx, &wavePool);
+    SimRunner<WaveModel, WaveGrid> sim(WaveModel{ u_past, u_current }, 1.0 / WAVE_STEPS_PER_SECOND,
+                             [&](WaveModel& model) {
+        // (j = time, i = x, k = y), rx == ry so the stencil takes a single r^2; the boundary stays at zero
+        waveSolver.advance(model.past, model.current, WAVE_STEPS_PER_TICK);
+    }, [](const WaveModel& model, WaveGrid& shown) {
+        shown = model.current; // the renderer only draws the newest level
+    });
+    sim.start();
     int frameCounter = 0;
 
 /// END OF SETUP
 
 
-    updateParticlesFromWave(particlePositions, u_current, x, y);
-    std::cout << "Generated " << particlePositions.size() / 3 << " particles" << std::endl;
-
-    // Setup particle VAO and VBO
-    unsigned int particleVBO, particleVAO;
-    glGenVertexArrays(1, &particleVAO);
-    glGenBuffers(1, &particleVBO);
-
-    glBindVertexArray(particleVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, particlePositions.size() * sizeof(float), 
-             particlePositions.data(), GL_DYNAMIC_DRAW);  // use .data(), not nullptr
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-
-
-    std::vector<float> linePositions;
-
-    unsigned int lineVBO, lineVAO;
-    glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
-
-    glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-
-    // Initialize the line positions from initial wave state
-    updateLinesFromWave(linePositions, u_current, x, y);
-
-    glBufferData(GL_ARRAY_BUFFER, linePositions.size() * sizeof(float), 
-                linePositions.data(), GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    std::cout << "Generated " << linePositions.size() / 6 << " line segments" << std::endl;
-
+    // x and z go up once, after that a frame only sends one height per point and the lines reuse them
+    HeightGrid heightGrid(x, y);
+    FrameArena frameArena(heightGrid.vertexCount() * sizeof(float) + 4096);
+    std::cout << "Generated " << heightGrid.vertexCount() << " particles" << std::endl;
 
     /// end VAO set up
     // render loop
@@ -336,6 +286,13 @@ int main()
         lastFrame = currentFrame;
         frameCounter++;
 
+        // vertex data is rebuilt in the frame arena every frame, the heap count should stay at 0
+        frameArena.beginFrame();
+        if (frameCounter % 600 == 0) {
+            std::cout << "heap allocations last frame: " << frameArena.heapAllocationsLastFrame() << std::endl;
+            sim.report();
+        }
+
         // input
         processInput(window);
 
@@ -354,31 +311,10 @@ int main()
 
     // MAIN LOOP
 
-    // (j = time, i = x, k = y):
-    if (frameCounter % frameSkip == 0) {
-   
-        for (int step =0; step < stepsPerFrame; step++) {
-                for (int i=1; i < nx-1; ++i) {
-                        for (int k=1; k<ny-1; ++k) {
-                            u_next[i][k] = 2*u_current[i][k] - u_past[i][k] + (rx*rx)*(u_current[i+1][k] - 2*u_current[i][k] + u_current[i-1][k]) + (ry*ry)*(u_current[i][k+1] - 2*u_current[i][k] + u_current[i][k-1]);
-                        }
-                }
-
-                for (int i=0; i<nx; ++i){
-                    u_next[i][0] = 0.0f;
-                    u_next[i][ny-1] = 0.0f;
-                }
-                for (int k=0; k<ny; ++k){
-                    u_next[0][k] = 0.0f;
-                    u_next[nx-1][k] = 0.0f;
-                }
-
-                u_past = u_current;
-                u_current = u_next;
-
-        }
-
-    }
+        // the wave one sim step behind, blended between the last two levels the sim thread published
+        const SimSnapshot<WaveGrid>& snapshot = sim.latest();
+        float alpha = (float)sim.alpha();
+        sim.recordFrame(deltaTime);
 
 
 
@@ -392,32 +328,20 @@ int main()
         particleShader.setMat4("view", view);
 
         // DATA
-        updateParticlesFromWave(particlePositions, u_current, x, y);
+        float* heights = frameArena.allocate<float>(heightGrid.vertexCount());
+        updateHeightsFromWave(heights, snapshot.previous, snapshot.current, alpha);
+        heightGrid.setHeights(heights);
 
         particleShader.setVec4("color", 0.0f, 1.0f, 0.0f, 1.0f);  // green for particles
+        heightGrid.DrawPoints();
 
-        glBindVertexArray(particleVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, particlePositions.size() * sizeof(float), 
-                particlePositions.data());
-        glDrawArrays(GL_POINTS, 0, particlePositions.size() / 3);
-
-        // LINES:
-
-        updateLinesFromWave(linePositions, u_current, x, y);
+        // LINES: same vertices, joined by the static index buffer
 
         particleShader.setVec4("color", 1.0f, 1.0f, 1.0f, 0.2f);  // white for lines
 
         glLineWidth(0.00001f);
 
-        glBindVertexArray(lineVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, linePositions.size() * sizeof(float),
-                        linePositions.data());
-        glDrawArrays(GL_LINES, 0, linePositions.size() / 3);
-
-
-
+        heightGrid.DrawLines();
 
 //        glPointSize(5.0f);
 
@@ -428,9 +352,9 @@ int main()
     }
 
     // cleanup
-    glDeleteVertexArrays(1, &particleVAO);
-    glDeleteBuffers(1, &particleVBO);
+    heightGrid.Delete();
 
+    sim.stop();
     glfwTerminate();
     return 0;
 }
@@ -0,0 +1,95 @@
+// The wave grid stored in float, Half and BFloat16 (half_float.h), stepped through the same BasicWaveSolver from the
+// demo's Gaussian: how fast each goes, how much memory its levels take, and how far the 16 bit runs drift from the
+// float one as the steps add up. The drift is measured at eight checkpoints as the largest difference in any cell and
+// the RMS difference over the grid, both relative to the pulse's amplitude of 10.
+//
+//   g++ -O2 -mavx2 -mfma -mf16c -std=c++17 -pthread precision_bench.cpp -o precision_bench
+//   ./precision_bench [n] [steps]        (default 2048 and 4000)
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+static const float R2 = 0.3f * 0.3f;
+
+struct Run {
+    std::vector<std::vector<float>> checkpoints;
+    double stepsPerSecond;
+    double megabytes; // the two levels the caller keeps
+};
+
+template<class T>
+static Run run(int n, int steps, ThreadPool& pool)
+{
+    const float L = 20.0f, dx = L / (n - 1.0f);
+    Grid2D<T> past(n, n), current(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+        {
+            float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+            past[i][k] = fromFloat<T>(10.0f * std::exp(-(x * x + y * y) / 2.0f));
+        }
+    waveStartStep(past, current, R2);
+
+    BasicWaveSolver<T> solver(R2, &pool);
+    Run result;
+    result.megabytes = 2.0 * past.rows() * past.stride() * sizeof(T) / 1e6;
+    double seconds = 0.0;
+    const int interval = std::max(1, steps / 8);
+    for (int done = 0; done < steps; done += interval)
+    {
+        auto start = std::chrono::steady_clock::now();
+        solver.advance(past, current, std::min(interval, steps - done));
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::vector<float> heights((size_t)n * n);
+        current.copyTo(heights.data());
+        result.checkpoints.push_back(heights);
+    }
+    result.stepsPerSecond = steps / seconds;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::max(16, std::atoi(argv[1])) : 2048;
+    int steps = argc > 2 ? std::max(8, std::atoi(argv[2])) : 4000;
+    ThreadPool pool;
+
+    Run single = run<float>(n, steps, pool);
+    Run half = run<Half>(n, steps, pool);
+    Run brain = run<BFloat16>(n, steps, pool);
+
+    std::cout << n << "x" << n << ", " << steps << " steps, " << pool.size() << " threads\n"
+              << "  float     " << single.stepsPerSecond << " steps/s  " << single.megabytes << " MB\n"
+              << "  Half      " << half.stepsPerSecond << " steps/s  " << half.megabytes << " MB  "
+              << half.stepsPerSecond / single.stepsPerSecond << "x\n"
+              << "  BFloat16  " << brain.stepsPerSecond << " steps/s  " << brain.megabytes << " MB  "
+              << brain.stepsPerSecond / single.stepsPerSecond << "x\n"
+              << "  error against float, relative to the amplitude (max cell, rms):\n"
+              << "    step     Half                      BFloat16\n";
+    const int interval = std::max(1, steps / 8);
+    for (size_t p = 0; p < single.checkpoints.size(); ++p)
+    {
+        std::cout << "    " << std::min(steps, (int)(p + 1) * interval);
+        for (const Run* r : { &half, &brain })
+        {
+            double worst = 0.0, squares = 0.0;
+            for (size_t j = 0; j < single.checkpoints[p].size(); ++j)
+            {
+                double d = std::abs(r->checkpoints[p][j] - single.checkpoints[p][j]);
+                worst = std::max(worst, d);
+                squares += d * d;
+            }
+            double rms = std::sqrt(squares / single.checkpoints[p].size());
+            std::cout << "\t" << worst / 10.0 << "  " << rms / 10.0;
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
@@ -0,0 +1,123 @@
+// What wave_record.h costs and saves on the demo's run: the frames of an n x n run are recorded losslessly and at a
+// few error bounds (fractions of the starting Gaussian's height of 10), then read back, in order and by jumping to
+// random frames. For each it gives the size as bits a cell a frame against the 32 of a raw float, the write and
+// read rates, what a random seek costs, and the largest difference from what was recorded; that has to be 0 for the
+// lossless one and within the bound (give or take float rounding) for the rest, or the run fails.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 record_bench.cpp -o record_bench
+//   ./record_bench [n] [frames] [steps a frame] [chunk frames]        (default 512, 200, 4, 64)
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+#include "wave_record.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// FNV-1a over a frame's bytes, to tell a frame decoded twice came out the same
+static uint64_t frameHash(const std::vector<float> &frame)
+{
+    uint64_t hash = 1469598103934665603ull;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(frame.data());
+    for (size_t j = 0; j < frame.size() * sizeof(float); j++)
+        hash = (hash ^ bytes[j]) * 1099511628211ull;
+    return hash;
+}
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::max(16, std::atoi(argv[1])) : 512;
+    int frames = argc > 2 ? std::max(2, std::atoi(argv[2])) : 200;
+    int frameSteps = argc > 3 ? std::max(1, std::atoi(argv[3])) : 4;
+    int chunkFrames = argc > 4 ? std::max(1, std::atoi(argv[4])) : 64;
+    const size_t cells = (size_t)n * n;
+    const char *path = "record_bench.wrec";
+
+    const float L = 20.0f, dx = L / (n - 1.0f), r = 0.3f;
+    Grid2D<float> past(n, n), current(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+        {
+            float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+            past[i][k] = 10.0f * std::exp(-(x * x + y * y) / 2.0f);
+        }
+    waveStartStep(past, current, r * r);
+    std::vector<float> recorded(cells * frames);
+    past.copyTo(&recorded[0]);
+    WaveSolver solver(r * r);
+    for (int f = 1; f < frames; f++)
+    {
+        solver.advance(past, current, f == 1 ? frameSteps - 1 : frameSteps);
+        current.copyTo(&recorded[cells * f]);
+    }
+
+    std::cout << n << "x" << n << ", " << frames << " frames " << frameSteps << " steps apart, " << chunkFrames
+              << " to a chunk\n"
+              << "  bound     bits/cell  ratio    write MB/s  read frames/s  seek ms   max error\n";
+    bool allGood = true;
+    std::vector<float> frame(cells);
+    for (double bound : { 0.0, 1e-5, 1e-4, 1e-3, 1e-2 })
+    {
+        WaveRecordWriter writer;
+        if (!writer.open(path, "wave", n, n, r * dx * frameSteps, bound, { L, (double)n, (double)n }, chunkFrames))
+            return 1;
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+            if (!writer.write(&recorded[cells * f]))
+                return 1;
+        writer.close();
+        double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        WaveRecordReader reader;
+        if (!reader.open(path) || reader.frameCount() != (uint64_t)frames)
+        {
+            std::cout << "ERROR::RECORD_BENCH::READ_BACK_FAILED" << std::endl;
+            return 1;
+        }
+        double maxError = 0.0;
+        std::vector<uint64_t> hashes(frames);
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+        {
+            if (!reader.decode(f, frame.data()))
+                return 1;
+            for (size_t j = 0; j < cells; j++)
+                maxError = std::max(maxError, std::abs((double)frame[j] - recorded[cells * f + j]));
+            hashes[f] = frameHash(frame);
+        }
+        double readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // random frames have to come back as they did in order
+        std::mt19937 random(1);
+        const int seeks = 20;
+        bool sameAsInOrder = true;
+        double seekSeconds = 0.0;
+        for (int s = 0; s < seeks; s++)
+        {
+            int f = (int)(random() % frames);
+            start = std::chrono::steady_clock::now();
+            if (!reader.decode(f, frame.data()))
+                return 1;
+            seekSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / seeks;
+            sameAsInOrder = sameAsInOrder && frameHash(frame) == hashes[f];
+        }
+
+        double bits = 8.0 * reader.fileBytes() / ((double)cells * frames);
+        // the bound plus half a float step at the largest height
+        bool good = sameAsInOrder && (bound == 0.0 ? maxError == 0.0 : maxError <= bound + 10.0 * 6e-8);
+        allGood = allGood && good;
+        std::cout << "  " << bound << "\t    " << bits << "\t" << 32.0 / bits << "\t "
+                  << cells * 4.0 * frames / writeSeconds / 1e6 << "\t     " << frames / readSeconds << "\t    "
+                  << seekSeconds * 1e3 << "\t" << maxError
+                  << (good ? "" : "  OUT OF BOUND") << "\n";
+    }
+    std::remove(path);
+    std::cout << std::flush;
+    return allGood ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// Error against wall time for the periodic schemes in wave_schemes.h. The domain is a periodic square of side 2 pi with
+// c = 1 and three standing waves in it,
+//   u = cos(3x + 4y) cos(5t) + 0.5 cos(8x - 6y) cos(10t) + 0.25 cos(12x + 5y) cos(13t),
+// which is the exact solution, so there's no reference run to trust. Every scheme goes to t = 2 on n x n grids at
+// r = 0.3 (what the demo uses) and at 0.9 of its stability limit; the spectral one, having no limit, at r = 0.5 and
+// r = 4. Both starting levels are exact. The error is the largest difference from the exact u at t = 2 as a fraction
+// of the 1.75 the amplitudes add up to. Then for a few error targets, the fastest run of each scheme that met it.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 scheme_bench.cpp -o scheme_bench
+//   ./scheme_bench [n ...]        (default 32 64 128 256, spectral only at powers of two)
+
+#include "wave_schemes.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+struct Mode { int kx, ky; double amplitude; };
+static const Mode MODES[] = { { 3, 4, 1.0 }, { 8, -6, 0.5 }, { 12, 5, 0.25 } };
+static const double TOTAL_AMPLITUDE = 1.75;
+static const double END_TIME = 2.0;
+
+static void exact(Grid2D<float> &u, int n, double t)
+{
+    const double dx = 2.0 * 3.14159265358979323846 / n;
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++)
+        {
+            double value = 0.0;
+            for (const Mode &m : MODES)
+                value += m.amplitude * std::cos(m.kx * i * dx + m.ky * k * dx) *
+                         std::cos(std::sqrt((double)(m.kx * m.kx + m.ky * m.ky)) * t);
+            u[i][k] = (float)value;
+        }
+}
+
+struct Result { WaveScheme scheme; int n; double r; int steps; double seconds; double error; };
+
+static Result run(WaveScheme scheme, int n, double courant)
+{
+    const double dx = 2.0 * 3.14159265358979323846 / n;
+    // a whole number of steps to the end, so r comes out a little under what was asked for
+    int steps = (int)std::ceil(END_TIME / (courant * dx));
+    double dt = END_TIME / steps;
+    Result result{ scheme, n, dt / dx, steps, 0.0, 0.0 };
+
+    Grid2D<float> past(n, n), current(n, n), expected(n, n);
+    exact(past, n, 0.0);
+    exact(current, n, dt);
+    PeriodicWaveStepper stepper(scheme, n, n, (float)result.r);
+    auto start = std::chrono::steady_clock::now();
+    stepper.advance(past, current, steps - 1);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    exact(expected, n, END_TIME);
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++)
+        {
+            double d = std::abs((double)current[i][k] - expected[i][k]);
+            result.error = std::isfinite(d) ? std::max(result.error, d) : INFINITY;
+        }
+    result.error /= TOTAL_AMPLITUDE;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    for (int a = 1; a < argc; a++)
+        sizes.push_back(std::max(8, std::atoi(argv[a])));
+    if (sizes.empty())
+        sizes = { 32, 64, 128, 256 };
+
+    std::vector<Result> results;
+    std::cout << "  scheme    n     r       steps   seconds     error\n";
+    for (WaveScheme scheme : { WaveScheme::Order2, WaveScheme::Order4, WaveScheme::Order6, WaveScheme::Spectral })
+        for (int n : sizes)
+        {
+            if (scheme == WaveScheme::Spectral && !Fft::isPowerOfTwo(n))
+                continue;
+            std::vector<double> courants = scheme == WaveScheme::Spectral
+                                               ? std::vector<double>{ 0.5, 4.0 }
+                                               : std::vector<double>{ 0.3, 0.9 * stableCourant(scheme) };
+            for (double courant : courants)
+            {
+                Result r = run(scheme, n, courant);
+                results.push_back(r);
+                std::cout << "  " << waveSchemeName(scheme) << "\t" << n << "\t" << r.r << "\t" << r.steps << "\t"
+                          << r.seconds << "\t" << r.error << "\n";
+            }
+        }
+
+    std::cout << "  fastest to reach an error of\n"
+              << "    target    order2       order4       order6       spectral   (seconds, n)\n";
+    for (double target : { 1e-1, 1e-2, 1e-3, 1e-4 })
+    {
+        std::cout << "    " << target;
+        for (WaveScheme scheme : { WaveScheme::Order2, WaveScheme::Order4, WaveScheme::Order6, WaveScheme::Spectral })
+        {
+            const Result *best = nullptr;
+            for (const Result &r : results)
+                if (r.scheme == scheme && r.error <= target && (!best || r.seconds < best->seconds))
+                    best = &r;
+            if (best)
+                std::cout << "\t" << best->seconds << " " << best->n;
+            else
+                std::cout << "\t-";
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
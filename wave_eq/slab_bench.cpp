@@ -0,0 +1,117 @@
+// Scaling of SlabWaveSolver over 1, 2, 4... processes on one machine, each a single thread pinned to a NUMA node
+// (round robin), swapping halos through SharedMemoryTransport. Every run starts from the demo's Gaussian and its
+// gathered grid has to match single threaded WaveSolver exactly; the run fails if one doesn't. Speedup and efficiency
+// are against the one process run, and the WaveSolver time is there to show what splitting into slabs costs.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 -pthread slab_bench.cpp -o slab_bench -lrt
+//   ./slab_bench [n] [steps] [processes ...]        (default 4096, 200, then 1 2 4... up to the CPU count)
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+#include "halo_transport.h"
+#include "slab_solver.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const float R2 = 0.3f * 0.3f;
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::max(16, std::atoi(argv[1])) : 4096;
+    int steps = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    std::vector<int> counts;
+    for (int a = 3; a < argc; a++)
+        counts.push_back(std::max(1, std::atoi(argv[a])));
+    if (counts.empty())
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int p = 1; p <= std::max(1L, cpus); p *= 2)
+            counts.push_back(p);
+    }
+    if (counts[0] != 1)
+        counts.insert(counts.begin(), 1); // what the speedups are against
+
+    const float L = 20.0f, dx = L / (n - 1.0f);
+    Grid2D<float> startPast(n, n), startCurrent(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+        {
+            float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+            startPast[i][k] = 10.0f * std::exp(-(x * x + y * y) / 2.0f);
+        }
+    waveStartStep(startPast, startCurrent, R2);
+
+    Grid2D<float> past = startPast, current = startCurrent;
+    WaveSolver reference(R2);
+    auto start = std::chrono::steady_clock::now();
+    reference.advance(past, current, steps);
+    double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::vector<float> expected((size_t)n * n);
+    current.copyTo(expected.data());
+
+    std::cout << n << "x" << n << ", " << steps << " steps, " << SharedMemoryTransport::numaNodeCpus().size()
+              << " NUMA node(s), " << sysconf(_SC_NPROCESSORS_ONLN) << " CPUs\n"
+              << "  WaveSolver, 1 thread   " << steps / referenceSeconds << " steps/s\n"
+              << "  processes  steps/s    speedup  efficiency  halo rows  exact\n";
+
+    // rank 0 leaves its time and the gathered heights here for the parent
+    struct Shared { double seconds; int halo; };
+    size_t sharedBytes = sizeof(Shared) + (size_t)n * n * sizeof(float);
+    void *mapped = mmap(nullptr, sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+    {
+        std::cout << "ERROR::SLAB_BENCH::MMAP_FAILED" << std::endl;
+        return 1;
+    }
+    Shared *shared = static_cast<Shared*>(mapped);
+    float *heights = reinterpret_cast<float*>(shared + 1);
+
+    bool allExact = true;
+    double oneProcess = 0.0;
+    for (int processes : counts)
+    {
+        SharedMemoryTransport transport(processes);
+        bool ok = transport.runProcesses([&](HaloTransport &t) {
+            SlabWaveSolver<float> slab(t, n, n, R2);
+            if (!slab.valid())
+                return 1;
+            slab.load(startPast, startCurrent);
+            t.barrier();
+            auto begin = std::chrono::steady_clock::now();
+            slab.advance(steps);
+            t.barrier();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            Grid2D<float> wholePast, wholeCurrent;
+            slab.gather(wholePast, wholeCurrent);
+            if (t.rank() == 0)
+            {
+                shared->seconds = seconds;
+                shared->halo = slab.halo();
+                wholeCurrent.copyTo(heights);
+            }
+            return 0;
+        });
+        if (!ok)
+        {
+            std::cout << "ERROR::SLAB_BENCH::RANK_FAILED: " << processes << " processes" << std::endl;
+            return 1;
+        }
+        bool exact = std::memcmp(heights, expected.data(), expected.size() * sizeof(float)) == 0;
+        allExact = allExact && exact;
+        if (processes == 1)
+            oneProcess = shared->seconds;
+        double speedup = oneProcess / shared->seconds;
+        std::cout << "  " << processes << "\t     " << steps / shared->seconds << "\t" << speedup << "\t "
+                  << speedup / processes << "\t     " << shared->halo << "\t\t" << (exact ? "yes" : "NO") << "\n";
+    }
+    std::cout << std::flush;
+    munmap(mapped, sharedBytes);
+    return allExact ? 0 : 1;
+}
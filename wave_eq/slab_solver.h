@@ -0,0 +1,223 @@
+#ifndef SLAB_SOLVER_H
+#define SLAB_SOLVER_H
+
+#include "wave_grid.h"
+#include "thread_pool.h"
+#include "halo_transport.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+// The wave grid split into horizontal slabs, one per rank of a HaloTransport (a process each with
+// SharedMemoryTransport), so no process holds more than its share of the rows. Each rank keeps its rows plus a halo
+// of timeBlock rows (one more with absorbing edges) from each neighbour, and before every block of timeBlock steps it
+// swaps that many rows of both levels with them. The halo then covers everything its own rows depend on for the whole
+// block, the same temporal blocking WaveSolver does with its tiles, so neighbours meet once a block rather than once a
+// step. The rows stepped shrink by one a step from each open side, and every cell goes through waveStep, so the
+// gathered grid is bit for bit what stepping the whole grid gives.
+//
+// Exchanges go in two rounds: even ranks with the one below and then odd ranks with the one below, every pair
+// independent of the others, and the lower rank of a pair sends first. A rank's halo comes from its neighbour's own
+// rows, so timeBlock is cut down if a slab has fewer rows than the halo.
+//
+// A pool splits each step's rows over threads inside the rank; make it in the rank's process, threads don't survive
+// the fork.
+//
+// Every slab needs at least two rows. With more ranks than that allows, valid() is false on every rank and the solver
+// refuses the split: it holds no grids and load, advance and gather do nothing, so check valid() before using it.
+template<class T>
+class SlabWaveSolver
+{
+public:
+    SlabWaveSolver(HaloTransport &transport, int rows, int cols, float r2, int timeBlock = 8, ThreadPool *pool = nullptr)
+        : transport(transport), totalRows(rows), cols(cols), r2(r2), pool(pool)
+    {
+        const int ranks = transport.size(), me = transport.rank();
+        r0 = (int)((long long)rows * me / ranks);
+        r1 = (int)((long long)rows * (me + 1) / ranks);
+        thinnest = rows;
+        for (int q = 0; q < ranks; q++)
+            thinnest = std::min(thinnest, (int)((long long)rows * (q + 1) / ranks - (long long)rows * q / ranks));
+        requestedBlock = std::max(1, timeBlock);
+        if (!valid())
+        {
+            if (me == 0)
+                std::cout << "ERROR::SLAB_SOLVER::TOO_MANY_RANKS: " << ranks << " for " << rows << " rows" << std::endl;
+            return;
+        }
+        reshape();
+    }
+
+    // false if the rows can't be split over this many ranks, the same on every rank
+    bool valid() const { return thinnest >= 2; }
+
+    void setAbsorbingEdges(float r)
+    {
+        absorbing = true;
+        courant = r;
+        reshape();
+    }
+
+    void setFixedEdges()
+    {
+        absorbing = false;
+        reshape();
+    }
+
+    // this rank's rows of the whole grid, [firstRow, endRow)
+    int firstRow() const { return r0; }
+    int endRow() const { return r1; }
+
+    // global row i of the two levels, for i in [firstRow - halo, endRow + halo) clipped to the grid
+    T* pastRow(int i) { return past[i - lr0]; }
+    T* currentRow(int i) { return current[i - lr0]; }
+
+    // this rank's rows (and halo) from the whole grids; every rank can read its own share of them instead
+    void load(const Grid2D<T> &wholePast, const Grid2D<T> &wholeCurrent)
+    {
+        if (!valid())
+            return;
+        for (int i = lr0; i < lr1; i++)
+        {
+            std::memcpy(pastRow(i), wholePast[i], cols * sizeof(T));
+            std::memcpy(currentRow(i), wholeCurrent[i], cols * sizeof(T));
+        }
+    }
+
+    // every rank calls this together
+    void advance(int steps)
+    {
+        while (valid() && steps > 0)
+        {
+            int block = std::min(steps, maxBlock);
+            exchangeHalos();
+            stepBlock(block);
+            steps -= block;
+        }
+    }
+
+    // every rank calls this together; rank 0 ends up with the whole grid in wholePast and wholeCurrent
+    void gather(Grid2D<T> &wholePast, Grid2D<T> &wholeCurrent)
+    {
+        if (!valid())
+            return;
+        const int ranks = transport.size();
+        const size_t stride = past.stride();
+        if (transport.rank() != 0)
+        {
+            transport.send(0, pastRow(r0), (size_t)(r1 - r0) * stride * sizeof(T));
+            transport.send(0, currentRow(r0), (size_t)(r1 - r0) * stride * sizeof(T));
+            return;
+        }
+        wholePast.reshape(totalRows, cols);
+        wholeCurrent.reshape(totalRows, cols);
+        for (int q = 0; q < ranks; q++)
+        {
+            int q0 = (int)((long long)totalRows * q / ranks), q1 = (int)((long long)totalRows * (q + 1) / ranks);
+            if (q == 0)
+                for (int i = q0; i < q1; i++)
+                {
+                    std::memcpy(wholePast[i], pastRow(i), cols * sizeof(T));
+                    std::memcpy(wholeCurrent[i], currentRow(i), cols * sizeof(T));
+                }
+            else
+            {
+                // same cols so the same stride: the rows arrive as one run of memory
+                transport.receive(q, wholePast[q0], (size_t)(q1 - q0) * stride * sizeof(T));
+                transport.receive(q, wholeCurrent[q0], (size_t)(q1 - q0) * stride * sizeof(T));
+            }
+        }
+    }
+
+    int timeBlock() const { return maxBlock; }
+    int halo() const { return haloRows; }
+
+private:
+    HaloTransport &transport;
+    int totalRows, cols;
+    float r2;
+    ThreadPool *pool;
+    int requestedBlock, maxBlock = 1;
+    int thinnest; // rows in the smallest slab of any rank
+    bool absorbing = false;
+    float courant = 0.0f;
+
+    int r0 = 0, r1 = 0;   // own rows
+    int lr0 = 0, lr1 = 0; // own rows and halo
+    int haloRows = 0;
+    Grid2D<T> past, current, next;
+
+    // an absorbing edge reads the cell next to it at the same time level, one row more
+    void reshape()
+    {
+        if (!valid())
+            return;
+        maxBlock = std::max(1, std::min(requestedBlock, thinnest - (absorbing ? 1 : 0)));
+        haloRows = maxBlock + (absorbing ? 1 : 0);
+        int newLr0 = std::max(0, r0 - haloRows), newLr1 = std::min(totalRows, r1 + haloRows);
+        if (newLr0 == lr0 && newLr1 == lr1 && past.rows() == lr1 - lr0)
+            return;
+        Grid2D<T> oldPast, oldCurrent;
+        oldPast.swap(past);
+        oldCurrent.swap(current);
+        int oldLr0 = lr0;
+        lr0 = newLr0;
+        lr1 = newLr1;
+        past.reshape(lr1 - lr0, cols);
+        current.reshape(lr1 - lr0, cols);
+        next.reshape(lr1 - lr0, cols);
+        // keep the levels through a change of edges; the halo is refetched before the next step anyway
+        for (int i = r0; i < r1 && oldPast.rows() > 0; i++)
+        {
+            std::memcpy(past[i - lr0], oldPast[i - oldLr0], cols * sizeof(T));
+            std::memcpy(current[i - lr0], oldCurrent[i - oldLr0], cols * sizeof(T));
+        }
+    }
+
+    void exchangeHalos()
+    {
+        const int me = transport.rank(), ranks = transport.size();
+        const size_t bytes = (size_t)haloRows * past.stride() * sizeof(T);
+        for (int round = 0; round < 2; round++)
+        {
+            // round 0 pairs (0, 1), (2, 3)...; round 1 pairs (1, 2), (3, 4)...
+            int peer = ((me & 1) == round) ? me + 1 : me - 1;
+            if (peer < 0 || peer >= ranks)
+                continue;
+            if (peer < me)
+            {
+                // my first rows are its bottom halo, its last rows my top halo
+                transport.exchange(peer, pastRow(r0), pastRow(r0 - haloRows), bytes);
+                transport.exchange(peer, currentRow(r0), currentRow(r0 - haloRows), bytes);
+            }
+            else
+            {
+                transport.exchange(peer, pastRow(r1 - haloRows), pastRow(r1), bytes);
+                transport.exchange(peer, currentRow(r1 - haloRows), currentRow(r1), bytes);
+            }
+        }
+    }
+
+    void stepBlock(int block)
+    {
+        const int localRows = lr1 - lr0;
+        const bool openTop = lr0 > 0, openBottom = lr1 < totalRows;
+        for (int s = 1; s <= block; s++)
+        {
+            int begin = openTop ? s : 1;
+            int end = openBottom ? localRows - s : localRows - 1;
+            if (pool)
+                pool->parallelFor(end - begin, 16, [&](size_t b0, size_t b1) {
+                    waveStep(past, current, next, r2, begin + (int)b0, begin + (int)b1, lr0, 0);
+                });
+            else
+                waveStep(past, current, next, r2, begin, end, lr0, 0);
+            if (absorbing)
+                waveAbsorbEdges(current, next, courant, begin, end, !openTop, !openBottom, true, true);
+            past.swap(current);
+            current.swap(next);
+        }
+    }
+};
+#endif
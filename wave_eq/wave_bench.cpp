@@ -0,0 +1,211 @@
+// Steps per second of the wave update at a few grid sizes: the original vector<vector> stepper with its two deep
+// copies per step, the same with the levels swapped instead, Grid2D through the scalar and AVX2 kernels, and
+// WaveSolver tiled over the thread pool with and without temporal blocking. Every version starts from the demo's
+// Gaussian and the final heights are checked against the original; WaveSolver has to match waveStep exactly, and the
+// run fails if it doesn't.
+//
+// Then a narrow pulse (sigma 4 cells) in the middle of the grid for 400 steps, WaveSolver stepping every tile against
+// it tracking active tiles: at threshold 0, which has to match exactly too, and at 1e-5 (1e-6 of the amplitude).
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 -pthread wave_bench.cpp -o wave_bench
+//   ./wave_bench [size ...]        (default 150 1024 4096)
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+typedef std::vector<std::vector<float>> NestedGrid;
+
+static float gaussian(int i, int k, int n)
+{
+    const float L = 20.0f, dx = L / (n - 1.0f);
+    float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+    return 10.0f * std::exp(-(x * x + y * y) / 2.0f);
+}
+
+static const float R2 = 0.3f * 0.3f;
+
+// main.cpp before Grid2D: u_past = u_current; u_current = u_next; after every step when 'copy' is set
+static double runNested(int n, int steps, bool copy, NestedGrid& result)
+{
+    NestedGrid past(n, std::vector<float>(n, 0.0f)), current = past, next = past;
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+            past[i][k] = current[i][k] = gaussian(i, k, n);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+        for (int i = 1; i < n - 1; ++i)
+            for (int k = 1; k < n - 1; ++k)
+                next[i][k] = 2 * current[i][k] - past[i][k] + R2 * (current[i + 1][k] - 2 * current[i][k] + current[i - 1][k])
+                             + R2 * (current[i][k + 1] - 2 * current[i][k] + current[i][k - 1]);
+        if (copy)
+        {
+            past = current;
+            current = next;
+        }
+        else
+        {
+            past.swap(current);
+            current.swap(next);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result = current;
+    return steps / seconds;
+}
+
+static double runGrid(int n, int steps,
+                      void (*kernel)(const Grid2D<float>&, const Grid2D<float>&, Grid2D<float>&, float, int, int, int, int),
+                      Grid2D<float>& result)
+{
+    Grid2D<float> past(n, n), current(n, n), next(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+            past[i][k] = current[i][k] = gaussian(i, k, n);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++)
+    {
+        kernel(past, current, next, R2, 1, n - 1, 0, 0);
+        past.swap(current);
+        current.swap(next);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result = current;
+    return steps / seconds;
+}
+
+static double runSolver(int n, int steps, ThreadPool* pool, int timeBlock, Grid2D<float>& result)
+{
+    Grid2D<float> past(n, n), current(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+            past[i][k] = current[i][k] = gaussian(i, k, n);
+
+    WaveSolver solver(R2, pool, timeBlock);
+    auto start = std::chrono::steady_clock::now();
+    solver.advance(past, current, steps);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result = current;
+    return steps / seconds;
+}
+
+// a pulse much smaller than the grid, for the sparse runs
+static float pulse(int i, int k, int n)
+{
+    float x = i - n / 2.0f, y = k - n / 2.0f;
+    return 10.0f * std::exp(-(x * x + y * y) / (2.0f * 4.0f * 4.0f));
+}
+
+// threshold < 0 steps every tile
+static double runSparse(int n, int steps, ThreadPool* pool, float threshold, Grid2D<float>& result, double& fraction)
+{
+    Grid2D<float> past(n, n), current(n, n);
+    for (int i = 1; i < n - 1; ++i)
+        for (int k = 1; k < n - 1; ++k)
+            past[i][k] = pulse(i, k, n);
+    waveStartStep(past, current, R2);
+
+    // skipping works a tile at a time, so the tracked runs use small ones
+    WaveSolver solver = threshold >= 0.0f ? WaveSolver(R2, pool, 8, 64, 128) : WaveSolver(R2, pool);
+    if (threshold >= 0.0f)
+        solver.trackActivity(threshold);
+    auto start = std::chrono::steady_clock::now();
+    solver.advance(past, current, steps);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result = current;
+    fraction = solver.activeFraction();
+    return steps / seconds;
+}
+
+static bool identical(const Grid2D<float>& a, const Grid2D<float>& b)
+{
+    for (int i = 0; i < a.rows(); i++)
+        if (std::memcmp(a[i], b[i], a.cols() * sizeof(float)) != 0)
+            return false;
+    return true;
+}
+
+template<class GridA, class GridB>
+static float maxDifference(const GridA& a, const GridB& b, int n)
+{
+    float worst = 0.0f;
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++)
+            worst = std::max(worst, std::abs(a[i][k] - b[i][k]));
+    return worst;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::max(3, std::atoi(argv[i])));
+    if (sizes.empty())
+        sizes = { 150, 1024, 4096 };
+
+    ThreadPool pool;
+    bool allMatch = true;
+
+    for (int n : sizes)
+    {
+        // roughly 2e9 cell updates per version, at least a handful of steps
+        int steps = std::max(5, (int)(2e9 / ((double)n * n)));
+        steps = std::min(steps, 20000);
+
+        NestedGrid reference, swapped;
+        Grid2D<float> scalar, vectorised;
+        double copying = runNested(n, steps, true, reference);
+        double swapping = runNested(n, steps, false, swapped);
+        double scalarRate = runGrid(n, steps, waveStepRowsScalar, scalar);
+        std::cout << n << "x" << n << ", " << steps << " steps (steps/s, speedup over vector<vector> with copies)\n"
+                  << "  vector<vector> + copies " << copying << "\n"
+                  << "  vector<vector> + swap   " << swapping << "  " << swapping / copying << "x\n"
+                  << "  Grid2D scalar           " << scalarRate << "  " << scalarRate / copying << "x"
+                  << "  max diff " << maxDifference(scalar, reference, n) << "\n";
+#ifdef WAVE_GRID_AVX2
+        double avxRate = runGrid(n, steps, waveStepRowsAvx2, vectorised);
+        std::cout << "  Grid2D AVX2             " << avxRate << "  " << avxRate / copying << "x"
+                  << "  max diff " << maxDifference(vectorised, reference, n) << "\n";
+#else
+        runGrid(n, steps, waveStepRowsScalar, vectorised);
+#endif
+        for (int timeBlock : { 1, 4, 16 })
+        {
+            Grid2D<float> tiled;
+            double rate = runSolver(n, steps, &pool, timeBlock, tiled);
+            bool match = identical(tiled, vectorised);
+            allMatch = allMatch && match;
+            std::cout << "  WaveSolver " << pool.size() << " threads, " << timeBlock << (timeBlock < 10 ? " " : "")
+                      << " steps/tile " << rate << "  " << rate / copying << "x  "
+                      << (match ? "matches waveStep" : "DIFFERS FROM waveStep") << "\n";
+        }
+
+        const int sparseSteps = 400;
+        Grid2D<float> everyTile, exact, thresholded;
+        double fraction;
+        double denseRate = runSparse(n, sparseSteps, &pool, -1.0f, everyTile, fraction);
+        std::cout << "  pulse, " << sparseSteps << " steps: every tile     " << denseRate << "\n";
+        double exactRate = runSparse(n, sparseSteps, &pool, 0.0f, exact, fraction);
+        bool match = identical(exact, everyTile);
+        allMatch = allMatch && match;
+        std::cout << "  active tiles, threshold 0     " << exactRate << "  " << exactRate / denseRate << "x, "
+                  << fraction * 100.0 << "% of tiles at the end  " << (match ? "matches" : "DIFFERS") << "\n";
+        double looseRate = runSparse(n, sparseSteps, &pool, 1e-5f, thresholded, fraction);
+        std::cout << "  active tiles, threshold 1e-5  " << looseRate << "  " << looseRate / denseRate << "x, "
+                  << fraction * 100.0 << "% of tiles at the end  max diff " << maxDifference(thresholded, everyTile, n)
+                  << "\n";
+        std::cout << std::flush;
+    }
+    if (!allMatch)
+        std::cout << "ERROR::WAVE_BENCH:: the tiled solver doesn't match waveStep" << std::endl;
+    return allMatch ? 0 : -1;
+}
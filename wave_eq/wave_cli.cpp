@@ -0,0 +1,195 @@
+// The wave equation without a window: steps the grid for a given stretch of sim time as fast as the CPU goes and
+// streams the height field to a sim_record.h file.
+//
+//   g++ -O2 -mavx2 -mfma -std=c++17 wave_cli.cpp -o wave_cli
+//   ./wave_cli --out wave.rec --seconds 200 --n 300
+//   ./wave_cli --out wave.rec --n 2048 --frame-steps 100 --threads 0
+//
+// Same scheme, domain, starting Gaussian and Grid2D stepper as main.cpp. A frame is the nx * ny heights packed with
+// u[i][k] at i * ny + k, written every --frame-steps steps (frameDt in the header is that many
+// dt). Steps go through WaveSolver, --threads workers (0 for one per core, the default 1 keeps it on this thread) taking
+// up to --time-block steps per tile pass. --sparse t steps only the tiles near one where |u| > t (0 skips exact zeros
+// only and changes nothing in the output), in smaller tiles. --absorbing lets the wave out through the edges
+// (waveAbsorbEdges) instead of reflecting it. --scheme order2|order4|order6|spectral steps a periodic domain instead
+// with wave_schemes.h, at Courant number --courant (default 0.3, up to stableCourant() of the scheme; spectral needs a
+// power of two n and takes any). Model parameters in the header: L, nx, ny, c, r (the Courant number), dt, sigma,
+// amplitude.
+//
+// --compress e writes a wave_record.h file instead, every height within e of the run's (0 keeps them exact), with a
+// keyframe every --chunk-frames frames (default 64). main.cpp plays either kind back with --play.
+
+#include "wave_grid.h"
+#include "wave_solver.h"
+#include "wave_schemes.h"
+#include "sim_record.h"
+#include "wave_record.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* outPath = nullptr;
+    double seconds = 10.0;
+    int n = 150;
+    int frameSteps = 1;
+    int threads = 1;
+    int timeBlock = 8;
+    float sparseThreshold = -1.0f;
+    bool absorbing = false;
+    const char* schemeName = nullptr;
+    float courant = 0.3f;
+    double errorBound = -1.0;
+    int chunkFrames = 64;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--out") == 0 && hasValue)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--n") == 0 && hasValue)
+            n = std::max(3, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--frame-steps") == 0 && hasValue)
+            frameSteps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+            threads = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--time-block") == 0 && hasValue)
+            timeBlock = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--absorbing") == 0)
+            absorbing = true;
+        else if (std::strcmp(argv[i], "--sparse") == 0 && hasValue)
+            sparseThreshold = std::max(0.0f, (float)std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--scheme") == 0 && hasValue)
+            schemeName = argv[++i];
+        else if (std::strcmp(argv[i], "--courant") == 0 && hasValue)
+            courant = (float)std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--compress") == 0 && hasValue)
+            errorBound = std::max(0.0, std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--chunk-frames") == 0 && hasValue)
+            chunkFrames = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            std::cerr << "usage: wave_cli --out file|- [--seconds T] [--n gridSize] [--frame-steps k] [--threads N]"
+                      << " [--time-block T] [--sparse threshold] [--absorbing]"
+                      << " [--scheme order2|order4|order6|spectral] [--courant r]"
+                      << " [--compress errorBound] [--chunk-frames k]" << std::endl;
+            return -1;
+        }
+    }
+    if (!outPath)
+    {
+        std::cerr << "ERROR::WAVE_CLI:: --out is required" << std::endl;
+        return -1;
+    }
+    if (errorBound >= 0.0 && std::strcmp(outPath, "-") == 0)
+    {
+        std::cerr << "ERROR::WAVE_CLI:: --compress needs a file, the index goes in at the end" << std::endl;
+        return -1;
+    }
+    WaveScheme scheme = WaveScheme::Order2;
+    if (schemeName)
+    {
+        if (!parseWaveScheme(schemeName, scheme))
+        {
+            std::cerr << "ERROR::WAVE_CLI:: unknown scheme " << schemeName << std::endl;
+            return -1;
+        }
+        if (absorbing || sparseThreshold >= 0.0f)
+        {
+            std::cerr << "ERROR::WAVE_CLI:: --scheme is periodic, it takes neither --absorbing nor --sparse" << std::endl;
+            return -1;
+        }
+        if (scheme == WaveScheme::Spectral && !Fft::isPowerOfTwo(n))
+        {
+            std::cerr << "ERROR::WAVE_CLI:: the spectral scheme needs a power of two --n" << std::endl;
+            return -1;
+        }
+        if (courant > stableCourant(scheme))
+        {
+            std::cerr << "ERROR::WAVE_CLI:: " << schemeName << " is unstable above r = " << stableCourant(scheme) << std::endl;
+            return -1;
+        }
+    }
+
+    const float L = 20.0f;
+    const float sigma = 1.0f;
+    const float c = 1.0f;
+    const int nx = n, ny = n;
+    // periodic: n cells to the side, the last one next to the first
+    const float dx = schemeName ? L / nx : L / (nx - 1.0f);
+    const float r = schemeName ? courant : 0.3f;
+    const float dt = r * (dx / c);
+    const float r2 = r * r;
+    const uint64_t steps = (uint64_t)std::ceil(seconds / dt);
+
+    const std::vector<double> params = { L, (double)nx, (double)ny, c, r, dt, sigma, 10.0 };
+    SimRecordWriter writer;
+    WaveRecordWriter compressed;
+    const bool compressing = errorBound >= 0.0;
+    const double frameDt = (double)dt * frameSteps;
+    if (compressing ? !compressed.open(outPath, "wave", nx, ny, frameDt, errorBound, params, chunkFrames)
+                    : !writer.open(outPath, "wave", (uint32_t)(nx * ny), frameDt, params))
+        return -1;
+    auto write = [&](const float *f) { return compressing ? compressed.write(f) : writer.write(f); };
+
+    Grid2D<float> past(nx, ny), current(nx, ny);
+    const int edge = schemeName ? 0 : 1;
+    for (int i = edge; i < nx - edge; ++i)
+    {
+        for (int k = edge; k < ny - edge; ++k)
+        {
+            float x = i * dx - L / 4.0f, y = k * dx - L / 2.0f;
+            past[i][k] = 10.0f * std::exp(-(x * x + y * y) / (2.0f * sigma * sigma));
+        }
+    }
+    std::unique_ptr<PeriodicWaveStepper> periodic(schemeName ? new PeriodicWaveStepper(scheme, nx, ny, r) : nullptr);
+    if (periodic)
+        periodic->startStep(past, current);
+    else
+        waveStartStep(past, current, r2);
+
+    std::vector<float> frame(nx * ny);
+    auto start = std::chrono::steady_clock::now();
+    past.copyTo(frame.data());
+    if (!write(frame.data()))
+        return -1;
+    std::unique_ptr<ThreadPool> pool(threads == 1 ? nullptr : new ThreadPool(threads));
+    // skipping goes a tile at a time, so small tiles when it's on
+    WaveSolver solver = sparseThreshold < 0.0f ? WaveSolver(r2, pool.get(), timeBlock)
+                                               : WaveSolver(r2, pool.get(), timeBlock, 64, 128);
+    if (sparseThreshold >= 0.0f)
+        solver.trackActivity(sparseThreshold);
+    if (absorbing)
+        solver.setAbsorbingEdges(r);
+    uint64_t level = 1; // current is this many steps in
+    for (uint64_t target = frameSteps; target <= steps; target += frameSteps)
+    {
+        if (periodic)
+            periodic->advance(past, current, (int)(target - level));
+        else
+            solver.advance(past, current, (int)(target - level));
+        level = target;
+        current.copyTo(frame.data());
+        if (!write(frame.data()))
+            return -1;
+    }
+    writer.close();
+    compressed.close();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t frames = compressing ? compressed.frameCount() : writer.frameCount();
+    uint64_t bytes = compressing ? compressed.bytesWritten() : writer.bytesWritten();
+    std::cerr << frames << " frames of " << nx << "x" << ny << ", " << steps << " steps (" << seconds
+              << "s of sim time) in " << wall << "s, " << steps * (nx - 2.0) * (ny - 2.0) / wall / 1e6
+              << " Mcell updates/s, " << bytes / 1e6 << " MB";
+    if (compressing)
+        std::cerr << ", " << 8.0 * bytes / ((double)frames * nx * ny) << " bits a cell a frame";
+    std::cerr << std::endl;
+    return 0;
+}
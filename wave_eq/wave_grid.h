@@ -0,0 +1,350 @@
+#ifndef WAVE_GRID_H
+#define WAVE_GRID_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include "half_float.h"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define WAVE_GRID_AVX2 1
+#endif
+
+// A rows x cols grid of T in one aligned block. Every row starts on a 32 byte boundary and is padded to a whole number
+// of AVX registers, and there is a halo around the grid (a margin before each row, a spare row above and below), so a
+// stencil can read the neighbours of any cell, edges included, without a bounds check and with aligned loads for the
+// centre. grid[i][k] works like the vector<vector> it replaces, i is the row and k goes along it; the halo is at
+// i = -1, i = rows, k = -1 and k = cols. Everything outside the grid proper starts at zero.
+//
+// Copying into a grid of the same shape reuses its block, and swap() only trades pointers, which is how the wave
+// solver rotates its time levels.
+template<class T>
+class Grid2D
+{
+public:
+    static const size_t ALIGN = 32;
+    static const size_t MARGIN = ALIGN / sizeof(T); // cells before column 0, only the last is used as halo
+
+    Grid2D() {}
+
+    Grid2D(int rows, int cols, T fill = T()) : r(rows), c(cols)
+    {
+        reshape(rows, cols);
+        for (int i = 0; i < rows; i++)
+            std::fill(row(i), row(i) + cols, fill);
+    }
+
+    ~Grid2D() { std::free(block); }
+
+    Grid2D(const Grid2D &other) : Grid2D() { *this = other; }
+    Grid2D(Grid2D &&other) noexcept { swap(other); }
+
+    Grid2D& operator=(const Grid2D &other)
+    {
+        if (this == &other)
+            return *this;
+        if (r != other.r || c != other.c)
+            reshape(other.r, other.c);
+        if (other.block)
+            std::memcpy(block, other.block, bytes());
+        return *this;
+    }
+
+    Grid2D& operator=(Grid2D &&other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(Grid2D &other) noexcept
+    {
+        std::swap(block, other.block);
+        std::swap(r, other.r);
+        std::swap(c, other.c);
+        std::swap(pitch, other.pitch);
+        std::swap(capacity, other.capacity);
+    }
+
+    // a new shape, all zero. The block is only reallocated when the new shape doesn't fit in it
+    void reshape(int rows, int cols)
+    {
+        r = rows;
+        c = cols;
+        pitch = MARGIN + ((cols + 1 + MARGIN - 1) / MARGIN) * MARGIN; // at least one padding cell after the last column
+        if (bytes() > capacity)
+        {
+            std::free(block);
+            capacity = bytes();
+            block = static_cast<T*>(std::aligned_alloc(ALIGN, capacity));
+        }
+        if (block)
+            std::memset(block, 0, bytes());
+    }
+
+    int rows() const { return r; }
+    int cols() const { return c; }
+    size_t stride() const { return pitch; } // cells from one row to the next
+
+    T* row(int i) { return block + (size_t)(i + 1) * pitch + MARGIN; }
+    const T* row(int i) const { return block + (size_t)(i + 1) * pitch + MARGIN; }
+    T* operator[](int i) { return row(i); }
+    const T* operator[](int i) const { return row(i); }
+
+    // the grid proper packed row after row into out (rows * cols values), e.g. for a recording. Into floats from a
+    // Half or BFloat16 grid converts
+    template<class U>
+    void copyTo(U *out) const
+    {
+        for (int i = 0; i < r; i++)
+        {
+            if (std::is_same<T, U>::value)
+                std::memcpy(out + (size_t)i * c, row(i), c * sizeof(T));
+            else
+                for (int k = 0; k < c; k++)
+                    out[(size_t)i * c + k] = fromFloat<U>(toFloat(row(i)[k]));
+        }
+    }
+
+private:
+    T *block = nullptr;
+    int r = 0, c = 0;
+    size_t pitch = 0;
+    size_t capacity = 0; // bytes in block
+
+    size_t bytes() const { return (size_t)(r + 2) * pitch * sizeof(T); }
+};
+
+// the coin for fromFloatDithered: the cell's place in the whole grid, what it holds now and the value going in. Float
+// grids aren't dithered
+inline uint32_t waveDitherHash(int, int, float, float) { return 0; }
+
+template<class T>
+inline uint32_t waveDitherHash(int row, int col, T centre, float value)
+{
+    uint32_t valueBits;
+    std::memcpy(&valueBits, &value, 4);
+    return ditherHash(((uint32_t)row * 0x9e3779b1u) ^ ((uint32_t)col * 0x85ebca77u) ^ centre.bits ^ valueBits);
+}
+
+// one step of the leapfrog scheme for u_tt = c^2 (u_xx + u_yy) with the same spacing in x and y:
+//   next = 2 current - past + r2 (sum of the four neighbours - 4 current),   r2 = (c dt / dx)^2
+// over the interior, with the outer ring of the grid held at zero. Rows [rowBegin, rowEnd) only, so callers can split
+// a step into bands; the default is the whole interior. The boundary ring of next must already be zero and is kept
+// that way, as is its padding.
+//
+// T is float, or Half or BFloat16 (half_float.h) for grids stored in 16 bits. The sum is always worked out in float;
+// 16 bit results are stored with fromFloatDithered, as a step of a fine grid moves a cell by far less than half a
+// Half step. The coin depends on where the cell is in the whole grid, originRow and originCol being where these grids'
+// row 0 and column 0 sit in it for callers stepping a copy of part of it, so the result doesn't depend on how the grid
+// is split up.
+template<class T>
+inline void waveStepRowsScalar(const Grid2D<T> &past, const Grid2D<T> &current, Grid2D<T> &next, float r2,
+                               int rowBegin, int rowEnd, int originRow, int originCol)
+{
+    const int cols = current.cols();
+    const size_t stride = current.stride();
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        const T* u = current[i];
+        const T* up = past[i];
+        T* un = next[i];
+        for (int k = 1; k < cols - 1; k++)
+        {
+            float centre = toFloat(u[k]);
+            float value = 2.0f * centre - toFloat(up[k]) + r2 * (toFloat(u[k + stride]) + toFloat(u[k - stride]) +
+                                                                  toFloat(u[k + 1]) + toFloat(u[k - 1]) - 4.0f * centre);
+            un[k] = fromFloatDithered<T>(value, waveDitherHash(originRow + i, originCol + k, u[k], value));
+        }
+    }
+}
+
+#ifdef WAVE_GRID_AVX2
+// the same update eight cells at a time. Each row is done in whole registers from column 0, the halo and padding
+// supplying the missing neighbours, then the two boundary cells and the padding written along the way are zeroed
+// again.
+inline void waveStepRowsAvx2(const Grid2D<float> &past, const Grid2D<float> &current, Grid2D<float> &next, float r2,
+                             int rowBegin, int rowEnd, int, int)
+{
+    const int cols = current.cols();
+    const size_t stride = current.stride();
+    const int vectorCols = (cols + 7) & ~7;
+    const __m256 two = _mm256_set1_ps(2.0f), four = _mm256_set1_ps(4.0f), r2v = _mm256_set1_ps(r2);
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        const float* u = current[i];
+        const float* up = past[i];
+        float* un = next[i];
+        for (int k = 0; k < vectorCols; k += 8)
+        {
+            __m256 centre = _mm256_load_ps(u + k);
+            __m256 sum = _mm256_add_ps(_mm256_load_ps(u + k + stride), _mm256_load_ps(u + k - stride));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(u + k + 1));
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(u + k - 1));
+            __m256 laplacian = _mm256_sub_ps(sum, _mm256_mul_ps(four, centre));
+            __m256 result = _mm256_sub_ps(_mm256_mul_ps(two, centre), _mm256_load_ps(up + k));
+            _mm256_store_ps(un + k, _mm256_add_ps(result, _mm256_mul_ps(r2v, laplacian)));
+        }
+        un[0] = 0.0f;
+        std::fill(un + cols - 1, un + vectorCols, 0.0f);
+    }
+}
+
+// the 16 bit grids the same way, eight cells a register widened to float on the way in and dithered back on the way
+// out (the same arithmetic as waveDitherHash and fromFloatDithered, lane for lane), so a step moves half the bytes.
+// Half needs F16C (-mf16c) for the conversions, otherwise it falls back to the scalar loop; BFloat16 is only shifts
+inline __m256i waveDitherHash8(int row, int col, __m128i centreBits, __m256 value)
+{
+    const __m256i laneSteps = _mm256_setr_epi32(0, (int)0x85ebca77u, (int)(2u * 0x85ebca77u), (int)(3u * 0x85ebca77u),
+                                                (int)(4u * 0x85ebca77u), (int)(5u * 0x85ebca77u),
+                                                (int)(6u * 0x85ebca77u), (int)(7u * 0x85ebca77u));
+    __m256i x = _mm256_add_epi32(_mm256_set1_epi32((int)((uint32_t)col * 0x85ebca77u)), laneSteps);
+    x = _mm256_xor_si256(x, _mm256_set1_epi32((int)((uint32_t)row * 0x9e3779b1u)));
+    x = _mm256_xor_si256(x, _mm256_cvtepu16_epi32(centreBits));
+    x = _mm256_xor_si256(x, _mm256_castps_si256(value));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+    return _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+}
+
+#if defined(__F16C__)
+inline __m256 waveLoad8(const Half *p) { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)p)); }
+
+inline void waveStore8(Half *p, __m256 v, __m256i hash)
+{
+    __m256i exponent = _mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(v), 23), _mm256_set1_epi32(0xff));
+    exponent = _mm256_max_epi32(_mm256_sub_epi32(exponent, _mm256_set1_epi32(10)), _mm256_set1_epi32(103));
+    __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_sub_epi32(exponent, _mm256_set1_epi32(13)), 23));
+    __m256 dither = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(hash, _mm256_set1_epi32(0x1fff))), scale);
+    dither = _mm256_or_ps(dither, _mm256_and_ps(v, _mm256_set1_ps(-0.0f)));
+    _mm_storeu_si128((__m128i*)p, _mm256_cvtps_ph(_mm256_add_ps(v, dither), _MM_FROUND_TO_ZERO));
+}
+#endif
+
+inline __m256 waveLoad8(const BFloat16 *p)
+{
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+}
+
+inline void waveStore8(BFloat16 *p, __m256 v, __m256i hash)
+{
+    __m256i bits = _mm256_add_epi32(_mm256_castps_si256(v), _mm256_and_si256(hash, _mm256_set1_epi32(0xffff)));
+    __m256i packed = _mm256_packus_epi32(_mm256_srli_epi32(bits, 16), _mm256_setzero_si256());
+    _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, 0x08)));
+}
+
+template<class T>
+inline void waveStepRows16Avx2(const Grid2D<T> &past, const Grid2D<T> &current, Grid2D<T> &next, float r2,
+                               int rowBegin, int rowEnd, int originRow, int originCol)
+{
+    const int cols = current.cols();
+    const size_t stride = current.stride();
+    const int vectorCols = (cols + 7) & ~7;
+    const __m256 two = _mm256_set1_ps(2.0f), four = _mm256_set1_ps(4.0f), r2v = _mm256_set1_ps(r2);
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        const T* u = current[i];
+        const T* up = past[i];
+        T* un = next[i];
+        for (int k = 0; k < vectorCols; k += 8)
+        {
+            __m128i centreBits = _mm_loadu_si128((const __m128i*)(u + k));
+            __m256 centre = waveLoad8(u + k);
+            __m256 sum = _mm256_add_ps(waveLoad8(u + k + stride), waveLoad8(u + k - stride));
+            sum = _mm256_add_ps(sum, waveLoad8(u + k + 1));
+            sum = _mm256_add_ps(sum, waveLoad8(u + k - 1));
+            __m256 laplacian = _mm256_sub_ps(sum, _mm256_mul_ps(four, centre));
+            __m256 result = _mm256_sub_ps(_mm256_mul_ps(two, centre), waveLoad8(up + k));
+            __m256 value = _mm256_add_ps(result, _mm256_mul_ps(r2v, laplacian));
+            waveStore8(un + k, value, waveDitherHash8(originRow + i, originCol + k, centreBits, value));
+        }
+        un[0] = T();
+        std::fill(un + cols - 1, un + vectorCols, T());
+    }
+}
+
+inline void waveStepRowsAvx2(const Grid2D<Half> &past, const Grid2D<Half> &current, Grid2D<Half> &next, float r2,
+                             int rowBegin, int rowEnd, int originRow, int originCol)
+{
+#if defined(__F16C__)
+    waveStepRows16Avx2(past, current, next, r2, rowBegin, rowEnd, originRow, originCol);
+#else
+    waveStepRowsScalar(past, current, next, r2, rowBegin, rowEnd, originRow, originCol);
+#endif
+}
+
+inline void waveStepRowsAvx2(const Grid2D<BFloat16> &past, const Grid2D<BFloat16> &current, Grid2D<BFloat16> &next,
+                             float r2, int rowBegin, int rowEnd, int originRow, int originCol)
+{
+    waveStepRows16Avx2(past, current, next, r2, rowBegin, rowEnd, originRow, originCol);
+}
+#endif
+
+template<class T>
+inline void waveStep(const Grid2D<T> &past, const Grid2D<T> &current, Grid2D<T> &next, float r2,
+                     int rowBegin = 1, int rowEnd = -1, int originRow = 0, int originCol = 0)
+{
+    if (rowEnd < 0)
+        rowEnd = current.rows() - 1;
+#ifdef WAVE_GRID_AVX2
+    waveStepRowsAvx2(past, current, next, r2, rowBegin, rowEnd, originRow, originCol);
+#else
+    waveStepRowsScalar(past, current, next, r2, rowBegin, rowEnd, originRow, originCol);
+#endif
+}
+
+// first-order Engquist-Majda absorbing edges, for use instead of the zero ring: each edge cell of next is set so that a
+// wave leaving straight out through that edge carries on instead of reflecting (Mur's discretisation of u_t = -c u_n)
+//   next[edge] = current[inner] + (r - 1) / (r + 1) (next[inner] - current[edge]),   r = c dt / dx, not squared
+// with inner the cell one in from the edge. Run it once waveStep has filled the interior of next. The left and right
+// edges are done for rows [rowBegin, rowEnd), then the top and bottom rows across the full width, corners included;
+// each side can be left out, for callers stepping part of the grid.
+template<class T>
+inline void waveAbsorbEdges(const Grid2D<T> &current, Grid2D<T> &next, float r, int rowBegin = 1,
+                            int rowEnd = -1, bool top = true, bool bottom = true, bool left = true, bool right = true)
+{
+    const int rows = current.rows(), cols = current.cols();
+    if (rowEnd < 0)
+        rowEnd = rows - 1;
+    const float m = (r - 1.0f) / (r + 1.0f);
+    auto absorb = [m](T inner, T nextInner, T edge) {
+        return fromFloat<T>(toFloat(inner) + m * (toFloat(nextInner) - toFloat(edge)));
+    };
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        if (left)
+            next[i][0] = absorb(current[i][1], next[i][1], current[i][0]);
+        if (right)
+            next[i][cols - 1] = absorb(current[i][cols - 2], next[i][cols - 2], current[i][cols - 1]);
+    }
+    if (top)
+        for (int k = 0; k < cols; k++)
+            next[0][k] = absorb(current[1][k], next[1][k], current[0][k]);
+    if (bottom)
+        for (int k = 0; k < cols; k++)
+            next[rows - 1][k] = absorb(current[rows - 2][k], next[rows - 2][k], current[rows - 1][k]);
+}
+
+// the first step from rest, half the usual update: next = current + r2 / 2 (neighbours - 4 current)
+template<class T>
+inline void waveStartStep(const Grid2D<T> &current, Grid2D<T> &next, float r2)
+{
+    const size_t stride = current.stride();
+    for (int i = 1; i < current.rows() - 1; i++)
+    {
+        const T* u = current[i];
+        T* un = next[i];
+        for (int k = 1; k < current.cols() - 1; k++)
+        {
+            float centre = toFloat(u[k]);
+            un[k] = fromFloat<T>(centre + r2 / 2.0f * (toFloat(u[k + stride]) + toFloat(u[k - stride]) +
+                                                       toFloat(u[k + 1]) + toFloat(u[k - 1]) - 4.0f * centre));
+        }
+    }
+}
+#endif
@@ -0,0 +1,20 @@
+#version 330 core
+// a point per grid cell with no vertex buffer: the cell comes from gl_VertexID and its height straight from the
+// solver's textures, blended between the last two levels like the CPU path
+uniform sampler2D heights;
+uniform sampler2D previousHeights;
+uniform float alpha;
+uniform vec2 spacing; // world distance between rows, between columns
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main() {
+    ivec2 size = textureSize(heights, 0);
+    ivec2 cell = ivec2(gl_VertexID % size.x, gl_VertexID / size.x); // (k, i)
+    float from = texelFetch(previousHeights, cell, 0).r;
+    float to = texelFetch(heights, cell, 0).r;
+    vec3 position = vec3(cell.y * spacing.x, mix(from, to, alpha), cell.x * spacing.y);
+    gl_Position = projection * view * vec4(position, 1.0);
+    gl_PointSize = 2.0;
+}
@@ -0,0 +1,498 @@
+#ifndef WAVE_RECORD_H
+#define WAVE_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A compressed recording of a height field, rows x cols floats a frame (packed like SimRecord frames), for runs too
+// long or too fine to keep at 4 bytes a cell a frame.
+//
+// Every value is first made an integer: with an error bound e > 0 it's rounded to the nearest multiple of 2e, so what
+// comes back is within e of what went in (and float rounding); with e = 0 the float's own bits are used, ordered so
+// that nearby values are nearby integers, and it comes back exactly. Each frame is then coded as the difference from
+// a prediction: the first frame of a chunk from the cell before it in the same frame, after that from the frame before
+// (delta) or the two before extrapolated in a straight line, whichever the writer finds smaller for that frame. The
+// differences are zigzagged (small negatives to small positives) and packed 64 to a block at the width of the widest
+// one, a byte giving the width; a quiet block of zeros costs one byte.
+//
+// The file is a WaveRecordHeader, then chunks of chunkFrames frames, each behind a WaveRecordChunk, then an index of
+// where every chunk starts. Going to a frame means decoding forward from the start of its chunk, so chunkFrames is
+// what a seek costs against how well the frames compress. The index and frameCount are written when the writer
+// closes; if it never did, the reader finds the chunks by walking their headers. Everything is in the byte order of
+// the machine that wrote it.
+struct WaveRecordHeader {
+    char magic[8];          // "WAVREC" then version 1
+    uint32_t headerBytes;   // the first chunk starts here
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t chunkFrames;   // frames per chunk, the first of each coded on its own
+    uint64_t frameCount;
+    uint64_t indexOffset;   // chunkCount uint64 chunk offsets start here, 0 if the writer didn't close
+    double frameDt;
+    double startTime;
+    double errorBound;      // 0 is lossless
+    char model[32];
+    uint32_t paramCount;
+    uint32_t reserved0;
+    double params[16];      // model parameters in the order the writer documents
+    char reserved[24];
+};
+static_assert(sizeof(WaveRecordHeader) == 256, "chunks start 256 bytes in");
+
+struct WaveRecordChunk {
+    uint64_t bytes;         // the frames after this header
+    uint32_t frames;
+    uint32_t reserved;
+};
+
+static const char WAVE_RECORD_MAGIC[8] = { 'W', 'A', 'V', 'R', 'E', 'C', 0, 1 };
+
+// the coding both sides share
+namespace wave_record {
+
+enum Prediction : uint8_t { PREVIOUS_CELL = 0, PREVIOUS_FRAME = 1, LINEAR = 2 };
+const int BLOCK = 64;
+
+inline uint32_t zigzag(uint32_t difference) { return (difference << 1) ^ (uint32_t)((int32_t)difference >> 31); }
+inline uint32_t unzigzag(uint32_t value) { return (value >> 1) ^ (0u - (value & 1u)); }
+
+// float bits ordered like the floats: negatives have their magnitude bits flipped. Its own inverse
+inline uint32_t orderedBits(uint32_t bits) { return bits ^ ((uint32_t)((int32_t)bits >> 31) & 0x7fffffffu); }
+
+inline uint32_t predict(Prediction prediction, const uint32_t *values, const uint32_t *previous,
+                        const uint32_t *beforeThat, size_t j)
+{
+    switch (prediction)
+    {
+    case PREVIOUS_CELL: return j ? values[j - 1] : 0u;
+    case PREVIOUS_FRAME: return previous[j];
+    default: return 2u * previous[j] - beforeThat[j];
+    }
+}
+
+inline int blockWidth(const uint32_t *values, size_t count)
+{
+    uint32_t all = 0;
+    for (size_t j = 0; j < count; j++)
+        all |= values[j];
+    int width = 0;
+    while (width < 32 && (all >> width))
+        width++;
+    return width;
+}
+
+// count zigzagged values to a width byte and 8 * width bytes per block (a short last block is padded with zeros)
+inline void packBlocks(const uint32_t *values, size_t count, std::vector<uint8_t> &out)
+{
+    for (size_t start = 0; start < count; start += BLOCK)
+    {
+        size_t n = std::min<size_t>(BLOCK, count - start);
+        int width = blockWidth(values + start, n);
+        out.push_back((uint8_t)width);
+        uint64_t bits = 0;
+        int held = 0;
+        for (int j = 0; j < BLOCK; j++)
+        {
+            bits |= (uint64_t)(j < (int)n ? values[start + j] : 0u) << held;
+            held += width;
+            while (held >= 8)
+            {
+                out.push_back((uint8_t)bits);
+                bits >>= 8;
+                held -= 8;
+            }
+        }
+    }
+}
+
+// the other way, returns the end of what it read or nullptr if it would read past end
+inline const uint8_t* unpackBlocks(const uint8_t *in, const uint8_t *end, uint32_t *values, size_t count)
+{
+    for (size_t start = 0; start < count; start += BLOCK)
+    {
+        if (in >= end || *in > 32 || end - in < 1 + 8 * *in)
+            return nullptr;
+        int width = *in++;
+        const uint64_t mask = (width == 32) ? 0xffffffffull : ((1ull << width) - 1);
+        size_t n = std::min<size_t>(BLOCK, count - start);
+        uint64_t bits = 0;
+        int held = 0;
+        for (size_t j = 0; j < BLOCK; j++)
+        {
+            while (held < width)
+            {
+                bits |= (uint64_t)*in++ << held;
+                held += 8;
+            }
+            if (j < n)
+                values[start + j] = (uint32_t)(bits & mask);
+            bits >>= width;
+            held -= width;
+        }
+    }
+    return in;
+}
+
+// what the packed blocks would take, without packing them
+inline size_t packedBytes(const uint32_t *values, size_t count)
+{
+    size_t bytes = 0;
+    for (size_t start = 0; start < count; start += BLOCK)
+        bytes += 1 + 8 * blockWidth(values + start, std::min<size_t>(BLOCK, count - start));
+    return bytes;
+}
+
+}
+
+class WaveRecordWriter
+{
+public:
+    WaveRecordWriter() {}
+    ~WaveRecordWriter() { close(); }
+
+    WaveRecordWriter(const WaveRecordWriter&) = delete;
+    WaveRecordWriter& operator=(const WaveRecordWriter&) = delete;
+
+    bool open(const char *path, const char *model, uint32_t rows, uint32_t cols, double frameDt, double errorBound,
+              const std::vector<double> &params, uint32_t chunkFrames = 64, double startTime = 0.0)
+    {
+        close();
+        file = std::fopen(path, "wb");
+        if (!file)
+        {
+            std::cerr << "ERROR::WAVE_RECORD::FILE_NOT_OPENED " << path << std::endl;
+            return false;
+        }
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, WAVE_RECORD_MAGIC, sizeof(header.magic));
+        header.headerBytes = sizeof(WaveRecordHeader);
+        header.rows = rows;
+        header.cols = cols;
+        header.chunkFrames = std::max(1u, chunkFrames);
+        header.frameDt = frameDt;
+        header.startTime = startTime;
+        header.errorBound = std::max(0.0, errorBound);
+        std::strncpy(header.model, model, sizeof(header.model) - 1);
+        header.paramCount = (uint32_t)std::min<size_t>(params.size(), 16);
+        for (uint32_t i = 0; i < header.paramCount; i++)
+            header.params[i] = params[i];
+
+        const size_t cells = (size_t)rows * cols;
+        values.assign(cells, 0u);
+        previous.assign(cells, 0u);
+        beforeThat.assign(cells, 0u);
+        differences.assign(cells, 0u);
+        trial.assign(cells, 0u);
+        chunk.clear();
+        chunkOffsets.clear();
+        framesInChunk = 0;
+        frames = 0;
+        written = sizeof(header);
+        return std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    // rows * cols floats. Fails on a value the error bound can't hold (too big for it, or not finite)
+    bool write(const float *frame)
+    {
+        using namespace wave_record;
+        if (!file)
+            return false;
+        const size_t cells = values.size();
+        if (header.errorBound > 0.0)
+        {
+            const double step = 2.0 * header.errorBound;
+            for (size_t j = 0; j < cells; j++)
+            {
+                double q = std::nearbyint(frame[j] / step);
+                if (!(std::abs(q) < 1073741824.0))
+                {
+                    std::cerr << "ERROR::WAVE_RECORD::VALUE_OUT_OF_RANGE " << frame[j] << " at error bound "
+                              << header.errorBound << std::endl;
+                    return false;
+                }
+                values[j] = (uint32_t)(int32_t)q;
+            }
+        }
+        else
+            for (size_t j = 0; j < cells; j++)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &frame[j], 4);
+                values[j] = orderedBits(bits);
+            }
+
+        // a chunk's first frame only has itself to go on; after that whichever of the two packs smaller
+        Prediction prediction = PREVIOUS_CELL;
+        difference(PREVIOUS_CELL, differences);
+        if (framesInChunk > 0)
+        {
+            difference(PREVIOUS_FRAME, differences);
+            prediction = PREVIOUS_FRAME;
+            if (framesInChunk > 1)
+            {
+                difference(LINEAR, trial);
+                if (packedBytes(trial.data(), cells) < packedBytes(differences.data(), cells))
+                {
+                    differences.swap(trial);
+                    prediction = LINEAR;
+                }
+            }
+        }
+        chunk.push_back(prediction);
+        packBlocks(differences.data(), cells, chunk);
+
+        beforeThat.swap(previous);
+        previous.swap(values);
+        frames++;
+        if (++framesInChunk == header.chunkFrames)
+            return flushChunk();
+        return true;
+    }
+
+    // writes the last chunk, the index and the frame count, and closes the file
+    void close()
+    {
+        if (!file)
+            return;
+        flushChunk();
+        header.indexOffset = written;
+        header.frameCount = frames;
+        std::fwrite(chunkOffsets.data(), sizeof(uint64_t), chunkOffsets.size(), file);
+        written += chunkOffsets.size() * sizeof(uint64_t);
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    uint64_t frameCount() const { return frames; }
+    uint64_t bytesWritten() const { return written + chunk.size(); }
+
+private:
+    FILE *file = nullptr;
+    WaveRecordHeader header;
+    std::vector<uint32_t> values, previous, beforeThat; // this frame and the two before as integers
+    std::vector<uint32_t> differences, trial;
+    std::vector<uint8_t> chunk;                         // the chunk so far
+    std::vector<uint64_t> chunkOffsets;
+    uint32_t framesInChunk = 0;
+    uint64_t frames = 0;
+    uint64_t written = 0;
+
+    void difference(wave_record::Prediction prediction, std::vector<uint32_t> &out) const
+    {
+        for (size_t j = 0; j < values.size(); j++)
+            out[j] = wave_record::zigzag(values[j] -
+                                         wave_record::predict(prediction, values.data(), previous.data(),
+                                                              beforeThat.data(), j));
+    }
+
+    bool flushChunk()
+    {
+        if (framesInChunk == 0)
+            return true;
+        WaveRecordChunk c = { chunk.size(), framesInChunk, 0 };
+        chunkOffsets.push_back(written);
+        bool ok = std::fwrite(&c, sizeof(c), 1, file) == 1 &&
+                  std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+        written += sizeof(c) + chunk.size();
+        chunk.clear();
+        framesInChunk = 0;
+        if (!ok)
+            std::cerr << "ERROR::WAVE_RECORD::WRITE_FAILED" << std::endl;
+        return ok;
+    }
+};
+
+// maps a recording read only and decodes frames out of the mapping. Going forward one frame at a time costs one
+// frame's decode; anything else starts again from the front of the frame's chunk
+class WaveRecordReader
+{
+public:
+    WaveRecordReader() {}
+    ~WaveRecordReader() { close(); }
+
+    WaveRecordReader(const WaveRecordReader&) = delete;
+    WaveRecordReader& operator=(const WaveRecordReader&) = delete;
+
+    bool open(const char *path)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            std::cout << "ERROR::WAVE_RECORD::FILE_NOT_OPENED " << path << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(WaveRecordHeader))
+        {
+            std::cout << "ERROR::WAVE_RECORD::FILE_TOO_SHORT " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        bytes = (size_t)info.st_size;
+        void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            std::cout << "ERROR::WAVE_RECORD::MAP_FAILED " << path << std::endl;
+            return false;
+        }
+        base = static_cast<const uint8_t*>(mapped);
+        const WaveRecordHeader &h = header();
+        if (std::memcmp(h.magic, WAVE_RECORD_MAGIC, sizeof(h.magic)) != 0 || h.rows == 0 || h.cols == 0 ||
+            h.chunkFrames == 0 || h.headerBytes > bytes)
+        {
+            std::cout << "ERROR::WAVE_RECORD::NOT_A_RECORDING " << path << std::endl;
+            close();
+            return false;
+        }
+
+        uint64_t chunkCount = h.frameCount ? (h.frameCount + h.chunkFrames - 1) / h.chunkFrames : 0;
+        if (h.indexOffset && h.indexOffset <= bytes && chunkCount <= (bytes - h.indexOffset) / sizeof(uint64_t))
+        {
+            chunkOffsets.resize(chunkCount);
+            std::memcpy(chunkOffsets.data(), base + h.indexOffset, chunkCount * sizeof(uint64_t));
+            count = h.frameCount;
+            // every chunk the index points at has to sit whole inside the file, past the header
+            for (uint64_t at : chunkOffsets)
+            {
+                WaveRecordChunk c;
+                if (at < h.headerBytes || at > bytes || bytes - at < sizeof(c))
+                    return damagedIndex(path);
+                std::memcpy(&c, base + at, sizeof(c));
+                if (c.frames == 0 || c.frames > h.chunkFrames || c.bytes > bytes - at - sizeof(c))
+                    return damagedIndex(path);
+            }
+        }
+        else
+        {
+            // no index: every whole chunk up to where the file stops
+            count = 0;
+            for (uint64_t at = h.headerBytes; at + sizeof(WaveRecordChunk) <= bytes;)
+            {
+                WaveRecordChunk c;
+                std::memcpy(&c, base + at, sizeof(c));
+                if (c.frames == 0 || c.frames > h.chunkFrames || at + sizeof(c) + c.bytes > bytes)
+                    break;
+                chunkOffsets.push_back(at);
+                count += c.frames;
+                at += sizeof(c) + c.bytes;
+            }
+        }
+        const size_t cells = (size_t)h.rows * h.cols;
+        values.assign(cells, 0u);
+        previous.assign(cells, 0u);
+        beforeThat.assign(cells, 0u);
+        decoded = UINT64_MAX;
+        return true;
+    }
+
+    void close()
+    {
+        if (base)
+            munmap(const_cast<uint8_t*>(base), bytes);
+        base = nullptr;
+        bytes = 0;
+        count = 0;
+        chunkOffsets.clear();
+    }
+
+    const WaveRecordHeader& header() const { return *reinterpret_cast<const WaveRecordHeader*>(base); }
+    uint64_t frameCount() const { return count; }
+    uint32_t rows() const { return header().rows; }
+    uint32_t cols() const { return header().cols; }
+    double timeOf(uint64_t frame) const { return header().startTime + frame * header().frameDt; }
+    double duration() const { return count ? timeOf(count - 1) - header().startTime : 0.0; }
+    size_t fileBytes() const { return bytes; }
+
+    // frame i (i < frameCount()) into out, rows * cols floats; false if the file is damaged there
+    bool decode(uint64_t frame, float *out)
+    {
+        using namespace wave_record;
+        const WaveRecordHeader &h = header();
+        if (frame >= count)
+            return false;
+        const uint64_t chunkIndex = frame / h.chunkFrames;
+        if (decoded == UINT64_MAX || frame <= decoded || decoded / h.chunkFrames != chunkIndex)
+        {
+            // from the top of the chunk
+            WaveRecordChunk c;
+            std::memcpy(&c, base + chunkOffsets[chunkIndex], sizeof(c));
+            cursor = base + chunkOffsets[chunkIndex] + sizeof(c);
+            chunkEnd = std::min(base + bytes, cursor + c.bytes);
+            decoded = chunkIndex * h.chunkFrames - 1; // wraps for chunk 0, the first increment brings it back
+        }
+        while (decoded != frame)
+            if (!decodeNext())
+            {
+                std::cout << "ERROR::WAVE_RECORD::DAMAGED_FRAME " << decoded + 1 << std::endl;
+                decoded = UINT64_MAX;
+                return false;
+            }
+
+        const size_t cells = previous.size();
+        if (h.errorBound > 0.0)
+        {
+            const double step = 2.0 * h.errorBound;
+            for (size_t j = 0; j < cells; j++)
+                out[j] = (float)((int32_t)previous[j] * step);
+        }
+        else
+            for (size_t j = 0; j < cells; j++)
+            {
+                uint32_t bits = orderedBits(previous[j]);
+                std::memcpy(&out[j], &bits, 4);
+            }
+        return true;
+    }
+
+private:
+    const uint8_t *base = nullptr;
+    size_t bytes = 0;
+    uint64_t count = 0;
+    std::vector<uint64_t> chunkOffsets;
+
+    // where decoding has got to: 'previous' holds frame 'decoded' as integers, beforeThat the one before
+    std::vector<uint32_t> values, previous, beforeThat;
+    uint64_t decoded = UINT64_MAX;
+    const uint8_t *cursor = nullptr, *chunkEnd = nullptr;
+
+    bool damagedIndex(const char *path)
+    {
+        std::cout << "ERROR::WAVE_RECORD::DAMAGED_INDEX " << path << std::endl;
+        close();
+        return false;
+    }
+
+    bool decodeNext()
+    {
+        using namespace wave_record;
+        if (cursor >= chunkEnd)
+            return false;
+        Prediction prediction = (Prediction)*cursor++;
+        if (prediction > LINEAR)
+            return false;
+        cursor = unpackBlocks(cursor, chunkEnd, values.data(), values.size());
+        if (!cursor)
+            return false;
+        for (size_t j = 0; j < values.size(); j++)
+            values[j] = unzigzag(values[j]) + predict(prediction, values.data(), previous.data(), beforeThat.data(), j);
+        beforeThat.swap(previous);
+        previous.swap(values);
+        decoded++;
+        return true;
+    }
+};
+#endif
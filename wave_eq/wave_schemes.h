@@ -0,0 +1,262 @@
+#ifndef WAVE_SCHEMES_H
+#define WAVE_SCHEMES_H
+
+#include "wave_grid.h"
+#include "fft.h"
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+// Higher order ways of stepping u_tt = c^2 (u_xx + u_yy) on a periodic grid (row -1 is the last row, column -1 the
+// last column), in the same r = c dt / dx units as waveStep.
+//
+// Order4 and Order6 use the 4th and 6th order central differences for the Laplacian (radius 2 and 3 in each direction)
+// and match them in time: u(t + dt) + u(t - dt) = 2 cos(dt c sqrt(-L)) u(t), with the cosine's series taken as far
+// as the order,
+//   next = 2 current - past + r^2 L current + r^4 / 12 L^2 current + r^6 / 360 L^3 current
+// applied one Laplacian at a time Horner fashion. Plain leapfrog (Order2, the 5 point stencil) stops at the first
+// term. The extra terms cost a stencil pass each but let r go further before the scheme goes unstable, see
+// stableCourant().
+//
+// Spectral takes the cosine exactly, mode by mode: next = 2 current - past + IFFT(K FFT(current)) with
+// K = 2 cos(c |k| dt) - 2, through Fft on the rows and then the columns. Every mode the grid can hold then moves at
+// exactly the right speed whatever dt is, so there's no stability limit at all; it costs two 2D FFTs a step and the
+// sides have to be powers of two.
+enum class WaveScheme { Order2, Order4, Order6, Spectral };
+
+inline const char* waveSchemeName(WaveScheme scheme)
+{
+    switch (scheme)
+    {
+    case WaveScheme::Order2: return "order2";
+    case WaveScheme::Order4: return "order4";
+    case WaveScheme::Order6: return "order6";
+    default: return "spectral";
+    }
+}
+
+// by waveSchemeName, false if it's none of them
+inline bool parseWaveScheme(const char *name, WaveScheme &scheme)
+{
+    for (WaveScheme s : { WaveScheme::Order2, WaveScheme::Order4, WaveScheme::Order6, WaveScheme::Spectral })
+        if (std::strcmp(name, waveSchemeName(s)) == 0)
+        {
+            scheme = s;
+            return true;
+        }
+    return false;
+}
+
+// the largest stable r in 2D. The step multiplies a mode the Laplacian scales by -s / r^2 by a truncated
+// 2 cos(sqrt(s)), which has to stay in [-2, 2]: s up to 4 for leapfrog, 12 with the r^4 term, 7.57 with both; s
+// itself is r^2 times 8, 32 / 3 and 544 / 45 at the highest frequency the stencils see
+inline float stableCourant(WaveScheme scheme)
+{
+    switch (scheme)
+    {
+    case WaveScheme::Order2: return 0.7071f;
+    case WaveScheme::Order4: return 1.0606f;
+    case WaveScheme::Order6: return 0.7913f;
+    default: return INFINITY;
+    }
+}
+
+class PeriodicWaveStepper
+{
+public:
+    PeriodicWaveStepper(WaveScheme scheme, int rows, int cols, float r)
+        : scheme(scheme), rows(rows), cols(cols), r(r)
+    {
+        if (scheme == WaveScheme::Spectral)
+        {
+            if (!Fft::isPowerOfTwo(rows) || !Fft::isPowerOfTwo(cols))
+                std::cout << "ERROR::WAVE_SCHEMES::SPECTRAL_NEEDS_POWERS_OF_TWO: " << rows << "x" << cols << std::endl;
+            rowFft.resize(cols);
+            columnFft.resize(rows);
+            spaceSide.resize((size_t)rows * cols);
+            frequencySide.resize((size_t)rows * cols);
+            // K laid out like frequencySide, column frequency major, with the 1 / (rows cols) of the inverse folded in
+            const double pi = 3.14159265358979323846;
+            modeFactor.resize((size_t)rows * cols);
+            for (int kc = 0; kc < cols; kc++)
+                for (int kr = 0; kr < rows; kr++)
+                {
+                    double fc = (kc < cols / 2 ? kc : kc - cols) / (double)cols;
+                    double fr = (kr < rows / 2 ? kr : kr - rows) / (double)rows;
+                    double phase = r * 2.0 * pi * std::sqrt(fc * fc + fr * fr);
+                    modeFactor[(size_t)kc * rows + kr] = (float)((2.0 * std::cos(phase) - 2.0) / ((double)rows * cols));
+                }
+        }
+        else
+        {
+            scratch.reshape(rows, cols);
+            scratch2.reshape(rows, cols);
+            next.reshape(rows, cols);
+        }
+        rowUp.resize(3 * (size_t)rows);
+        rowDown.resize(3 * (size_t)rows);
+        for (int m = 1; m <= 3; m++)
+            for (int i = 0; i < rows; i++)
+            {
+                rowUp[(m - 1) * (size_t)rows + i] = ((i - m) % rows + rows) % rows;
+                rowDown[(m - 1) * (size_t)rows + i] = (i + m) % rows;
+            }
+    }
+
+    // past and current move forward by 'steps' time levels, every cell of them being part of the domain
+    void advance(Grid2D<float> &past, Grid2D<float> &current, int steps)
+    {
+        for (int s = 0; s < steps; s++)
+        {
+            if (scheme == WaveScheme::Spectral)
+                stepSpectral(past, current);
+            else
+                stepStencil(past, current);
+        }
+    }
+
+    // the first step from rest, like waveStartStep: a full step from past = current is current plus the whole cosine
+    // series, the step from rest half of that
+    void startStep(const Grid2D<float> &current, Grid2D<float> &next)
+    {
+        Grid2D<float> past = current;
+        next = current;
+        advance(past, next, 1);
+        for (int i = 0; i < rows; i++)
+            for (int k = 0; k < cols; k++)
+                next[i][k] = 0.5f * (past[i][k] + next[i][k]);
+    }
+
+private:
+    WaveScheme scheme;
+    int rows, cols;
+    float r;
+    Grid2D<float> scratch, scratch2, next;
+    std::vector<int> rowUp, rowDown; // row i - m and i + m wrapped, m - 1 major
+
+    Fft rowFft, columnFft;
+    std::vector<std::complex<float>> spaceSide, frequencySide; // rows x cols, and cols x rows once transformed
+    std::vector<float> modeFactor;
+
+    // out = a * u + b * past + s * L in, the Laplacian L being the 1D stencil w (w[0] the centre, w[m] m cells either
+    // side) along both directions
+    template<int R>
+    void pass(const Grid2D<float> &in, const Grid2D<float> &u, const Grid2D<float> &past, Grid2D<float> &out,
+              float a, float b, float s, const float *w) const
+    {
+        for (int i = 0; i < rows; i++)
+        {
+            const float *up[R], *down[R];
+            for (int m = 0; m < R; m++)
+            {
+                up[m] = in[rowUp[m * (size_t)rows + i]];
+                down[m] = in[rowDown[m * (size_t)rows + i]];
+            }
+            const float *centre = in[i], *ui = u[i], *pi = past[i];
+            float *o = out[i];
+            auto cell = [&](int k, int left[R], int right[R]) {
+                float sum = 2.0f * w[0] * centre[k];
+                for (int m = 0; m < R; m++)
+                    sum += w[m + 1] * (up[m][k] + down[m][k] + centre[left[m]] + centre[right[m]]);
+                o[k] = a * ui[k] + b * pi[k] + s * sum;
+            };
+            int left[R], right[R];
+            for (int k = 0; k < std::min(R, cols); k++)
+            {
+                for (int m = 0; m < R; m++)
+                {
+                    left[m] = ((k - m - 1) % cols + cols) % cols;
+                    right[m] = (k + m + 1) % cols;
+                }
+                cell(k, left, right);
+            }
+            for (int k = R; k < cols - R; k++)
+            {
+                float sum = 2.0f * w[0] * centre[k];
+                for (int m = 0; m < R; m++)
+                    sum += w[m + 1] * (up[m][k] + down[m][k] + centre[k - m - 1] + centre[k + m + 1]);
+                o[k] = a * ui[k] + b * pi[k] + s * sum;
+            }
+            for (int k = std::max(R, cols - R); k < cols; k++)
+            {
+                for (int m = 0; m < R; m++)
+                {
+                    left[m] = ((k - m - 1) % cols + cols) % cols;
+                    right[m] = (k + m + 1) % cols;
+                }
+                cell(k, left, right);
+            }
+        }
+    }
+
+    void stepStencil(Grid2D<float> &past, Grid2D<float> &current)
+    {
+        static const float order2[] = { -2.0f, 1.0f };
+        static const float order4[] = { -5.0f / 2.0f, 4.0f / 3.0f, -1.0f / 12.0f };
+        static const float order6[] = { -49.0f / 18.0f, 3.0f / 2.0f, -3.0f / 20.0f, 1.0f / 90.0f };
+        const float r2 = r * r;
+        // Horner: next = 2 u - past + r^2 L (u + r^2 / 12 L (u + r^2 / 30 L u)), the innermost brackets first
+        switch (scheme)
+        {
+        case WaveScheme::Order2:
+            pass<1>(current, current, past, next, 2.0f, -1.0f, r2, order2);
+            break;
+        case WaveScheme::Order4:
+            pass<2>(current, current, past, scratch, 1.0f, 0.0f, r2 / 12.0f, order4);
+            pass<2>(scratch, current, past, next, 2.0f, -1.0f, r2, order4);
+            break;
+        default:
+            pass<3>(current, current, past, scratch, 1.0f, 0.0f, r2 / 30.0f, order6);
+            pass<3>(scratch, current, past, scratch2, 1.0f, 0.0f, r2 / 12.0f, order6);
+            pass<3>(scratch2, current, past, next, 2.0f, -1.0f, r2, order6);
+            break;
+        }
+        past.swap(current);
+        current.swap(next);
+    }
+
+    void stepSpectral(Grid2D<float> &past, Grid2D<float> &current)
+    {
+        for (int i = 0; i < rows; i++)
+            for (int k = 0; k < cols; k++)
+                spaceSide[(size_t)i * cols + k] = current[i][k];
+        for (int i = 0; i < rows; i++)
+            rowFft.transform(&spaceSide[(size_t)i * cols], false);
+        transpose(spaceSide.data(), frequencySide.data(), rows, cols);
+        for (int kc = 0; kc < cols; kc++)
+            columnFft.transform(&frequencySide[(size_t)kc * rows], false);
+
+        for (size_t j = 0; j < frequencySide.size(); j++)
+            frequencySide[j] *= modeFactor[j];
+
+        for (int kc = 0; kc < cols; kc++)
+            columnFft.transform(&frequencySide[(size_t)kc * rows], true);
+        transpose(frequencySide.data(), spaceSide.data(), cols, rows);
+        for (int i = 0; i < rows; i++)
+        {
+            rowFft.transform(&spaceSide[(size_t)i * cols], true);
+            const std::complex<float> *change = &spaceSide[(size_t)i * cols];
+            float *p = past[i];
+            const float *u = current[i];
+            for (int k = 0; k < cols; k++)
+                p[k] = 2.0f * u[k] - p[k] + change[k].real(); // past becomes next, then the swap
+        }
+        past.swap(current);
+    }
+
+    // to[k][i] = from[i][k] for a rows x cols from, in 16 x 16 blocks so both sides stay in cache
+    static void transpose(const std::complex<float> *from, std::complex<float> *to, int fromRows, int fromCols)
+    {
+        const int B = 16;
+        for (int i0 = 0; i0 < fromRows; i0 += B)
+            for (int k0 = 0; k0 < fromCols; k0 += B)
+                for (int i = i0; i < std::min(fromRows, i0 + B); i++)
+                    for (int k = k0; k < std::min(fromCols, k0 + B); k++)
+                        to[(size_t)k * fromRows + i] = from[(size_t)i * fromCols + k];
+    }
+};
+#endif
@@ -0,0 +1,265 @@
+#ifndef WAVE_SOLVER_H
+#define WAVE_SOLVER_H
+
+#include "wave_grid.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+// Advances the wave grid many steps at a time, split into tiles over a thread pool and temporally blocked: each tile
+// copies itself plus a margin of timeBlock cells into small private grids, takes timeBlock steps there while they sit
+// in cache, and writes back only its own cells. The margin is what the tile's cells depend on over that many steps
+// (the stencil reaches one cell per step), so tiles never wait on each other inside a block; the price is the margin
+// being stepped by both neighbours. Margins are clipped at the edges of the grid, where the zero boundary makes them
+// unnecessary.
+//
+// Every cell goes through the same waveStep arithmetic as stepping the whole grid, so the result is bit for bit the
+// same as calling waveStep 'steps' times.
+//
+// With trackActivity() on, a tile is only stepped if some tile within a block's reach of it has a level above the
+// threshold; the rest are left as they are. Whether a tile is active is worked out from its own cells as it's written
+// back, so it costs nothing extra per step and a pulse on a big grid costs its wavefront rather than the whole domain.
+// At threshold 0 only exact zeros are skipped, which stepping would have left at zero anyway.
+//
+// The edges are held at zero unless setAbsorbingEdges() is called, then every step is followed by waveAbsorbEdges on
+// whichever sides of a tile are edges of the grid.
+//
+// T is what the grids store: float, or Half or BFloat16 to halve the memory and the bytes each step moves, the stencil
+// still adding up in float. WaveSolver is the float one.
+template<class T>
+class BasicWaveSolver
+{
+public:
+    // pool = nullptr runs the tiles on the calling thread. The default tile and its margins are three levels of about
+    // 144 x 1040 floats, 1.8 MB, sized for a 2 MB L2 (half that in 16 bits)
+    BasicWaveSolver(float r2, ThreadPool *pool = nullptr, int timeBlock = 8, int tileRows = 128, int tileCols = 1024)
+        : r2(r2), pool(pool), timeBlock(std::max(1, timeBlock)), tileRows(std::max(1, tileRows)),
+          tileCols(std::max(1, tileCols)) {}
+
+    // past and current move forward by 'steps' time levels
+    void advance(Grid2D<T> &past, Grid2D<T> &current, int steps)
+    {
+        while (steps > 0)
+        {
+            int block = std::min(steps, timeBlock);
+            advanceBlock(past, current, block);
+            steps -= block;
+        }
+    }
+
+    int stepsPerBlock() const { return timeBlock; }
+
+    // from here on step only the tiles near one with |u| > threshold somewhere (see above). The grids are scanned once
+    // on the next advance(); call it again if they're changed some other way in between
+    void trackActivity(float threshold = 0.0f)
+    {
+        sparse = true;
+        activityThreshold = threshold;
+        active.clear();
+    }
+
+    void stepAllTiles() { sparse = false; }
+
+    // r is the Courant number c dt / dx, the square root of the r2 the solver steps with
+    void setAbsorbingEdges(float r)
+    {
+        absorbing = true;
+        courant = r;
+    }
+
+    void setFixedEdges() { absorbing = false; }
+
+    // share of the tiles stepped in the last block
+    double activeFraction() const { return lastTiles ? (double)lastStepped / lastTiles : 1.0; }
+
+private:
+    float r2;
+    ThreadPool *pool;
+    int timeBlock, tileRows, tileCols;
+    Grid2D<T> outPast, outCurrent; // tiles write here so neighbours still read the old levels
+
+    bool absorbing = false;
+    float courant = 0.0f;
+
+    bool sparse = false;
+    float activityThreshold = 0.0f;
+    std::vector<char> active;    // per tile, a level above the threshold after the last block
+    std::vector<char> mirrored;  // per tile, out* already holds the same cells as the levels (it was skipped before)
+    std::vector<int> stepped;    // tiles to step this block
+    size_t lastStepped = 0, lastTiles = 0;
+
+    void advanceBlock(Grid2D<T> &past, Grid2D<T> &current, int block)
+    {
+        const int rows = current.rows(), cols = current.cols();
+        if (outCurrent.rows() != rows || outCurrent.cols() != cols)
+        {
+            outPast.reshape(rows, cols);
+            outCurrent.reshape(rows, cols);
+            active.clear();
+        }
+        const int tilesDown = (rows + tileRows - 1) / tileRows;
+        const int tilesAcross = (cols + tileCols - 1) / tileCols;
+        const size_t tiles = (size_t)tilesDown * tilesAcross;
+
+        stepped.clear();
+        if (!sparse)
+        {
+            for (size_t t = 0; t < tiles; t++)
+                stepped.push_back((int)t);
+        }
+        else
+        {
+            if (active.size() != tiles)
+            {
+                active.assign(tiles, 0);
+                mirrored.assign(tiles, 0);
+                for (size_t t = 0; t < tiles; t++)
+                {
+                    int tr = (int)t / tilesAcross, tc = (int)t % tilesAcross;
+                    active[t] = tileAbove(past, tr, tc) || tileAbove(current, tr, tc);
+                }
+            }
+            // a block moves the wave at most 'block' cells (one more onto an absorbing edge), so that many tiles around
+            // an active one
+            const int reach = block + (absorbing ? 1 : 0);
+            const int reachDown = (reach + tileRows - 1) / tileRows, reachAcross = (reach + tileCols - 1) / tileCols;
+            for (int tr = 0; tr < tilesDown; tr++)
+                for (int tc = 0; tc < tilesAcross; tc++)
+                {
+                    bool near = false;
+                    for (int nr = std::max(0, tr - reachDown); nr <= std::min(tilesDown - 1, tr + reachDown) && !near; nr++)
+                        for (int nc = std::max(0, tc - reachAcross); nc <= std::min(tilesAcross - 1, tc + reachAcross); nc++)
+                            if (active[(size_t)nr * tilesAcross + nc])
+                            {
+                                near = true;
+                                break;
+                            }
+                    size_t t = (size_t)tr * tilesAcross + tc;
+                    if (near)
+                    {
+                        stepped.push_back((int)t);
+                        mirrored[t] = 0;
+                    }
+                    else if (!mirrored[t])
+                    {
+                        // the swap below hands out* back as the levels, so the first time a tile is skipped its cells
+                        // go across once; after that both sides already agree
+                        copyTile(past, outPast, tr, tc);
+                        copyTile(current, outCurrent, tr, tc);
+                        mirrored[t] = 1;
+                    }
+                }
+        }
+
+        auto body = [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; s++)
+            {
+                int t = stepped[s];
+                bool above = stepTile(past, current, t / tilesAcross, t % tilesAcross, block);
+                if (sparse)
+                    active[t] = above;
+            }
+        };
+        if (pool)
+            pool->parallelFor(stepped.size(), 1, body);
+        else
+            body(0, stepped.size());
+        past.swap(outPast);
+        current.swap(outCurrent);
+        lastStepped = stepped.size();
+        lastTiles = tiles;
+    }
+
+    bool tileAbove(const Grid2D<T> &grid, int tileRow, int tileCol) const
+    {
+        const int r0 = tileRow * tileRows, r1 = std::min(grid.rows(), r0 + tileRows);
+        const int c0 = tileCol * tileCols, c1 = std::min(grid.cols(), c0 + tileCols);
+        for (int i = r0; i < r1; i++)
+            for (int k = c0; k < c1; k++)
+                if (std::abs(toFloat(grid[i][k])) > activityThreshold)
+                    return true;
+        return false;
+    }
+
+    void copyTile(const Grid2D<T> &from, Grid2D<T> &to, int tileRow, int tileCol) const
+    {
+        const int r0 = tileRow * tileRows, r1 = std::min(from.rows(), r0 + tileRows);
+        const int c0 = tileCol * tileCols, c1 = std::min(from.cols(), c0 + tileCols);
+        for (int i = r0; i < r1; i++)
+            std::memcpy(to[i] + c0, from[i] + c0, (c1 - c0) * sizeof(T));
+    }
+
+    // returns whether the tile's new levels go above the activity threshold (only looked at when tracking it)
+    bool stepTile(const Grid2D<T> &past, const Grid2D<T> &current, int tileRow, int tileCol, int block)
+    {
+        // one set per worker thread, reshaped in place so steady state allocates nothing
+        thread_local Grid2D<T> localPast, localCurrent, localNext;
+
+        const int rows = current.rows(), cols = current.cols();
+        const int r0 = tileRow * tileRows, r1 = std::min(rows, r0 + tileRows);
+        const int c0 = tileCol * tileCols, c1 = std::min(cols, c0 + tileCols);
+        // an absorbing edge reads the cell next to it at the same time level, one cell more
+        const int margin = block + (absorbing ? 1 : 0);
+        const int lr0 = std::max(0, r0 - margin), lr1 = std::min(rows, r1 + margin);
+        const int lc0 = std::max(0, c0 - margin), lc1 = std::min(cols, c1 + margin);
+        const int localRows = lr1 - lr0, localCols = lc1 - lc0;
+
+        if (localNext.rows() != localRows || localNext.cols() != localCols)
+        {
+            localPast.reshape(localRows, localCols);
+            localCurrent.reshape(localRows, localCols);
+            localNext.reshape(localRows, localCols);
+        }
+        // whatever else is left from the last tile only feeds cells that are thrown away, but an edge row or column on
+        // the grid's boundary is read as zero (the scalar kernel never writes the edge columns)
+        std::fill(localNext[0], localNext[0] + localCols, T());
+        std::fill(localNext[localRows - 1], localNext[localRows - 1] + localCols, T());
+        for (int i = 1; i < localRows - 1; i++)
+        {
+            localNext[i][0] = T();
+            localNext[i][localCols - 1] = T();
+        }
+        for (int i = lr0; i < lr1; i++)
+        {
+            std::memcpy(localPast[i - lr0], past[i] + lc0, localCols * sizeof(T));
+            std::memcpy(localCurrent[i - lr0], current[i] + lc0, localCols * sizeof(T));
+        }
+
+        // after step s only cells at least s from a clipped margin edge are still right, so the rows stepped shrink
+        // by one a step on those sides. Columns are stepped full width; the ones that go stale are never written back
+        const bool openTop = lr0 > 0, openBottom = lr1 < rows;
+        for (int s = 1; s <= block; s++)
+        {
+            int begin = openTop ? s : 1;
+            int end = openBottom ? localRows - s : localRows - 1;
+            waveStep(localPast, localCurrent, localNext, r2, begin, end, lr0, lc0);
+            if (absorbing)
+                waveAbsorbEdges(localCurrent, localNext, courant, begin, end, !openTop, !openBottom, lc0 == 0,
+                                lc1 == cols);
+            localPast.swap(localCurrent);
+            localCurrent.swap(localNext);
+        }
+
+        bool above = false;
+        for (int i = r0; i < r1; i++)
+        {
+            const T *newPast = localPast[i - lr0] + (c0 - lc0), *newCurrent = localCurrent[i - lr0] + (c0 - lc0);
+            std::memcpy(outPast[i] + c0, newPast, (c1 - c0) * sizeof(T));
+            std::memcpy(outCurrent[i] + c0, newCurrent, (c1 - c0) * sizeof(T));
+            if (sparse && !above)
+            {
+                float peak = 0.0f;
+                for (int k = 0; k < c1 - c0; k++)
+                    peak = std::max(peak, std::max(std::abs(toFloat(newPast[k])), std::abs(toFloat(newCurrent[k]))));
+                above = peak > activityThreshold;
+            }
+        }
+        return above;
+    }
+};
+
+typedef BasicWaveSolver<float> WaveSolver;
+#endif
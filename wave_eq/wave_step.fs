@@ -0,0 +1,21 @@
+#version 330 core
+// one leapfrog step of the wave equation per texel, the same update as waveStep in wave_grid.h:
+// next = 2 current - past + r2 (four neighbours - 4 current), with the outer ring held at zero
+layout (location = 0) out float next;
+
+uniform sampler2D past;
+uniform sampler2D current;
+uniform float r2;
+
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(current, 0);
+    if (p.x == 0 || p.y == 0 || p.x == size.x - 1 || p.y == size.y - 1) {
+        next = 0.0;
+        return;
+    }
+    float u = texelFetch(current, p, 0).r;
+    float neighbours = texelFetch(current, p + ivec2(1, 0), 0).r + texelFetch(current, p - ivec2(1, 0), 0).r
+                     + texelFetch(current, p + ivec2(0, 1), 0).r + texelFetch(current, p - ivec2(0, 1), 0).r;
+    next = 2.0 * u - texelFetch(past, p, 0).r + r2 * (neighbours - 4.0 * u);
+}